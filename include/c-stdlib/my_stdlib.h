@@ -1,6 +1,9 @@
 #ifndef C_STDLIB_STDLIB_H_
 #define C_STDLIB_STDLIB_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 float strtof(const char *__restrict, char **__restrict);
 double strtod(const char *__restrict, char **__restrict);
 long double strtold(const char *__restrict, char **__restrict);
@@ -10,4 +13,21 @@ int abs(int);
 void exit(int);
 void abort(void);
 
+// malloc() bumps a pointer from now on, and free() only gives back the blocks on top, see --arena in docs/intro.md.
+void malloc_enable_arena(void);
+int malloc_arena_enabled(void);
+
+// Set the range of the heap, before the first allocation. It's from the end of the binary to 3 MB by default.
+void malloc_config(uintptr_t min, uintptr_t max);
+// The heap is the range given to malloc_config(), malloc() takes memory from it by moving the program break up.
+typedef struct MallocHeapInfo {
+    uintptr_t start;
+    size_t size;
+    size_t used;  // below the program break
+    size_t peak;  // below the highest program break so far
+} MallocHeapInfo;
+void malloc_heap_info(MallocHeapInfo *info);
+// The size of a block that can be used, which is at least the size it was allocated with.
+size_t ckb_malloc_usable_size(const void *p);
+
 #endif /* C_STDLIB_STDLIB_H_ */
@@ -1,9 +1,17 @@
 #define CKB_MALLOC_DECLARATION_ONLY 1
 #include <stdlib.h>
+#include "my_stdlib.h"
 #include <stdio.h>
 #include <stdint.h>
 #include <memory.h>
 
+#ifdef CONFIG_NATIVE
+// there is nothing mapped after _end on the host, see include/native/ckb_native.h
+#include "native/ckb_native.h"
+#define CKB_BRK_MIN ((uintptr_t)ckb_native_heap)
+#define CKB_BRK_MAX ((uintptr_t)ckb_native_heap + CKB_NATIVE_HEAP_SIZE)
+#define CKB_SLAB_MAP_PAGES (CKB_NATIVE_HEAP_SIZE / CKB_PAGE_SIZE)
+#endif
 #ifndef CKB_BRK_MIN
 extern char _end[]; /* _end is set in the linker */
 #define CKB_BRK_MIN ((uintptr_t)&_end)
@@ -40,6 +48,10 @@ struct bin {
 #define CKB_C_INUSE ((size_t)1)
 #define CKB_IS_MMAPPED(c) !((c)->csize & (CKB_C_INUSE))
 #define CKB_PAGE_SIZE 4096
+/* the heap can't be larger than CKB_BRK_MAX on chain */
+#ifndef CKB_SLAB_MAP_PAGES
+#define CKB_SLAB_MAP_PAGES (CKB_BRK_MAX / CKB_PAGE_SIZE)
+#endif
 void __bin_chunk(struct chunk *);
 int ckb_exit(int8_t code);
 static inline void a_crash() { ckb_exit(-1); }
@@ -52,6 +64,8 @@ static inline void a_or_64(volatile uint64_t *p, uint64_t v) { *p |= v; }
 static uintptr_t s_program_break = 0;
 static uintptr_t s_brk_min = CKB_BRK_MIN;
 static uintptr_t s_brk_max = CKB_BRK_MAX;
+/* the highest program break, the break goes down in the arena mode */
+static uintptr_t s_brk_peak = 0;
 
 void malloc_config(uintptr_t min, uintptr_t max) {
     s_brk_min = min;
@@ -70,9 +84,18 @@ void *_sbrk(uintptr_t incr) {
 
     uintptr_t start = s_program_break;
     s_program_break += incr;
+    if (s_program_break > s_brk_peak) s_brk_peak = s_program_break;
     return (void *)start;
 }
 
+void malloc_heap_info(MallocHeapInfo *info) {
+    uintptr_t start = s_brk_min + (-s_brk_min & (CKB_PAGE_SIZE - 1));
+    info->start = start;
+    info->size = s_brk_max - start;
+    info->used = s_program_break ? s_program_break - start : 0;
+    info->peak = s_brk_peak >= start ? s_brk_peak - start : 0;
+}
+
 static struct {
     volatile uint64_t binmap;
     struct bin bins[64];
@@ -85,7 +108,7 @@ static inline void lock_bin(int i) {
 
 static inline void unlock_bin(int i) {}
 
-#if 0
+#ifdef CONFIG_NATIVE
 static int first_set(uint64_t x) {
   // TODO: use RISC-V asm
   static const char debruijn64[64] = {
@@ -238,11 +261,236 @@ static void trim(struct chunk *self, size_t n) {
     unlock_bin(i);
 }
 
+/*
+ * Slabs for the small sizes
+ *
+ * The engine allocates lots of small blocks of a few sizes (JSObject, JSShape,
+ * JSString, JSVarRef...). Up to CKB_SLAB_MAX bytes, sizes are rounded up to a
+ * multiple of CKB_SLAB_ALIGN, and the blocks of every size class are cut from
+ * pages of their own. A block has no header, and allocating or freeing it is
+ * a pop or a push on the free list of its page, without splitting or merging
+ * chunks.
+ *
+ * Pages are taken from _sbrk, CKB_SLAB_BATCH at a time, and are marked in
+ * s_slab.map, which is how free() and realloc() tell slab blocks from chunks.
+ * A page whose blocks are all free goes back to s_slab.free_pages, to be
+ * reused by any class. When no page is left, malloc() falls back to the bins.
+ */
+#define CKB_SLAB_ALIGN 16
+#define CKB_SLAB_MAX 256
+#define CKB_SLAB_CLASSES (CKB_SLAB_MAX / CKB_SLAB_ALIGN)
+#define CKB_SLAB_BATCH 4
+
+struct slab_page {
+    /* in the list of the pages of a class with free blocks, or of the free pages */
+    struct slab_page *next, *prev;
+    void *free;
+    uint32_t used;
+    uint32_t class;
+};
+
+#define CKB_SLAB_HEADER ((sizeof(struct slab_page) + CKB_SLAB_ALIGN - 1) & -CKB_SLAB_ALIGN)
+#define CKB_SLAB_BLOCK_SIZE(i) (((i) + 1) * CKB_SLAB_ALIGN)
+
+static struct {
+    uintptr_t base;
+    uintptr_t reserve, reserve_end;
+    struct slab_page *classes[CKB_SLAB_CLASSES];
+    struct slab_page *free_pages;
+    uint64_t map[(CKB_SLAB_MAP_PAGES + 63) / 64];
+} s_slab;
+
+static inline struct slab_page *slab_page_of(const void *p) {
+    size_t i = ((uintptr_t)p - s_slab.base) / CKB_PAGE_SIZE;
+    if (i >= CKB_SLAB_MAP_PAGES || !(s_slab.map[i / 64] & (1ULL << (i % 64)))) return 0;
+    return (struct slab_page *)((uintptr_t)p & -(uintptr_t)CKB_PAGE_SIZE);
+}
+
+static struct slab_page *slab_new_page(size_t class) {
+    struct slab_page *page = s_slab.free_pages;
+    if (page) {
+        s_slab.free_pages = page->next;
+    } else {
+        if (s_slab.reserve == s_slab.reserve_end) {
+            uintptr_t brk = (uintptr_t)_sbrk(0);
+            size_t n = CKB_SLAB_BATCH;
+            if (!s_slab.base) s_slab.base = brk;
+            /* after a malloc_config(), the heap may be out of the map */
+            if (brk < s_slab.base || (brk - s_slab.base) / CKB_PAGE_SIZE + n > CKB_SLAB_MAP_PAGES) return 0;
+            if (_sbrk(n * CKB_PAGE_SIZE) == (void *)-1) {
+                n = 1;
+                if (_sbrk(CKB_PAGE_SIZE) == (void *)-1) return 0;
+            }
+            s_slab.reserve = brk;
+            s_slab.reserve_end = brk + n * CKB_PAGE_SIZE;
+        }
+        page = (struct slab_page *)s_slab.reserve;
+        s_slab.reserve += CKB_PAGE_SIZE;
+        size_t i = ((uintptr_t)page - s_slab.base) / CKB_PAGE_SIZE;
+        s_slab.map[i / 64] |= 1ULL << (i % 64);
+    }
+
+    size_t size = CKB_SLAB_BLOCK_SIZE(class);
+    char *p = (char *)page + CKB_SLAB_HEADER;
+    size_t count = (CKB_PAGE_SIZE - CKB_SLAB_HEADER) / size;
+    page->free = p;
+    for (; --count; p += size) *(void **)p = p + size;
+    *(void **)p = 0;
+    page->used = 0;
+    page->class = class;
+    page->prev = 0;
+    page->next = 0;
+    s_slab.classes[class] = page;
+    return page;
+}
+
+static void *slab_alloc(size_t n) {
+    size_t class = (n - 1) / CKB_SLAB_ALIGN;
+    struct slab_page *page = s_slab.classes[class];
+    if (!page) {
+        page = slab_new_page(class);
+        if (!page) return 0;
+    }
+    void *p = page->free;
+    page->free = *(void **)p;
+    page->used++;
+    if (!page->free) {
+        /* full pages leave the list */
+        s_slab.classes[class] = page->next;
+        if (page->next) page->next->prev = 0;
+        page->next = 0;
+    }
+    return p;
+}
+
+static void slab_free(struct slab_page *page, void *p) {
+    struct slab_page **head = &s_slab.classes[page->class];
+    if (!page->free) {
+        page->next = *head;
+        page->prev = 0;
+        if (*head) (*head)->prev = page;
+        *head = page;
+    }
+    *(void **)p = page->free;
+    page->free = p;
+    if (--page->used == 0 && (page->prev || page->next)) {
+        /* keep the last page of a class, for a class that is freed and allocated in a loop */
+        if (page->prev)
+            page->prev->next = page->next;
+        else
+            *head = page->next;
+        if (page->next) page->next->prev = page->prev;
+        page->next = s_slab.free_pages;
+        s_slab.free_pages = page;
+    }
+}
+
+/*
+ * Arena mode, see malloc_enable_arena()
+ *
+ * Blocks are bumped from _sbrk, after a header with their size and the block
+ * below them. free() only gives back the blocks at the top of the arena: a
+ * block freed below the top is marked, and popped with the blocks above it.
+ */
+struct arena_block {
+    /* the lowest bit is set once the block is freed */
+    size_t size;
+    struct arena_block *prev;
+};
+
+#define CKB_ARENA_HEADER sizeof(struct arena_block)
+#define CKB_ARENA_BLOCK(p) ((struct arena_block *)((char *)(p)-CKB_ARENA_HEADER))
+
+static struct {
+    uintptr_t start;
+    struct arena_block *top;
+    /* the reserve is used from the first allocation which fails until the arena is back under it */
+    int in_reserve;
+    int exhausted;
+} s_arena;
+
+void malloc_enable_arena(void) {
+    if (!s_arena.start) s_arena.start = (uintptr_t)_sbrk(0);
+}
+
+int malloc_arena_enabled(void) { return s_arena.start != 0; }
+
+static inline int in_arena(const void *p) { return s_arena.start && (uintptr_t)p >= s_arena.start; }
+
+/*
+ * The last 1/32 of the heap is kept in reserve. Freed blocks below the top
+ * aren't given back, so the memory limit of the runtime can't tell when the
+ * arena is full: the allocation reaching the reserve fails instead, and the
+ * out of memory error is then created in the reserve.
+ */
+static inline uintptr_t arena_limit(void) { return s_brk_max - (s_brk_max - s_brk_min) / 32; }
+
+static void *arena_sbrk(size_t n) {
+    if (!s_arena.in_reserve && s_program_break + n > arena_limit()) {
+        s_arena.in_reserve = 1;
+        if (!s_arena.exhausted) {
+            s_arena.exhausted = 1;
+            printf("malloc: the arena is exhausted, run the script without --arena");
+        }
+        return 0;
+    }
+    void *p = _sbrk(n);
+    return p != (void *)-1 ? p : 0;
+}
+
+static inline size_t arena_size(size_t n) {
+    /* a size larger than the heap can't be allocated anyway, and can't overflow once clamped */
+    if (n > s_brk_max - s_brk_min) n = s_brk_max - s_brk_min;
+    return (n + CKB_ARENA_HEADER + CKB_SLAB_ALIGN - 1) & -CKB_SLAB_ALIGN;
+}
+
+static void *arena_alloc(size_t n) {
+    size_t size = arena_size(n);
+    struct arena_block *b = arena_sbrk(size);
+    if (!b) return 0;
+    b->size = size;
+    b->prev = s_arena.top;
+    s_arena.top = b;
+    return (char *)b + CKB_ARENA_HEADER;
+}
+
+static void arena_free(void *p) {
+    CKB_ARENA_BLOCK(p)->size |= 1;
+    while (s_arena.top && (s_arena.top->size & 1)) {
+        s_program_break = (uintptr_t)s_arena.top;
+        s_arena.top = s_arena.top->prev;
+    }
+    if (s_program_break <= arena_limit()) s_arena.in_reserve = 0;
+}
+
+static void *arena_realloc(void *p, size_t n) {
+    struct arena_block *b = CKB_ARENA_BLOCK(p);
+    size_t n0 = b->size - CKB_ARENA_HEADER;
+    if (n <= n0) return p;
+    if (b == s_arena.top) {
+        if (!arena_sbrk(arena_size(n) - b->size)) return 0;
+        b->size = arena_size(n);
+        return p;
+    }
+    void *new = arena_alloc(n);
+    if (!new) return 0;
+    memcpy(new, p, n0);
+    arena_free(p);
+    return new;
+}
+
 void *malloc(size_t n) {
     struct chunk *c;
     int i, j;
     uint64_t mask;
 
+    if (s_arena.start) return arena_alloc(n);
+
+    if (n - 1 < CKB_SLAB_MAX) {
+        void *p = slab_alloc(n);
+        if (p) return p;
+    }
+
     if (adjust_size(&n) < 0) return 0;
 
     if (n >= CKB_MMAP_THRESHOLD) {
@@ -289,6 +537,19 @@ void *realloc(void *p, size_t n) {
 
     if (!p) return malloc(n);
 
+    if (in_arena(p)) return arena_realloc(p, n);
+
+    struct slab_page *page = slab_page_of(p);
+    if (page) {
+        n0 = CKB_SLAB_BLOCK_SIZE(page->class);
+        if (n <= n0) return p;
+        new = malloc(n);
+        if (!new) return 0;
+        memcpy(new, p, n0);
+        slab_free(page, p);
+        return new;
+    }
+
     if (adjust_size(&n) < 0) return 0;
 
     self = CKB_MEM_TO_CHUNK(p);
@@ -382,6 +643,37 @@ void __bin_chunk(struct chunk *self) {
 
 void free(void *p) {
     if (!p) return;
+    if (in_arena(p)) {
+        arena_free(p);
+        return;
+    }
+    struct slab_page *page = slab_page_of(p);
+    if (page) {
+        slab_free(page, p);
+        return;
+    }
     struct chunk *self = CKB_MEM_TO_CHUNK(p);
     __bin_chunk(self);
 }
+
+size_t ckb_malloc_usable_size(const void *p) {
+    if (!p) return 0;
+    if (in_arena(p)) return CKB_ARENA_BLOCK(p)->size - CKB_ARENA_HEADER;
+    struct slab_page *page = slab_page_of(p);
+    if (page) return CKB_SLAB_BLOCK_SIZE(page->class);
+    return CKB_CHUNK_SIZE(CKB_MEM_TO_CHUNK(p)) - CKB_OVERHEAD;
+}
+
+#ifdef CONFIG_NATIVE
+// On chain, these come from impl.c of ckb-c-stdlib, which isn't built for the host. They can't come from the libc of
+// the host either, whose heap is another one.
+void *calloc(size_t m, size_t n) {
+    if (n && m > (size_t)-1 / n) return 0;
+    n *= m;
+    void *p = malloc(n);
+    if (p) memset(p, 0, n);
+    return p;
+}
+
+size_t malloc_usable_size(void *p) { return ckb_malloc_usable_size(p); }
+#endif
@@ -16,6 +16,10 @@ static int s_fs_access_enabled = 0;
 void enable_fs_access(int b) { s_fs_access_enabled = b; }
 int fs_access_enabled() { return s_fs_access_enabled; }
 
+#ifdef CONFIG_NATIVE
+// see include/native/ckb_syscalls.h
+long __internal_syscall(long n, long _a0, long _a1, long _a2, long _a3, long _a4, long _a5);
+#else
 #define memory_barrier() asm volatile("fence" ::: "memory")
 
 static inline long __internal_syscall(long n, long _a0, long _a1, long _a2, long _a3, long _a4, long _a5) {
@@ -41,6 +45,7 @@ static inline long __internal_syscall(long n, long _a0, long _a1, long _a2, long
 
     return a0;
 }
+#endif
 
 #define ckb_syscall(n, a, b, c, d, e, f) \
     __internal_syscall(n, (long)(a), (long)(b), (long)(c), (long)(d), (long)(e), (long)(f))
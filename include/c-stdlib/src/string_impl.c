@@ -257,6 +257,7 @@ char *strstr(const char *h, const char *n) {
     return twoway_strstr((void *)h, (void *)n);
 }
 
+#ifndef CONFIG_NATIVE
 /* Copied from
  * https://github.com/bminor/musl/blob/46d1c7801bb509e1097e8fadbaf359367fa4ef0b/src/setjmp/riscv64/setjmp.S
  */
@@ -325,6 +326,7 @@ __attribute__((naked)) void _longjmp(jmp_buf b, int n) {
         "add a0, a0, a1\n"
         "ret\n");
 }
+#endif
 
 int strcoll(const char *l, const char *r) { return strcmp(l, r); }
 
@@ -455,199 +457,497 @@ char *getenv(const char *name) { return 0; }
 
 int isspace(int c) { return c == ' ' || (unsigned)c - '\t' < 5; }
 
-// Copied from dietlibc
-float strtof(const char *s, char **endptr) {
-    register const char *p = s;
-    register float value = 0.;
-    int sign = +1;
-    float factor;
-    unsigned int expo;
-
-    while (isspace(*p)) p++;
+int atoi(const char *s) {
+    int n = 0, neg = 0;
+    while (isspace(*s)) s++;
+    if (*s == '-' || *s == '+') neg = *s++ == '-';
+    while (*s >= '0' && *s <= '9') n = 10 * n - (*s++ - '0');
+    return neg ? n : -n;
+}
 
-    switch (*p) {
-        case '-':
-            sign = -1; /* fall through */
-        case '+':
-            p++;
-        default:
-            break;
+// Convert char to an int in base `base`,
+// `base` must be 10 or 16, return -1 on error.
+int char2int(char ch, unsigned int base) {
+    if (ch >= '0' && ch <= '9') return ch - '0';
+    if (base == 16) {
+        if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+        if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
     }
+    return -1;
+}
 
-    while ((unsigned int)(*p - '0') < 10u) value = value * 10 + (*p++ - '0');
+// strtod() reads the first 19 significant digits of a decimal number as a 64-bit integer w, and converts
+// w * 10^q with the algorithm of Eisel and Lemire (Daniel Lemire, "Number Parsing at a Gigabyte per Second",
+// 2021), with the 128 most significant bits of 10^q. The rare numbers that it can't round, the ones very close to
+// the middle of two doubles, the ones with more digits that round differently, and the subnormal ones, are
+// converted exactly by shifting a decimal number with up to 800 digits, as in the strconv package of Go. The
+// target has no floating point unit, so everything is done with integers.
+
+#define STRTOD_POW10_MIN (-342)
+#define STRTOD_POW10_MAX 308
+#define STRTOD_POW10_STEP 27
+
+typedef unsigned __int128 strtod_u128;
+
+// 5^i, for i < 27
+static const uint64_t strtod_pow5[27] = {
+    1ULL, 5ULL, 25ULL,
+    125ULL, 625ULL, 3125ULL,
+    15625ULL, 78125ULL, 390625ULL,
+    1953125ULL, 9765625ULL, 48828125ULL,
+    244140625ULL, 1220703125ULL, 6103515625ULL,
+    30517578125ULL, 152587890625ULL, 762939453125ULL,
+    3814697265625ULL, 19073486328125ULL, 95367431640625ULL,
+    476837158203125ULL, 2384185791015625ULL, 11920928955078125ULL,
+    59604644775390625ULL, 298023223876953125ULL, 1490116119384765625ULL,
+};
+// 10^(-342 + 27 * i), the 128 most significant bits rounded up
+static const uint64_t strtod_pow10[25][2] = {
+    {0xeef453d6923bd65aULL, 0x113faa2906a13b40ULL},  // 1e-342
+    {0xc1069cd4eabe89f8ULL, 0x999ec0bb696e840bULL},  // 1e-315
+    {0x9becce62836ac577ULL, 0x4ee367f9430aec33ULL},  // 1e-288
+    {0xfbe9141915d7a922ULL, 0x4bf1ff9f0062baa9ULL},  // 1e-261
+    {0xcb7ddcdda26da268ULL, 0xa9942f5dcf7dfd0aULL},  // 1e-234
+    {0xa46116538d0deb78ULL, 0x52d9be85f074e609ULL},  // 1e-207
+    {0x84c8d4dfd2c63f3bULL, 0x29ecd9f40041e074ULL},  // 1e-180
+    {0xd686619ba27255a2ULL, 0xc80a537b0efefebeULL},  // 1e-153
+    {0xad4ab7112eb3929dULL, 0x86c16c98d2c953c7ULL},  // 1e-126
+    {0x8bfbea76c619ef36ULL, 0x57eb4edb3c55b65bULL},  // 1e-99
+    {0xe2280b6c20dd5232ULL, 0x25c6da63c38de1b1ULL},  // 1e-72
+    {0xb6b00d69bb55c8d1ULL, 0x3d607b97c5fd0d23ULL},  // 1e-45
+    {0x9392ee8e921d5d07ULL, 0x3aff322e62439fd0ULL},  // 1e-18
+    {0xee6b280000000000ULL, 0x0000000000000000ULL},  // 1e9
+    {0xc097ce7bc90715b3ULL, 0x4b9f100000000000ULL},  // 1e36
+    {0x9b934c3b330c8577ULL, 0x63cc55f49f88eb30ULL},  // 1e63
+    {0xfb5878494ace3a5fULL, 0x04ab48a04065c724ULL},  // 1e90
+    {0xcb090c8001ab551cULL, 0x5cadf5bfd3072cc6ULL},  // 1e117
+    {0xa402b9c5a8d3a6e7ULL, 0x5f16206c9c6209a7ULL},  // 1e144
+    {0x847c9b5d7c2e09b7ULL, 0x69956135febada12ULL},  // 1e171
+    {0xd60b3bd56a5586f1ULL, 0x8a71e223d8d3b075ULL},  // 1e198
+    {0xace73cbfdc0bfb7bULL, 0x636cc64d1001550cULL},  // 1e225
+    {0x8bab8eefb6409c1aULL, 0x1ad089b6c2f7548fULL},  // 1e252
+    {0xe1a63853bbd26451ULL, 0x5e7873f8a0396974ULL},  // 1e279
+    {0xb6472e511c81471dULL, 0xe0133fe4adf8e953ULL},  // 1e306
+};
+// What is subtracted from the product of the two tables to get 10^q rounded down, 2 bits per q
+static const uint32_t strtod_pow10_offsets[41] = {
+    0x40000015, 0x40404400, 0x10104014, 0x14501555,
+    0x15114150, 0x15015144, 0x01051440, 0x54400050,
+    0x10044504, 0x00004040, 0x14515550, 0x05555515,
+    0x05104100, 0x51551005, 0x56555595, 0x15554451,
+    0x11114514, 0x54004555, 0x45544145, 0x54540555,
+    0x55556941, 0x11450555, 0x00000000, 0x00000000,
+    0x00000000, 0x11145400, 0x41414455, 0x00000001,
+    0x51400000, 0x15554404, 0x55555144, 0x55544559,
+    0x55145055, 0x01445145, 0x01010000, 0x10414010,
+    0x05400040, 0x69155554, 0x05299559, 0x00000000,
+    0x00050000,
+};
+
+// The 128 most significant bits of 10^q rounded down, for STRTOD_POW10_MIN <= q <= STRTOD_POW10_MAX.
+static void strtod_pow10_128(int q, uint64_t *hi, uint64_t *lo) {
+    int i = q - STRTOD_POW10_MIN;
+    const uint64_t *base = strtod_pow10[i / STRTOD_POW10_STEP];
+    uint64_t m = strtod_pow5[i % STRTOD_POW10_STEP];
+    uint64_t offset = (strtod_pow10_offsets[i / 16] >> ((i % 16) * 2)) & 3;
+    strtod_u128 r;
+    if (m == 1) {
+        r = ((strtod_u128)base[0] << 64) | base[1];
+    } else {
+        // the 128 most significant bits of the 192-bit product
+        strtod_u128 low = (strtod_u128)m * base[1];
+        strtod_u128 high = (strtod_u128)m * base[0] + (uint64_t)(low >> 64);
+        int shift = __builtin_clzll((uint64_t)(high >> 64));
+        r = high << shift;
+        if (shift != 0) r |= (uint64_t)low >> (64 - shift);
+    }
+    r -= offset;
+    *hi = (uint64_t)(r >> 64);
+    *lo = (uint64_t)r;
+}
 
-    if (*p == '.') {
-        factor = 1.;
+// Set *bits to the double closest to w * 10^q, w != 0. Return false if it can't be decided from 128 bits of 10^q,
+// or if the result is subnormal or infinite.
+static bool strtod_eisel_lemire(uint64_t w, int q, uint64_t *bits) {
+    uint64_t pow_hi, pow_lo, x_hi, x_lo, mantissa, msb;
+    strtod_u128 x;
+    int clz, exp2;
+
+    if (q < STRTOD_POW10_MIN || q > STRTOD_POW10_MAX) return false;
+    clz = __builtin_clzll(w);
+    w <<= clz;
+    // floor(log2(10^q)) is (217706 * q) >> 16
+    exp2 = ((217706 * q) >> 16) + 64 + 1023 - clz;
+
+    strtod_pow10_128(q, &pow_hi, &pow_lo);
+    x = (strtod_u128)w * pow_hi;
+    x_hi = (uint64_t)(x >> 64);
+    x_lo = (uint64_t)x;
+    // the low bits of 10^q can only change the result when the 9 bits below the mantissa are all set
+    if ((x_hi & 0x1FF) == 0x1FF && x_lo + w < w) {
+        strtod_u128 y = (strtod_u128)w * pow_lo;
+        uint64_t y_hi = (uint64_t)(y >> 64), y_lo = (uint64_t)y;
+        uint64_t merged_hi = x_hi, merged_lo = x_lo + y_hi;
+        if (merged_lo < x_lo) merged_hi++;
+        if ((merged_hi & 0x1FF) == 0x1FF && merged_lo + 1 == 0 && y_lo + w < w) return false;
+        x_hi = merged_hi;
+        x_lo = merged_lo;
+    }
 
-        p++;
-        while ((unsigned int)(*p - '0') < 10u) {
-            factor *= 0.1;
-            value += (*p++ - '0') * factor;
-        }
+    // 54 bits, then round to 53 bits
+    msb = x_hi >> 63;
+    mantissa = x_hi >> (msb + 9);
+    exp2 -= 1 ^ msb;
+    // maybe exactly in the middle of two doubles
+    if (x_lo == 0 && (x_hi & 0x1FF) == 0 && (mantissa & 3) == 1) return false;
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >> 53) {
+        mantissa >>= 1;
+        exp2++;
     }
+    if (exp2 <= 0 || exp2 >= 0x7FF) return false;
+    *bits = ((uint64_t)exp2 << 52) | (mantissa & ((1ULL << 52) - 1));
+    return true;
+}
 
-    if ((*p | 32) == 'e') {
-        expo = 0;
-        factor = 10.L;
+#define STRTOD_DIGITS_MAX 800
+// The largest shift that can't overflow, with 9 << shift in 64 bits
+#define STRTOD_SHIFT_MAX 60
+
+// 0.d[0]d[1]...d[nd - 1] * 10^dp
+typedef struct {
+    uint8_t d[STRTOD_DIGITS_MAX];
+    int nd;
+    int dp;
+    bool trunc;  // nonzero digits were discarded after d[nd - 1]
+} strtod_decimal;
+
+static void strtod_decimal_trim(strtod_decimal *a) {
+    while (a->nd > 0 && a->d[a->nd - 1] == 0) a->nd--;
+    if (a->nd == 0) a->dp = 0;
+}
 
-        switch (*++p) {  // ja hier weiß ich nicht, was mindestens nach einem
-                         // 'E' folgenden MUSS.
-            case '-':
-                factor = 0.1; /* fall through */
-            case '+':
-                p++;
-                break;
-            case '0':
-            case '1':
-            case '2':
-            case '3':
-            case '4':
-            case '5':
-            case '6':
-            case '7':
-            case '8':
-            case '9':
-                break;
-            default:
-                value = 0.L;
-                p = s;
-                goto done;
+// Read the digits of the number at p, already checked by strtod(), and add exp to its exponent.
+static void strtod_decimal_set(strtod_decimal *a, const char *p, int exp) {
+    bool saw_dot = false;
+    int total = 0;  // significant digits, with the discarded ones
+
+    a->nd = 0;
+    a->dp = 0;
+    a->trunc = false;
+    for (;; p++) {
+        if (*p == '.' && !saw_dot) {
+            saw_dot = true;
+            a->dp = total;
+            continue;
         }
-
-        while ((unsigned int)(*p - '0') < 10u) expo = 10 * expo + (*p++ - '0');
-
-        while (1) {
-            if (expo & 1) value *= factor;
-            if ((expo >>= 1) == 0) break;
-            factor *= factor;
+        if ((unsigned int)(*p - '0') >= 10u) break;
+        if (*p == '0' && total == 0) {
+            if (saw_dot) a->dp--;
+            continue;
         }
+        if (a->nd < STRTOD_DIGITS_MAX)
+            a->d[a->nd++] = *p - '0';
+        else if (*p != '0')
+            a->trunc = true;
+        total++;
     }
+    if (!saw_dot) a->dp = total;
+    a->dp += exp;
+    strtod_decimal_trim(a);
+}
 
-done:
-    if (endptr != NULL) *endptr = (char *)p;
+// Divide by 2^k, k <= STRTOD_SHIFT_MAX.
+static void strtod_decimal_right_shift(strtod_decimal *a, int k) {
+    int r = 0, w = 0;
+    uint64_t n = 0, mask = (1ULL << k) - 1;
+
+    // enough leading digits for the first digit of the result
+    for (; n >> k == 0; r++) {
+        if (r >= a->nd) {
+            if (n == 0) {
+                a->nd = 0;
+                return;
+            }
+            while (n >> k == 0) {
+                n *= 10;
+                r++;
+            }
+            break;
+        }
+        n = n * 10 + a->d[r];
+    }
+    a->dp -= r - 1;
 
-    return value * sign;
+    for (; r < a->nd; r++) {
+        a->d[w++] = n >> k;
+        n = (n & mask) * 10 + a->d[r];
+    }
+    while (n > 0) {
+        uint64_t digit = n >> k;
+        if (w < STRTOD_DIGITS_MAX)
+            a->d[w++] = digit;
+        else if (digit > 0)
+            a->trunc = true;
+        n = (n & mask) * 10;
+    }
+    a->nd = w;
+    strtod_decimal_trim(a);
 }
 
-// Convert char to an int in base `base`,
-// `base` must be 10 or 16, return -1 on error.
-int char2int(char ch, unsigned int base) {
-    if (ch >= '0' && ch <= '9') return ch - '0';
-    if (base == 16) {
-        if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
-        if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+// Multiply by 2^k, k <= STRTOD_SHIFT_MAX.
+static void strtod_decimal_left_shift(strtod_decimal *a, int k) {
+    int r, w, delta = 0;
+    uint64_t n = 0;
+
+    // the number of new digits is the one of the carry out of the first digit
+    for (r = a->nd - 1; r >= 0; r--) n = (n + ((uint64_t)a->d[r] << k)) / 10;
+    for (; n > 0; n /= 10) delta++;
+
+    w = a->nd + delta;
+    for (r = a->nd - 1; r >= 0; r--) {
+        n += (uint64_t)a->d[r] << k;
+        w--;
+        if (w < STRTOD_DIGITS_MAX)
+            a->d[w] = n % 10;
+        else if (n % 10 != 0)
+            a->trunc = true;
+        n /= 10;
     }
-    return -1;
+    while (n > 0) {
+        w--;
+        a->d[w] = n % 10;
+        n /= 10;
+    }
+    a->nd += delta;
+    if (a->nd > STRTOD_DIGITS_MAX) a->nd = STRTOD_DIGITS_MAX;
+    a->dp += delta;
+    strtod_decimal_trim(a);
 }
 
-#define ldbltype long double
-double strtod(const char *s, char **endptr) {
-    register const char *p = s;
-    register ldbltype value = 0.;
-    int sign = +1;
-    unsigned int base = 10;
-    ldbltype base_inverse = (ldbltype)1 / (ldbltype)base;
-    ldbltype factor;
-    unsigned int expo;
-    unsigned int has_digits = 0;
+static void strtod_decimal_shift(strtod_decimal *a, int k) {
+    if (a->nd == 0) return;
+    if (k > 0) {
+        for (; k > STRTOD_SHIFT_MAX; k -= STRTOD_SHIFT_MAX) strtod_decimal_left_shift(a, STRTOD_SHIFT_MAX);
+        strtod_decimal_left_shift(a, k);
+    } else if (k < 0) {
+        for (; k < -STRTOD_SHIFT_MAX; k += STRTOD_SHIFT_MAX) strtod_decimal_right_shift(a, STRTOD_SHIFT_MAX);
+        strtod_decimal_right_shift(a, -k);
+    }
+}
 
-    while (isspace(*p)) p++;
+// The integer part, rounded to nearest, ties to even. a < 2^64.
+static uint64_t strtod_decimal_rounded_integer(strtod_decimal *a) {
+    uint64_t n = 0;
+    int i;
+    bool round_up;
+
+    for (i = 0; i < a->dp && i < a->nd; i++) n = n * 10 + a->d[i];
+    for (; i < a->dp; i++) n *= 10;
+    if (a->dp < 0 || a->dp >= a->nd)
+        round_up = false;
+    else if (a->d[a->dp] == 5 && a->dp + 1 == a->nd)
+        round_up = a->trunc || (a->dp > 0 && (a->d[a->dp - 1] & 1));
+    else
+        round_up = a->d[a->dp] >= 5;
+    return n + round_up;
+}
 
-    switch (*p) {
-        case '-':
-            sign = -1; /* fall through */
-        case '+':
-            p++;
-        case '0':
-            p++;
-            if ((*p | 32) == 'x') {
-                base = 16;
-                base_inverse = (ldbltype)1 / (ldbltype)base;
-                p++;
-            } else {
-                p--;
-            }
-        default:
-            break;
+// The bits of the double closest to a, without its sign.
+static uint64_t strtod_decimal_to_bits(strtod_decimal *a) {
+    // the bits of 10^i, as the shifts that keep the decimal point near the first digit
+    static const uint8_t powtab[] = {1, 3, 6, 9, 13, 16, 19, 23, 26};
+    int exp = 0;
+    uint64_t mantissa;
+
+    if (a->nd == 0 || a->dp < -330) return 0;
+    if (a->dp > 310) return 0x7FFULL << 52;
+
+    // scale by powers of 2 into [0.5, 1)
+    while (a->dp > 0) {
+        int n = a->dp >= (int)sizeof(powtab) ? 27 : powtab[a->dp];
+        strtod_decimal_shift(a, -n);
+        exp += n;
     }
-
-    unsigned int current_value;
-    while ((current_value = char2int(*p, base)) != -1) {
-        p++;
-        value = value * base + current_value;
-        has_digits = 1;
+    while (a->dp < 0 || (a->dp == 0 && a->d[0] < 5)) {
+        int n = -a->dp >= (int)sizeof(powtab) ? 27 : powtab[-a->dp];
+        strtod_decimal_shift(a, n);
+        exp -= n;
     }
+    // [1, 2), 2^exp is the unbiased exponent
+    exp--;
+    if (exp < -1022) {
+        // subnormal
+        strtod_decimal_shift(a, -(-1022 - exp));
+        exp = -1022;
+    }
+    if (exp + 1023 >= 0x7FF) return 0x7FFULL << 52;
+
+    strtod_decimal_shift(a, 53);
+    mantissa = strtod_decimal_rounded_integer(a);
+    if (mantissa == 1ULL << 53) {
+        mantissa >>= 1;
+        exp++;
+        if (exp + 1023 >= 0x7FF) return 0x7FFULL << 52;
+    }
+    if ((mantissa & (1ULL << 52)) == 0) exp = -1023;
+    return ((uint64_t)(exp + 1023) << 52) | (mantissa & ((1ULL << 52) - 1));
+}
 
-    if (*p == '.') {
-        factor = 1.;
-
-        p++;
-        while ((current_value = char2int(*p, base)) != -1) {
-            p++;
-            factor *= base_inverse;
-            value += current_value * factor;
-            has_digits = 1;
-        }
+// The bits of the double closest to m * 2^e2, plus less than 2^e2 if sticky, m != 0.
+static uint64_t strtod_round_bits(uint64_t m, int e2, bool sticky) {
+    int clz = __builtin_clzll(m);
+    int exp, shift = 11;
+    uint64_t mantissa, rem, half;
+
+    m <<= clz;
+    e2 -= clz;
+    exp = e2 + 63 + 1023;
+    if (exp >= 0x7FF) return 0x7FFULL << 52;
+    if (exp <= 0) {
+        // subnormal
+        shift += 1 - exp;
+        exp = 0;
+        if (shift > 64) return 0;
+    }
+    if (shift == 64) {
+        mantissa = 0;
+        rem = m;
+    } else {
+        mantissa = m >> shift;
+        rem = m & ((1ULL << shift) - 1);
     }
+    half = 1ULL << (shift - 1);
+    if (rem > half || (rem == half && (sticky || (mantissa & 1)))) mantissa++;
+    // a carry out of the mantissa increments the exponent
+    return exp == 0 ? mantissa : ((uint64_t)(exp - 1) << 52) + mantissa;
+}
 
-    if ((*p | 32) == 'e' && base == 10) {
-        expo = 0;
-        factor = 10.;
+// Read the hexadecimal digits after 0x, set *bits and return the end, or NULL if there are no digits.
+static const char *strtod_hex(const char *p, uint64_t *bits) {
+    uint64_t m = 0;
+    int e2 = 0, digit;
+    bool sticky = false, has_digits = false, saw_dot = false;
 
-        switch (*++p) {  // ja hier weiß ich nicht, was mindestens nach einem
-                         // 'E' folgenden MUSS.
-            case '-':
-                factor = 0.1; /* fall through */
-            case '+':
-                p++;
-                break;
-            case '0':
-            case '1':
-            case '2':
-            case '3':
-            case '4':
-            case '5':
-            case '6':
-            case '7':
-            case '8':
-            case '9':
-                break;
-            default:
-                value = 0.;
-                p = s;
-                goto done;
+    for (;; p++) {
+        if (*p == '.' && !saw_dot) {
+            saw_dot = true;
+            continue;
+        }
+        if ((digit = char2int(*p, 16)) == -1) break;
+        has_digits = true;
+        if (m >> 60 == 0) {
+            m = m * 16 + digit;
+            if (saw_dot) e2 -= 4;
+        } else {
+            if (!saw_dot) e2 += 4;
+            sticky |= digit != 0;
         }
+    }
+    if (!has_digits) return NULL;
+    // the p exponent is not supported
+    *bits = m == 0 ? 0 : strtod_round_bits(m, e2, sticky);
+    return p;
+}
 
-        while ((unsigned int)(*p - '0') < 10u) expo = 10 * expo + (*p++ - '0');
+double strtod(const char *s, char **endptr) {
+    const char *p = s, *digits;
+    union {
+        double f;
+        uint64_t i;
+    } u;
+    uint64_t w = 0, bits, bits1;
+    int nd = 0, q = 0, exp = 0;
+    bool neg = false, has_digits = false, truncated = false;
 
-        while (1) {
-            if (expo & 1) value *= factor;
-            if ((expo >>= 1) == 0) break;
-            factor *= factor;
+    while (isspace(*p)) p++;
+    if (*p == '-' || *p == '+') neg = *p++ == '-';
+
+    if (p[0] == '0' && (p[1] | 32) == 'x') {
+        const char *end = strtod_hex(p + 2, &bits);
+        if (end) {
+            p = end;
+            has_digits = true;
+            goto done;
         }
     }
 
-    if ((*p | 32) == 'p' && base == 16) {
-        // TODO: add specifier p support
-        // https://cplusplus.com/reference/cstdlib/strtod/
-        //  - A 0x or 0X prefix, then a sequence of hexadecimal digits (as in
-        //  isxdigit) optionally containing a period which separates the whole
-        //  and fractional number parts. Optionally followed by a power of 2
-        //  exponent (a p or P character followed by an optional sign and a
-        //  sequence of hexadecimal digits).
+    // w * 10^q, w has at most 19 digits
+    digits = p;
+    while (*p == '0') {
+        p++;
+        has_digits = true;
     }
-done:
-    if (endptr != NULL) {
-        if (has_digits) {
-            *endptr = (char *)p;
+    for (; (unsigned int)(*p - '0') < 10u; p++) {
+        has_digits = true;
+        if (nd < 19) {
+            w = w * 10 + (*p - '0');
+            nd++;
         } else {
-            *endptr = (char *)s;
+            q++;
+            truncated |= *p != '0';
+        }
+    }
+    if (*p == '.') {
+        const char *dot = p++;
+        if (nd == 0) {
+            for (; *p == '0'; p++) q--;
+        }
+        for (; (unsigned int)(*p - '0') < 10u; p++) {
+            if (nd < 19) {
+                w = w * 10 + (*p - '0');
+                nd++;
+                q--;
+            } else {
+                truncated |= *p != '0';
+            }
+        }
+        if (p > dot + 1) has_digits = true;
+    }
+    if (!has_digits) goto done;
+    if ((*p | 32) == 'e') {
+        const char *e = p + 1;
+        bool exp_neg = false;
+        if (*e == '-' || *e == '+') exp_neg = *e++ == '-';
+        if ((unsigned int)(*e - '0') < 10u) {
+            for (; (unsigned int)(*e - '0') < 10u; e++) {
+                if (exp < 100000) exp = exp * 10 + (*e - '0');
+            }
+            if (exp_neg) exp = -exp;
+            q += exp;
+            p = e;
         }
     }
 
-    return value * sign;
+    if (w == 0) {
+        bits = 0;
+    } else if (!truncated && q == 0 && w <= 1ULL << 53) {
+        // exact integers
+        u.f = (double)w;
+        bits = u.i;
+    } else if (q < STRTOD_POW10_MIN) {
+        // below half of the smallest subnormal, as w < 10^19
+        bits = 0;
+    } else if (q > STRTOD_POW10_MAX) {
+        bits = 0x7FFULL << 52;
+    } else if (!strtod_eisel_lemire(w, q, &bits) ||
+               (truncated && (!strtod_eisel_lemire(w + 1, q, &bits1) || bits1 != bits))) {
+        strtod_decimal d;
+        strtod_decimal_set(&d, digits, exp);
+        bits = strtod_decimal_to_bits(&d);
+    }
+
+done:
+    if (endptr != NULL) *endptr = (char *)(has_digits ? p : s);
+    if (!has_digits) return 0;
+    u.i = bits | ((uint64_t)neg << 63);
+    return u.f;
 }
 
+// The double is rounded again to a float, which rarely differs from the float closest to the number.
+float strtof(const char *s, char **endptr) { return strtod(s, endptr); }
+
 long double strtold(const char *s, char **endptr) {
     register const char *p = s;
     register long double value = 0.L;
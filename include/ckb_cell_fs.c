@@ -6,10 +6,44 @@
 
 static CellFileSystem *CELL_FILE_SYSTEM = NULL;
 
+// FNV-1a hash of a null-terminated file name. At most `max_len` bytes are read, returns -1 if no terminating null
+// byte is found within them.
+static int hash_filename(const char *name, size_t max_len, uint32_t *hash) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < max_len; i++) {
+        if (name[i] == 0) {
+            *hash = h;
+            return 0;
+        }
+        h = (h ^ (uint8_t)name[i]) * 16777619u;
+    }
+    return -1;
+}
+
+static int find_file(const CellFileSystemNode *node, const char *filename, uint32_t hash, FSEntry *entry) {
+    if (node->index == NULL) {
+        return -1;
+    }
+    for (uint32_t slot = hash & node->index_mask;; slot = (slot + 1) & node->index_mask) {
+        uint32_t i = node->index[slot];
+        if (i == 0) {
+            return -1;
+        }
+        *entry = node->files[i - 1];
+        if (strcmp(filename, node->start + entry->filename.offset) == 0) {
+            return 0;
+        }
+    }
+}
+
 int get_file(const CellFileSystem *fs, const char *filename, FSFile **f) {
     if (fs == NULL) {
         return -1;
     }
+    uint32_t hash = 0;
+    if (hash_filename(filename, (size_t)-1, &hash) != 0) {
+        return -1;
+    }
     FSFile *file = malloc(sizeof(FSFile));
     if (file == 0) {
         return -1;
@@ -17,17 +51,14 @@ int get_file(const CellFileSystem *fs, const char *filename, FSFile **f) {
     CellFileSystem *cfs = (CellFileSystem *)fs;
     CellFileSystemNode *node = cfs->current;
     while (node != NULL) {
-        for (uint32_t i = 0; i < node->count; i++) {
-            FSEntry entry = node->files[i];
-            if (strcmp(filename, node->start + entry.filename.offset) == 0) {
-                // TODO: check the memory addresses are legal
-                file->filename = filename;
-                file->size = entry.content.length;
-                file->content = node->start + entry.content.offset;
-                file->rc = 1;
-                *f = file;
-                return 0;
-            }
+        FSEntry entry;
+        if (find_file(node, filename, hash, &entry) == 0) {
+            file->filename = filename;
+            file->size = entry.content.length;
+            file->content = node->start + entry.content.offset;
+            file->rc = 1;
+            *f = file;
+            return 0;
         }
         if (cfs->next == NULL) {
             break;
@@ -41,8 +72,45 @@ int get_file(const CellFileSystem *fs, const char *filename, FSFile **f) {
 
 int ckb_get_file(const char *filename, FSFile **file) { return get_file(CELL_FILE_SYSTEM, filename, file); }
 
+// Build the file name hash table of a node, with at least twice as many slots as files. When a name appears more
+// than once, the first entry is kept, as the linear scan used to do.
+static int build_index(CellFileSystemNode *node, uint64_t payload_len) {
+    uint32_t size = 2;
+    while (size < node->count * 2) {
+        size *= 2;
+    }
+    node->index = (uint32_t *)malloc(sizeof(uint32_t) * size);
+    if (node->index == NULL) {
+        return -1;
+    }
+    memset(node->index, 0, sizeof(uint32_t) * size);
+    node->index_mask = size - 1;
+
+    for (uint32_t i = 0; i < node->count; i++) {
+        FSEntry entry = node->files[i];
+        if (entry.filename.offset >= payload_len || entry.content.offset > payload_len ||
+            entry.content.length > payload_len - entry.content.offset) {
+            return -1;
+        }
+        const char *name = node->start + entry.filename.offset;
+        uint32_t hash = 0;
+        if (hash_filename(name, payload_len - entry.filename.offset, &hash) != 0) {
+            return -1;
+        }
+        uint32_t slot = hash & node->index_mask;
+        while (node->index[slot] != 0 &&
+               strcmp(name, node->start + node->files[node->index[slot] - 1].filename.offset) != 0) {
+            slot = (slot + 1) & node->index_mask;
+        }
+        if (node->index[slot] == 0) {
+            node->index[slot] = i + 1;
+        }
+    }
+    return 0;
+}
+
 int load_fs(CellFileSystem **fs, void *buf, uint64_t buflen) {
-    if (fs == NULL || buf == NULL) {
+    if (fs == NULL || buf == NULL || buflen < sizeof(uint32_t)) {
         return -1;
     }
 
@@ -58,6 +126,8 @@ int load_fs(CellFileSystem **fs, void *buf, uint64_t buflen) {
     }
 
     node->count = *(uint32_t *)buf;
+    node->index = NULL;
+    node->index_mask = 0;
     if (node->count == 0) {
         node->files = NULL;
         node->start = NULL;
@@ -67,13 +137,20 @@ int load_fs(CellFileSystem **fs, void *buf, uint64_t buflen) {
         return 0;
     }
 
+    uint64_t header_len = sizeof(node->count) + (uint64_t)sizeof(FSEntry) * node->count;
+    if (header_len > buflen) {
+        free(node);
+        free(newfs);
+        return -1;
+    }
+
     node->files = (FSEntry *)malloc(sizeof(FSEntry) * node->count);
     if (node->files == NULL) {
         free(node);
         free(newfs);
         return -1;
     }
-    node->start = buf + sizeof(node->count) + (sizeof(FSEntry) * node->count);
+    node->start = buf + header_len;
 
     FSEntry *entries = (FSEntry *)((char *)buf + sizeof(node->count));
     for (uint32_t i = 0; i < node->count; i++) {
@@ -81,6 +158,14 @@ int load_fs(CellFileSystem **fs, void *buf, uint64_t buflen) {
         node->files[i] = entry;
     }
 
+    if (build_index(node, buflen - header_len) != 0) {
+        free(node->index);
+        free(node->files);
+        free(node);
+        free(newfs);
+        return -1;
+    }
+
     newfs->next = *fs;
     newfs->current = node;
     *fs = newfs;
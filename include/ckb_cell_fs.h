@@ -15,6 +15,10 @@ typedef struct CellFileSystemNode {
     uint32_t count;
     FSEntry *files;
     void *start;
+    // Hash table of the file names built by load_fs, using open addressing.
+    // Each slot holds a file index plus one, or 0 when it is empty.
+    uint32_t *index;
+    uint32_t index_mask;
 } CellFileSystemNode;
 
 typedef struct CellFileSystem {
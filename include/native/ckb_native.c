@@ -0,0 +1,506 @@
+// The syscalls of the native build, see docs/native.md.
+//
+// The VM and the libc of include/c-stdlib are linked into a single object whose symbols are all local, except for
+// its main() and what it needs from here: the syscalls of ckb_syscall_apis.h and ckb_native.h. This file is built
+// against the libc of the host, and answers the syscalls from a ckb-debugger mock transaction (CKB_TX_FILE).
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ckb_consts.h"
+#include "ckb_native.h"
+#include "ckb_syscall_apis.h"
+#include "mock_tx.h"
+
+// 32 + 1 bytes for the code hash and the hash type of a script, 8 bytes for the capacity of a cell
+#define SCRIPT_FIXED_SIZE 33
+#define CAPACITY_SIZE 8
+#define SHANNONS_PER_BYTE 100000000ull
+
+#define HEADER_NUMBER_OFFSET 16
+#define HEADER_EPOCH_OFFSET 24
+
+char ckb_native_heap[CKB_NATIVE_HEAP_SIZE] __attribute__((aligned(4096)));
+
+int ckb_js_vm_main(int argc, const char **argv);
+
+typedef struct ScriptGroup {
+    bool is_type;
+    MockBytes script;
+    uint8_t script_hash[32];
+    size_t *inputs;
+    size_t input_count;
+    size_t *outputs;
+    size_t output_count;
+} ScriptGroup;
+
+static MockTx s_tx;
+static ScriptGroup s_group;
+static bool s_loaded = false;
+static int s_output_fd = -1;
+static struct timespec s_start_time;
+
+static void fatal(const char *message, const char *arg) {
+    fprintf(stderr, "ckb-js-vm: %s%s\n", message, arg);
+    exit(-1);
+}
+
+static char *read_file(const char *path, size_t *len) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    size_t size = 0;
+    size_t capacity = 64 * 1024;
+    char *buf = malloc(capacity);
+    for (;;) {
+        if (buf == NULL) break;
+        if (size == capacity) {
+            capacity *= 2;
+            char *new_buf = realloc(buf, capacity);
+            if (new_buf == NULL) {
+                free(buf);
+                buf = NULL;
+                break;
+            }
+            buf = new_buf;
+        }
+        ssize_t n = read(fd, buf + size, capacity - size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            free(buf);
+            buf = NULL;
+            break;
+        }
+        if (n == 0) break;
+        size += n;
+    }
+    close(fd);
+    *len = size;
+    return buf;
+}
+
+static size_t env_index(const char *name) {
+    const char *value = getenv(name);
+    if (value == NULL || *value == 0) return 0;
+    char *end;
+    unsigned long long index = strtoull(value, &end, 10);
+    if (*end != 0) fatal("invalid ", name);
+    return (size_t)index;
+}
+
+// The script group of the script being run, chosen with CKB_SCRIPT_GROUP_TYPE, CKB_CELL_TYPE and CKB_CELL_INDEX
+static void load_script_group(void) {
+    const char *group_type = getenv("CKB_SCRIPT_GROUP_TYPE");
+    const char *cell_type = getenv("CKB_CELL_TYPE");
+    size_t index = env_index("CKB_CELL_INDEX");
+    MockCell *cells = s_tx.inputs;
+    size_t count = s_tx.input_count;
+
+    if (group_type == NULL || strcmp(group_type, "lock") == 0) {
+        s_group.is_type = false;
+    } else if (strcmp(group_type, "type") == 0) {
+        s_group.is_type = true;
+    } else {
+        fatal("invalid CKB_SCRIPT_GROUP_TYPE: ", group_type);
+    }
+    if (cell_type != NULL && strcmp(cell_type, "output") == 0) {
+        if (!s_group.is_type) fatal("lock scripts are only run for inputs", "");
+        cells = s_tx.outputs;
+        count = s_tx.output_count;
+    } else if (cell_type != NULL && strcmp(cell_type, "input") != 0) {
+        fatal("invalid CKB_CELL_TYPE: ", cell_type);
+    }
+    if (count == 0) return;
+    if (index >= count) fatal("CKB_CELL_INDEX out of bound", "");
+    MockCell *cell = &cells[index];
+    if (s_group.is_type) {
+        if (cell->type.size == 0) fatal("the cell has no type script", "");
+        s_group.script = cell->type;
+        memcpy(s_group.script_hash, cell->type_hash, 32);
+    } else {
+        s_group.script = cell->lock;
+        memcpy(s_group.script_hash, cell->lock_hash, 32);
+    }
+
+    s_group.inputs = mock_alloc(s_tx.input_count * sizeof(size_t));
+    for (size_t i = 0; i < s_tx.input_count; i++) {
+        MockCell *c = &s_tx.inputs[i];
+        bool in_group = s_group.is_type ? c->type.size > 0 && memcmp(c->type_hash, s_group.script_hash, 32) == 0
+                                        : memcmp(c->lock_hash, s_group.script_hash, 32) == 0;
+        if (in_group) s_group.inputs[s_group.input_count++] = i;
+    }
+    // the lock scripts of the outputs are not run
+    s_group.outputs = mock_alloc(s_tx.output_count * sizeof(size_t));
+    for (size_t i = 0; s_group.is_type && i < s_tx.output_count; i++) {
+        MockCell *c = &s_tx.outputs[i];
+        if (c->type.size > 0 && memcmp(c->type_hash, s_group.script_hash, 32) == 0) {
+            s_group.outputs[s_group.output_count++] = i;
+        }
+    }
+}
+
+// The mock transaction is loaded on the first syscall that needs it. Without CKB_TX_FILE, the transaction is empty.
+static MockTx *get_tx(void) {
+    if (s_loaded) return &s_tx;
+    s_loaded = true;
+    const char *path = getenv("CKB_TX_FILE");
+    if (path == NULL || *path == 0) return &s_tx;
+    size_t len;
+    char *json = read_file(path, &len);
+    if (json == NULL) fatal("can't read CKB_TX_FILE ", path);
+    const char *error;
+    if (mock_tx_load(&s_tx, json, len, &error) < 0) fatal("invalid CKB_TX_FILE: ", error);
+    free(json);
+    load_script_group();
+    return &s_tx;
+}
+
+// Partial loading as in CKB: up to *len bytes from `offset` are copied and *len is set to the size from `offset`. The
+// VM reads the size first with a NULL address.
+static int load_data(void *addr, uint64_t *len, size_t offset, const void *data, size_t size) {
+    if (offset > size) offset = size;
+    uint64_t full = size - offset;
+    if (addr != NULL) memcpy(addr, (const uint8_t *)data + offset, full < *len ? full : *len);
+    *len = full;
+    return CKB_SUCCESS;
+}
+
+// The index of an item of the transaction from the index of a syscall, or -1 if it's out of bound
+static int64_t item_index(size_t index, size_t source, size_t count, bool is_output) {
+    size_t i = index;
+    if (source == CKB_SOURCE_GROUP_INPUT || source == CKB_SOURCE_GROUP_OUTPUT) {
+        bool group_output = source == CKB_SOURCE_GROUP_OUTPUT;
+        if (group_output != is_output) return -1;
+        if (index >= (group_output ? s_group.output_count : s_group.input_count)) return -1;
+        i = group_output ? s_group.outputs[index] : s_group.inputs[index];
+    }
+    return i < count ? (int64_t)i : -1;
+}
+
+static MockCell *get_cell(size_t index, size_t source) {
+    MockTx *tx = get_tx();
+    int64_t i;
+    switch (source) {
+        case CKB_SOURCE_INPUT:
+        case CKB_SOURCE_GROUP_INPUT:
+            i = item_index(index, source, tx->input_count, false);
+            return i < 0 ? NULL : &tx->inputs[i];
+        case CKB_SOURCE_OUTPUT:
+        case CKB_SOURCE_GROUP_OUTPUT:
+            i = item_index(index, source, tx->output_count, true);
+            return i < 0 ? NULL : &tx->outputs[i];
+        case CKB_SOURCE_CELL_DEP:
+            return index < tx->cell_dep_count ? &tx->cell_deps[index] : NULL;
+        default:
+            return NULL;
+    }
+}
+
+static void u64_to_le(uint64_t v, uint8_t *p) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint64_t le_to_u64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+// The size of the args of a serialized Script, the last field of the table
+static size_t script_args_size(const MockBytes *script) {
+    if (script->size == 0) return 0;
+    uint32_t args_offset = (uint32_t)script->ptr[12] | (uint32_t)script->ptr[13] << 8 |
+                           (uint32_t)script->ptr[14] << 16 | (uint32_t)script->ptr[15] << 24;
+    return script->size - args_offset - 4;
+}
+
+int ckb_exit(int8_t code) {
+    exit(code);
+    return CKB_SUCCESS;
+}
+
+int ckb_debug(const char *s) {
+    size_t len = strlen(s);
+    char *line = malloc(len + 1);
+    if (line == NULL) return CKB_SUCCESS;
+    memcpy(line, s, len);
+    line[len] = '\n';
+    // one write for each line, so that the lines aren't split when the output is shared with another process
+    for (size_t done = 0; done < len + 1;) {
+        ssize_t n = write(STDOUT_FILENO, line + done, len + 1 - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        done += n;
+    }
+    free(line);
+    return CKB_SUCCESS;
+}
+
+int ckb_load_tx_hash(void *addr, uint64_t *len, size_t offset) {
+    return load_data(addr, len, offset, get_tx()->tx_hash, 32);
+}
+
+int ckb_load_transaction(void *addr, uint64_t *len, size_t offset) {
+    MockTx *tx = get_tx();
+    return load_data(addr, len, offset, tx->transaction.ptr, tx->transaction.size);
+}
+
+int ckb_load_script_hash(void *addr, uint64_t *len, size_t offset) {
+    get_tx();
+    if (s_group.script.size == 0) return CKB_ITEM_MISSING;
+    return load_data(addr, len, offset, s_group.script_hash, 32);
+}
+
+int ckb_load_script(void *addr, uint64_t *len, size_t offset) {
+    get_tx();
+    if (s_group.script.size == 0) return CKB_ITEM_MISSING;
+    return load_data(addr, len, offset, s_group.script.ptr, s_group.script.size);
+}
+
+int ckb_load_cell(void *addr, uint64_t *len, size_t offset, size_t index, size_t source) {
+    MockCell *cell = get_cell(index, source);
+    if (cell == NULL) return CKB_INDEX_OUT_OF_BOUND;
+    return load_data(addr, len, offset, cell->output.ptr, cell->output.size);
+}
+
+int ckb_load_input(void *addr, uint64_t *len, size_t offset, size_t index, size_t source) {
+    if (source != CKB_SOURCE_INPUT && source != CKB_SOURCE_GROUP_INPUT) return CKB_INDEX_OUT_OF_BOUND;
+    MockCell *cell = get_cell(index, source);
+    if (cell == NULL) return CKB_INDEX_OUT_OF_BOUND;
+    return load_data(addr, len, offset, cell->input.ptr, cell->input.size);
+}
+
+static const MockBytes *get_header(size_t index, size_t source) {
+    MockTx *tx = get_tx();
+    if (source == CKB_SOURCE_HEADER_DEP) return index < tx->header_dep_count ? &tx->header_deps[index] : NULL;
+    if (source == CKB_SOURCE_OUTPUT || source == CKB_SOURCE_GROUP_OUTPUT) return NULL;
+    MockCell *cell = get_cell(index, source);
+    return cell == NULL ? NULL : &cell->header;
+}
+
+int ckb_load_header(void *addr, uint64_t *len, size_t offset, size_t index, size_t source) {
+    const MockBytes *header = get_header(index, source);
+    if (header == NULL) return CKB_INDEX_OUT_OF_BOUND;
+    if (header->size == 0) return CKB_ITEM_MISSING;
+    return load_data(addr, len, offset, header->ptr, header->size);
+}
+
+int ckb_load_witness(void *addr, uint64_t *len, size_t offset, size_t index, size_t source) {
+    MockTx *tx = get_tx();
+    int64_t i;
+    switch (source) {
+        case CKB_SOURCE_INPUT:
+        case CKB_SOURCE_OUTPUT:
+            i = index < tx->witness_count ? (int64_t)index : -1;
+            break;
+        case CKB_SOURCE_GROUP_INPUT:
+        case CKB_SOURCE_GROUP_OUTPUT:
+            i = item_index(index, source, tx->witness_count, source == CKB_SOURCE_GROUP_OUTPUT);
+            break;
+        default:
+            i = -1;
+    }
+    if (i < 0) return CKB_INDEX_OUT_OF_BOUND;
+    return load_data(addr, len, offset, tx->witnesses[i].ptr, tx->witnesses[i].size);
+}
+
+int ckb_load_cell_data(void *addr, uint64_t *len, size_t offset, size_t index, size_t source) {
+    MockCell *cell = get_cell(index, source);
+    if (cell == NULL) return CKB_INDEX_OUT_OF_BOUND;
+    return load_data(addr, len, offset, cell->data.ptr, cell->data.size);
+}
+
+int ckb_checked_load_cell_data(void *addr, uint64_t *len, size_t offset, size_t index, size_t source) {
+    uint64_t old_len = *len;
+    int ret = ckb_load_cell_data(addr, len, offset, index, source);
+    if (ret == CKB_SUCCESS && *len > old_len) return CKB_LENGTH_NOT_ENOUGH;
+    return ret;
+}
+
+int ckb_load_cell_by_field(void *addr, uint64_t *len, size_t offset, size_t index, size_t source, size_t field) {
+    MockCell *cell = get_cell(index, source);
+    uint8_t buf[8];
+    if (cell == NULL) return CKB_INDEX_OUT_OF_BOUND;
+    switch (field) {
+        case CKB_CELL_FIELD_CAPACITY:
+            u64_to_le(cell->capacity, buf);
+            return load_data(addr, len, offset, buf, 8);
+        case CKB_CELL_FIELD_DATA_HASH:
+            return load_data(addr, len, offset, cell->data_hash, 32);
+        case CKB_CELL_FIELD_LOCK:
+            return load_data(addr, len, offset, cell->lock.ptr, cell->lock.size);
+        case CKB_CELL_FIELD_LOCK_HASH:
+            return load_data(addr, len, offset, cell->lock_hash, 32);
+        case CKB_CELL_FIELD_TYPE:
+            if (cell->type.size == 0) return CKB_ITEM_MISSING;
+            return load_data(addr, len, offset, cell->type.ptr, cell->type.size);
+        case CKB_CELL_FIELD_TYPE_HASH:
+            if (cell->type.size == 0) return CKB_ITEM_MISSING;
+            return load_data(addr, len, offset, cell->type_hash, 32);
+        case CKB_CELL_FIELD_OCCUPIED_CAPACITY: {
+            uint64_t size = CAPACITY_SIZE + cell->data.size + SCRIPT_FIXED_SIZE + script_args_size(&cell->lock);
+            if (cell->type.size > 0) size += SCRIPT_FIXED_SIZE + script_args_size(&cell->type);
+            u64_to_le(size * SHANNONS_PER_BYTE, buf);
+            return load_data(addr, len, offset, buf, 8);
+        }
+        default:
+            return CKB_ITEM_MISSING;
+    }
+}
+
+int ckb_load_header_by_field(void *addr, uint64_t *len, size_t offset, size_t index, size_t source, size_t field) {
+    const MockBytes *header = get_header(index, source);
+    uint8_t buf[8];
+    if (header == NULL) return CKB_INDEX_OUT_OF_BOUND;
+    if (header->size == 0) return CKB_ITEM_MISSING;
+    // the epoch is the number in its lower 24 bits, then the index in 16 bits and the length in 16 bits
+    uint64_t number = le_to_u64(header->ptr + HEADER_NUMBER_OFFSET);
+    uint64_t epoch = le_to_u64(header->ptr + HEADER_EPOCH_OFFSET);
+    switch (field) {
+        case CKB_HEADER_FIELD_EPOCH_NUMBER:
+            u64_to_le(epoch & 0xffffff, buf);
+            break;
+        case CKB_HEADER_FIELD_EPOCH_START_BLOCK_NUMBER:
+            u64_to_le(number - ((epoch >> 24) & 0xffff), buf);
+            break;
+        case CKB_HEADER_FIELD_EPOCH_LENGTH:
+            u64_to_le((epoch >> 40) & 0xffff, buf);
+            break;
+        default:
+            return CKB_ITEM_MISSING;
+    }
+    return load_data(addr, len, offset, buf, 8);
+}
+
+int ckb_load_input_by_field(void *addr, uint64_t *len, size_t offset, size_t index, size_t source, size_t field) {
+    if (source != CKB_SOURCE_INPUT && source != CKB_SOURCE_GROUP_INPUT) return CKB_INDEX_OUT_OF_BOUND;
+    MockCell *cell = get_cell(index, source);
+    if (cell == NULL) return CKB_INDEX_OUT_OF_BOUND;
+    // CellInput is the since and then the out point
+    switch (field) {
+        case CKB_INPUT_FIELD_OUT_POINT:
+            return load_data(addr, len, offset, cell->input.ptr + 8, cell->input.size - 8);
+        case CKB_INPUT_FIELD_SINCE:
+            return load_data(addr, len, offset, cell->input.ptr, 8);
+        default:
+            return CKB_ITEM_MISSING;
+    }
+}
+
+int ckb_look_for_dep_with_hash2(const uint8_t *code_hash, uint8_t hash_type, size_t *index) {
+    size_t field = hash_type == 1 ? CKB_CELL_FIELD_TYPE_HASH : CKB_CELL_FIELD_DATA_HASH;
+    for (size_t i = 0;; i++) {
+        uint8_t hash[32];
+        uint64_t len = 32;
+        int ret = ckb_load_cell_by_field(hash, &len, 0, i, CKB_SOURCE_CELL_DEP, field);
+        if (ret == CKB_ITEM_MISSING) continue;
+        if (ret != CKB_SUCCESS) return ret;
+        if (len == 32 && memcmp(code_hash, hash, 32) == 0) {
+            *index = i;
+            return CKB_SUCCESS;
+        }
+    }
+}
+
+int ckb_vm_version() { return 2; }
+
+// Nanoseconds instead of cycles, e.g. for ckb.current_cycles() and the profiler.
+uint64_t ckb_current_cycles() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)(now.tv_sec - s_start_time.tv_sec) * 1000000000ull + now.tv_nsec - s_start_time.tv_nsec;
+}
+
+int ckb_exec_cell(const uint8_t *code_hash, uint8_t hash_type, uint32_t offset, uint32_t length, int argc,
+                  const char *argv[]) {
+    fatal("exec is not supported by the native build", "");
+    return CKB_INVALID_DATA;
+}
+
+int ckb_spawn_cell(const uint8_t *code_hash, uint8_t hash_type, uint32_t offset, uint32_t length, int argc,
+                   const char *argv[], spawn_args_t *spgs) {
+    ckb_debug("spawn is not supported by the native build");
+    return CKB_INVALID_DATA;
+}
+
+int ckb_set_content(uint8_t *content, uint64_t *length) { return CKB_SUCCESS; }
+
+int ckb_get_memory_limit() { return 8; }
+
+int ckb_current_memory() { return 8; }
+
+// There is no RISC-V code to run, so ckb.dlopen() fails
+int ckb_load_cell_data_as_code(void *addr, size_t memory_size, size_t content_offset, size_t content_size,
+                               size_t index, size_t source) {
+    return CKB_INVALID_DATA;
+}
+
+// The syscalls of ckb-debugger for the local files: the file of `-r` and `-c` (--read-file), read from
+// CKB_READ_FILE, and the ones of stdio_impl.c, with the FILE of the host as the stream.
+long __internal_syscall(long n, long _a0, long _a1, long _a2, long _a3, long _a4, long _a5) {
+    switch (n) {
+        case 9000: {
+            const char *path = getenv("CKB_READ_FILE");
+            if (path == NULL || *path == 0) fatal("CKB_READ_FILE is not set", "");
+            size_t len;
+            char *data = read_file(path, &len);
+            if (data == NULL) fatal("can't read CKB_READ_FILE ", path);
+            if (len > (size_t)_a1) len = (size_t)_a1;
+            memcpy((void *)_a0, data, len);
+            free(data);
+            return (long)len;
+        }
+        case 9003:
+            return (long)fopen((const char *)_a0, (const char *)_a1);
+        case 9004:
+            return (long)freopen((const char *)_a0, (const char *)_a1, (FILE *)_a2);
+        case 9005:
+            return (long)fread((void *)_a0, (size_t)_a1, (size_t)_a2, (FILE *)_a3);
+        case 9006:
+            return feof((FILE *)_a0);
+        case 9007:
+            return ferror((FILE *)_a0);
+        case 9008:
+            return fgetc((FILE *)_a0);
+        case 9009:
+            return fclose((FILE *)_a0);
+        case 9010:
+            return ftell((FILE *)_a0);
+        case 9011:
+            return fseek((FILE *)_a0, _a1, (int)_a2);
+        default: {
+            char number[32];
+            snprintf(number, sizeof(number), "%ld", n);
+            fatal("unsupported syscall ", number);
+            return -1;
+        }
+    }
+}
+
+// The output of printf_() of printf_impl.c, unused by the VM
+void _putchar(char character) { fputc(character, stdout); }
+
+int ckb_native_set_output(const char *path) {
+    s_output_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    return s_output_fd < 0 ? -1 : 0;
+}
+
+void ckb_native_write_output(const void *buf, size_t len) {
+    for (size_t done = 0; done < len;) {
+        ssize_t n = write(s_output_fd, (const uint8_t *)buf + done, len - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) fatal("can't write the output: ", strerror(errno));
+        done += n;
+    }
+}
+
+// CKB doesn't pass the name of the program in argv
+int main(int argc, const char **argv) {
+    clock_gettime(CLOCK_MONOTONIC, &s_start_time);
+    return ckb_js_vm_main(argc - 1, argv + 1);
+}
@@ -0,0 +1,18 @@
+#ifndef _CKB_NATIVE_H_
+#define _CKB_NATIVE_H_
+
+// Only for the native build (CONFIG_NATIVE), see docs/native.md.
+
+#include <stddef.h>
+
+// The heap of malloc_impl.c: there is no memory to grow into after `_end` on the host. On chain, the heap goes from
+// the end of the binary to 3 MB.
+#define CKB_NATIVE_HEAP_SIZE (3 * 1024 * 1024)
+extern char ckb_native_heap[];
+
+// Write the output of `-c` as binary to `path` instead of in hexadecimal to the debug output. Return 0 on success.
+int ckb_native_set_output(const char *path);
+// Exit on errors.
+void ckb_native_write_output(const void *buf, size_t len);
+
+#endif  // _CKB_NATIVE_H_
@@ -0,0 +1,19 @@
+#ifndef CKB_C_STDLIB_CKB_SYSCALLS_H_
+#define CKB_C_STDLIB_CKB_SYSCALLS_H_
+
+// Replaces deps/ckb-c-stdlib/ckb_syscalls.h in the native build, where the syscalls can't use the RISC-V `ecall`
+// instruction and are implemented by ckb_native.c instead, see docs/native.md. It is included before any other
+// header with `-include`, and has the same include guard so that the one of ckb-c-stdlib is always skipped.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ckb_consts.h"
+#include "ckb_syscall_apis.h"
+
+long __internal_syscall(long n, long _a0, long _a1, long _a2, long _a3, long _a4, long _a5);
+
+#define syscall(n, a, b, c, d, e, f) \
+    __internal_syscall(n, (long)(a), (long)(b), (long)(c), (long)(d), (long)(e), (long)(f))
+
+#endif  // CKB_C_STDLIB_CKB_SYSCALLS_H_
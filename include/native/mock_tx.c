@@ -0,0 +1,701 @@
+// Mock transactions of the native build, see mock_tx.h and docs/native.md.
+//
+// The JSON is the --tx-file format of ckb-debugger:
+//     {"mock_info": {"inputs": [{"input", "output", "data", "header"}],
+//                    "cell_deps": [{"cell_dep", "output", "data", "header"}],
+//                    "header_deps": [header]},
+//      "tx": {"version", "cell_deps", "header_deps", "inputs", "outputs", "outputs_data", "witnesses"}}
+// The inputs and the cell deps of "tx" are looked up in "mock_info" by out point, or by index when no out point
+// matches. Without inputs or cell deps in "tx", the ones of "mock_info" are used. Dep groups are not expanded.
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "blake2b.h"
+#include "mock_tx.h"
+
+#define CKB_HASH_PERSONALIZATION "ckb-default-hash"
+#define JSON_MAX_DEPTH 64
+
+#define OUT_POINT_SIZE 36
+#define CELL_INPUT_SIZE 44
+#define CELL_DEP_SIZE 37
+#define HEADER_SIZE 208
+
+static char s_error[256];
+
+static int mock_fail(const char *format, const char *name) {
+    snprintf(s_error, sizeof(s_error), format, name);
+    return -1;
+}
+
+void *mock_alloc(size_t size) {
+    void *p = malloc(size == 0 ? 1 : size);
+    if (p == NULL) {
+        fprintf(stderr, "ckb-js-vm: out of memory\n");
+        abort();
+    }
+    return p;
+}
+
+void mock_ckbhash(const uint8_t *data, size_t len, uint8_t hash[32]) {
+    blake2b_state state;
+    blake2b_param param;
+    memset(&param, 0, sizeof(param));
+    memcpy(param.personal, CKB_HASH_PERSONALIZATION, sizeof(param.personal));
+    param.digest_length = 32;
+    param.fanout = 1;
+    param.depth = 1;
+    blake2b_init_param(&state, &param);
+    blake2b_update(&state, data, len);
+    blake2b_final(&state, hash, 32);
+}
+
+// A JSON parser for the mock transactions, where all the values are objects, arrays, strings or null.
+
+typedef enum {
+    JSON_NULL,
+    JSON_BOOL,
+    JSON_NUMBER,
+    JSON_STRING,
+    JSON_ARRAY,
+    JSON_OBJECT,
+} JsonType;
+
+typedef struct JsonValue {
+    JsonType type;
+    // The unescaped string, or the text of a number or a boolean, null terminated for the strings only
+    const char *str;
+    // The number of items of an array or an object, or the length of str
+    size_t len;
+    struct JsonValue *items;
+    // The names of the members of an object
+    const char **names;
+} JsonValue;
+
+typedef struct JsonParser {
+    const char *start;
+    const char *p;
+    const char *end;
+} JsonParser;
+
+static int json_fail(JsonParser *s, const char *error) {
+    snprintf(s_error, sizeof(s_error), "invalid JSON at byte %d: %s", (int)(s->p - s->start), error);
+    return -1;
+}
+
+static void json_skip_space(JsonParser *s) {
+    while (s->p < s->end && (*s->p == ' ' || *s->p == '\t' || *s->p == '\n' || *s->p == '\r')) s->p++;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static int json_parse_string(JsonParser *s, const char **str, size_t *len) {
+    const char *begin = ++s->p;
+    const char *q = begin;
+    while (q < s->end && *q != '"') {
+        if (*q == '\\') q++;
+        q++;
+    }
+    if (q >= s->end) return json_fail(s, "unterminated string");
+    char *out = mock_alloc(q - begin + 1);
+    size_t n = 0;
+    for (const char *r = begin; r < q; r++) {
+        char c = *r;
+        if (c == '\\') {
+            s->p = r;
+            switch (*++r) {
+                case '"':
+                case '\\':
+                case '/':
+                    c = *r;
+                    break;
+                case 'b':
+                    c = '\b';
+                    break;
+                case 'f':
+                    c = '\f';
+                    break;
+                case 'n':
+                    c = '\n';
+                    break;
+                case 'r':
+                    c = '\r';
+                    break;
+                case 't':
+                    c = '\t';
+                    break;
+                case 'u': {
+                    // only ASCII characters, there are no others in a mock transaction
+                    int code = 0;
+                    for (int i = 1; i <= 4; i++) {
+                        int d = r + i < q ? hex_value(r[i]) : -1;
+                        if (d < 0) return json_fail(s, "invalid escape");
+                        code = code * 16 + d;
+                    }
+                    if (code == 0 || code > 0x7f) return json_fail(s, "unsupported escape");
+                    c = (char)code;
+                    r += 4;
+                    break;
+                }
+                default:
+                    return json_fail(s, "invalid escape");
+            }
+        }
+        out[n++] = c;
+    }
+    out[n] = 0;
+    *str = out;
+    *len = n;
+    s->p = q + 1;
+    return 0;
+}
+
+static int json_parse_value(JsonParser *s, JsonValue *v, int depth);
+
+static int json_parse_container(JsonParser *s, JsonValue *v, int depth) {
+    bool is_object = *s->p == '{';
+    char close = is_object ? '}' : ']';
+    size_t count = 0;
+    size_t capacity = 0;
+    JsonValue *items = NULL;
+    const char **names = NULL;
+
+    v->type = is_object ? JSON_OBJECT : JSON_ARRAY;
+    s->p++;
+    json_skip_space(s);
+    if (s->p < s->end && *s->p == close) {
+        s->p++;
+        return 0;
+    }
+    for (;;) {
+        if (count == capacity) {
+            // the old arrays are not freed, see mock_alloc()
+            capacity = capacity == 0 ? 8 : capacity * 2;
+            JsonValue *new_items = mock_alloc(capacity * sizeof(JsonValue));
+            memcpy(new_items, items, count * sizeof(JsonValue));
+            items = new_items;
+            if (is_object) {
+                const char **new_names = mock_alloc(capacity * sizeof(char *));
+                memcpy(new_names, names, count * sizeof(char *));
+                names = new_names;
+            }
+        }
+        if (is_object) {
+            size_t len;
+            json_skip_space(s);
+            if (s->p >= s->end || *s->p != '"') return json_fail(s, "expected a member name");
+            if (json_parse_string(s, &names[count], &len) < 0) return -1;
+            json_skip_space(s);
+            if (s->p >= s->end || *s->p != ':') return json_fail(s, "expected ':'");
+            s->p++;
+        }
+        if (json_parse_value(s, &items[count], depth + 1) < 0) return -1;
+        count++;
+        json_skip_space(s);
+        if (s->p < s->end && *s->p == ',') {
+            s->p++;
+        } else if (s->p < s->end && *s->p == close) {
+            s->p++;
+            break;
+        } else {
+            return json_fail(s, is_object ? "expected ',' or '}'" : "expected ',' or ']'");
+        }
+    }
+    v->items = items;
+    v->names = names;
+    v->len = count;
+    return 0;
+}
+
+static int json_parse_value(JsonParser *s, JsonValue *v, int depth) {
+    memset(v, 0, sizeof(*v));
+    json_skip_space(s);
+    if (s->p >= s->end) return json_fail(s, "unexpected end");
+    if (depth > JSON_MAX_DEPTH) return json_fail(s, "too many nested values");
+    if (*s->p == '"') {
+        v->type = JSON_STRING;
+        return json_parse_string(s, &v->str, &v->len);
+    }
+    if (*s->p == '[' || *s->p == '{') return json_parse_container(s, v, depth);
+
+    const char *token = s->p;
+    while (s->p < s->end && ((*s->p >= 'a' && *s->p <= 'z') || (*s->p >= '0' && *s->p <= '9') || *s->p == '-' ||
+                             *s->p == '+' || *s->p == '.' || *s->p == 'E')) {
+        s->p++;
+    }
+    v->str = token;
+    v->len = s->p - token;
+    if (v->len == 4 && memcmp(token, "null", 4) == 0) {
+        v->type = JSON_NULL;
+    } else if ((v->len == 4 && memcmp(token, "true", 4) == 0) || (v->len == 5 && memcmp(token, "false", 5) == 0)) {
+        v->type = JSON_BOOL;
+    } else if (v->len > 0 && (*token == '-' || (*token >= '0' && *token <= '9'))) {
+        v->type = JSON_NUMBER;
+    } else {
+        s->p = token;
+        return json_fail(s, "unexpected character");
+    }
+    return 0;
+}
+
+static const JsonValue *json_get(const JsonValue *v, const char *name) {
+    if (v == NULL || v->type != JSON_OBJECT) return NULL;
+    for (size_t i = 0; i < v->len; i++) {
+        if (strcmp(v->names[i], name) == 0) return &v->items[i];
+    }
+    return NULL;
+}
+
+static bool json_is_null(const JsonValue *v) { return v == NULL || v->type == JSON_NULL; }
+
+static bool json_is_string(const JsonValue *v, const char *str) {
+    return v != NULL && v->type == JSON_STRING && strcmp(v->str, str) == 0;
+}
+
+// The number of items of an array, which may be missing or null
+static int json_array_length(const JsonValue *v, const char *name, size_t *count) {
+    *count = 0;
+    if (json_is_null(v)) return 0;
+    if (v->type != JSON_ARRAY) return mock_fail("\"%s\" is not an array", name);
+    *count = v->len;
+    return 0;
+}
+
+// "0x" followed by the bytes in hexadecimal
+static int parse_bytes(const JsonValue *v, const char *name, MockBytes *out) {
+    if (v == NULL || v->type != JSON_STRING || v->len < 2 || v->str[0] != '0' || v->str[1] != 'x' || v->len % 2 != 0) {
+        return mock_fail("invalid \"%s\"", name);
+    }
+    size_t size = (v->len - 2) / 2;
+    uint8_t *p = mock_alloc(size);
+    for (size_t i = 0; i < size; i++) {
+        int hi = hex_value(v->str[2 + i * 2]);
+        int lo = hex_value(v->str[3 + i * 2]);
+        if (hi < 0 || lo < 0) return mock_fail("invalid \"%s\"", name);
+        p[i] = (uint8_t)(hi * 16 + lo);
+    }
+    out->ptr = p;
+    out->size = size;
+    return 0;
+}
+
+// Optional bytes, empty when missing or null
+static int parse_optional_bytes(const JsonValue *v, const char *name, MockBytes *out) {
+    if (json_is_null(v)) {
+        out->ptr = mock_alloc(0);
+        out->size = 0;
+        return 0;
+    }
+    return parse_bytes(v, name, out);
+}
+
+static int parse_fixed_bytes(const JsonValue *v, const char *name, uint8_t *out, size_t size) {
+    MockBytes bytes;
+    if (parse_bytes(v, name, &bytes) < 0) return -1;
+    if (bytes.size != size) return mock_fail("invalid \"%s\"", name);
+    memcpy(out, bytes.ptr, size);
+    return 0;
+}
+
+// A number of `size` bytes such as "0x1f", written in little endian into `out`
+static int parse_number(const JsonValue *v, const char *name, uint8_t *out, size_t size) {
+    if (v == NULL || v->type != JSON_STRING || v->len < 3 || v->str[0] != '0' || v->str[1] != 'x') {
+        return mock_fail("invalid \"%s\"", name);
+    }
+    size_t digits = v->len - 2;
+    while (digits > size * 2 && v->str[v->len - digits] == '0') digits--;
+    if (digits > size * 2) return mock_fail("\"%s\" is too large", name);
+    memset(out, 0, size);
+    for (size_t i = 0; i < digits; i++) {
+        int d = hex_value(v->str[v->len - 1 - i]);
+        if (d < 0) return mock_fail("invalid \"%s\"", name);
+        out[i / 2] |= (uint8_t)(d << (4 * (i % 2)));
+    }
+    return 0;
+}
+
+static uint64_t read_u64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+static void write_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+// Molecule serialization. The tables and the dynvecs have the same layout: the total size and the offset of each
+// item, then the items.
+
+static MockBytes mol_dynvec(const MockBytes *items, size_t count) {
+    size_t header_size = 4 * (count + 1);
+    size_t total = header_size;
+    for (size_t i = 0; i < count; i++) total += items[i].size;
+    MockBytes ret = {mock_alloc(total), total};
+    write_u32(ret.ptr, (uint32_t)total);
+    size_t offset = header_size;
+    for (size_t i = 0; i < count; i++) {
+        write_u32(ret.ptr + 4 * (i + 1), (uint32_t)offset);
+        memcpy(ret.ptr + offset, items[i].ptr, items[i].size);
+        offset += items[i].size;
+    }
+    return ret;
+}
+
+// A fixvec of items of the same size
+static MockBytes mol_fixvec(const MockBytes *items, size_t count) {
+    size_t total = 4;
+    for (size_t i = 0; i < count; i++) total += items[i].size;
+    MockBytes ret = {mock_alloc(total), total};
+    write_u32(ret.ptr, (uint32_t)count);
+    size_t offset = 4;
+    for (size_t i = 0; i < count; i++) {
+        memcpy(ret.ptr + offset, items[i].ptr, items[i].size);
+        offset += items[i].size;
+    }
+    return ret;
+}
+
+// Bytes, the fixvec of bytes
+static MockBytes mol_bytes(MockBytes data) {
+    MockBytes ret = {mock_alloc(4 + data.size), 4 + data.size};
+    write_u32(ret.ptr, (uint32_t)data.size);
+    memcpy(ret.ptr + 4, data.ptr, data.size);
+    return ret;
+}
+
+static int load_script(const JsonValue *v, const char *name, MockBytes *script) {
+    uint8_t *code_hash = mock_alloc(32);
+    uint8_t *hash_type = mock_alloc(1);
+    MockBytes args;
+
+    if (v == NULL || v->type != JSON_OBJECT) return mock_fail("invalid \"%s\"", name);
+    if (parse_fixed_bytes(json_get(v, "code_hash"), "code_hash", code_hash, 32) < 0) return -1;
+    const JsonValue *t = json_get(v, "hash_type");
+    if (json_is_string(t, "data")) {
+        *hash_type = 0;
+    } else if (json_is_string(t, "type")) {
+        *hash_type = 1;
+    } else if (json_is_string(t, "data1")) {
+        *hash_type = 2;
+    } else if (json_is_string(t, "data2")) {
+        *hash_type = 4;
+    } else {
+        return mock_fail("invalid \"%s\"", "hash_type");
+    }
+    if (parse_bytes(json_get(v, "args"), "args", &args) < 0) return -1;
+    MockBytes fields[3] = {{code_hash, 32}, {hash_type, 1}, mol_bytes(args)};
+    *script = mol_dynvec(fields, 3);
+    return 0;
+}
+
+static int load_cell_output(const JsonValue *v, MockCell *cell) {
+    uint8_t *capacity = mock_alloc(8);
+
+    if (v == NULL || v->type != JSON_OBJECT) return mock_fail("invalid \"%s\"", "output");
+    if (parse_number(json_get(v, "capacity"), "capacity", capacity, 8) < 0) return -1;
+    cell->capacity = read_u64(capacity);
+    if (load_script(json_get(v, "lock"), "lock", &cell->lock) < 0) return -1;
+    mock_ckbhash(cell->lock.ptr, cell->lock.size, cell->lock_hash);
+    const JsonValue *type = json_get(v, "type");
+    if (json_is_null(type)) {
+        cell->type.ptr = mock_alloc(0);
+        cell->type.size = 0;
+    } else {
+        if (load_script(type, "type", &cell->type) < 0) return -1;
+        mock_ckbhash(cell->type.ptr, cell->type.size, cell->type_hash);
+    }
+    MockBytes fields[3] = {{capacity, 8}, cell->lock, cell->type};
+    cell->output = mol_dynvec(fields, 3);
+    return 0;
+}
+
+static void set_cell_data(MockCell *cell, MockBytes data) {
+    cell->data = data;
+    // as in CKB, the data hash of a cell without data is zero
+    if (data.size > 0) {
+        mock_ckbhash(data.ptr, data.size, cell->data_hash);
+    } else {
+        memset(cell->data_hash, 0, 32);
+    }
+}
+
+static int load_out_point(const JsonValue *v, uint8_t *out) {
+    if (v == NULL || v->type != JSON_OBJECT) return mock_fail("invalid \"%s\"", "out_point");
+    if (parse_fixed_bytes(json_get(v, "tx_hash"), "tx_hash", out, 32) < 0) return -1;
+    return parse_number(json_get(v, "index"), "index", out + 32, 4);
+}
+
+static int load_cell_input(const JsonValue *v, MockBytes *input) {
+    input->ptr = mock_alloc(CELL_INPUT_SIZE);
+    input->size = CELL_INPUT_SIZE;
+    memset(input->ptr, 0, CELL_INPUT_SIZE);
+    if (json_is_null(v)) return 0;
+    if (parse_number(json_get(v, "since"), "since", input->ptr, 8) < 0) return -1;
+    return load_out_point(json_get(v, "previous_output"), input->ptr + 8);
+}
+
+static int load_cell_dep(const JsonValue *v, MockBytes *dep) {
+    dep->ptr = mock_alloc(CELL_DEP_SIZE);
+    dep->size = CELL_DEP_SIZE;
+    memset(dep->ptr, 0, CELL_DEP_SIZE);
+    if (json_is_null(v)) return 0;
+    if (load_out_point(json_get(v, "out_point"), dep->ptr) < 0) return -1;
+    const JsonValue *dep_type = json_get(v, "dep_type");
+    if (json_is_string(dep_type, "code")) {
+        dep->ptr[OUT_POINT_SIZE] = 0;
+    } else if (json_is_string(dep_type, "dep_group")) {
+        dep->ptr[OUT_POINT_SIZE] = 1;
+    } else {
+        return mock_fail("invalid \"%s\"", "dep_type");
+    }
+    return 0;
+}
+
+static int load_header(const JsonValue *v, MockBytes *header, uint8_t *hash) {
+    static const struct {
+        const char *name;
+        uint8_t offset;
+        uint8_t size;
+        bool is_number;
+    } fields[] = {
+        {"version", 0, 4, true},           {"compact_target", 4, 4, true},    {"timestamp", 8, 8, true},
+        {"number", 16, 8, true},           {"epoch", 24, 8, true},            {"parent_hash", 32, 32, false},
+        {"transactions_root", 64, 32, false}, {"proposals_hash", 96, 32, false}, {"extra_hash", 128, 32, false},
+        {"dao", 160, 32, false},           {"nonce", 192, 16, true},
+    };
+
+    if (v == NULL || v->type != JSON_OBJECT) return mock_fail("invalid \"%s\"", "header_deps");
+    header->ptr = mock_alloc(HEADER_SIZE);
+    header->size = HEADER_SIZE;
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        const JsonValue *field = json_get(v, fields[i].name);
+        uint8_t *p = header->ptr + fields[i].offset;
+        int err = fields[i].is_number ? parse_number(field, fields[i].name, p, fields[i].size)
+                                      : parse_fixed_bytes(field, fields[i].name, p, fields[i].size);
+        if (err < 0) return err;
+    }
+    const JsonValue *h = json_get(v, "hash");
+    if (json_is_null(h)) {
+        mock_ckbhash(header->ptr, header->size, hash);
+        return 0;
+    }
+    return parse_fixed_bytes(h, "hash", hash, 32);
+}
+
+typedef struct MockHeaders {
+    MockBytes *headers;
+    uint8_t (*hashes)[32];
+    size_t count;
+} MockHeaders;
+
+static int find_header(const MockHeaders *headers, const JsonValue *hash, MockBytes *header) {
+    uint8_t h[32];
+    if (parse_fixed_bytes(hash, "header", h, 32) < 0) return -1;
+    for (size_t i = 0; i < headers->count; i++) {
+        if (memcmp(headers->hashes[i], h, 32) == 0) {
+            *header = headers->headers[i];
+            return 0;
+        }
+    }
+    return mock_fail("header %s is not in mock_info.header_deps", hash->str);
+}
+
+// The entry of "mock_info" of an input or a cell dep: the one with the same out point, else the one at `index`
+static const JsonValue *find_mock_entry(const JsonValue *entries, const char *name, const char *out_point_name,
+                                        const uint8_t *out_point, size_t index) {
+    size_t count = json_is_null(entries) || entries->type != JSON_ARRAY ? 0 : entries->len;
+    for (size_t i = 0; i < count; i++) {
+        const JsonValue *v = json_get(json_get(&entries->items[i], name), out_point_name);
+        uint8_t p[OUT_POINT_SIZE];
+        if (v != NULL && load_out_point(v, p) == 0 && memcmp(p, out_point, OUT_POINT_SIZE) == 0) {
+            return &entries->items[i];
+        }
+    }
+    return index < count ? &entries->items[index] : NULL;
+}
+
+// The cell of an input or a cell dep of "mock_info"
+static int load_mock_cell(const JsonValue *entry, const MockHeaders *headers, MockCell *cell) {
+    if (load_cell_output(json_get(entry, "output"), cell) < 0) return -1;
+    MockBytes data;
+    if (parse_optional_bytes(json_get(entry, "data"), "data", &data) < 0) return -1;
+    set_cell_data(cell, data);
+    const JsonValue *header = json_get(entry, "header");
+    if (json_is_null(header)) {
+        cell->header.ptr = mock_alloc(0);
+        cell->header.size = 0;
+        return 0;
+    }
+    return find_header(headers, header, &cell->header);
+}
+
+static int load_inputs(MockTx *tx, const JsonValue *raw, const JsonValue *mock, const MockHeaders *headers) {
+    const JsonValue *inputs = json_get(raw, "inputs");
+    const JsonValue *mock_inputs = json_get(mock, "inputs");
+    bool from_mock = json_is_null(inputs);
+    size_t mock_count;
+
+    if (json_array_length(mock_inputs, "inputs", &mock_count) < 0) return -1;
+    if (json_array_length(from_mock ? mock_inputs : inputs, "inputs", &tx->input_count) < 0) return -1;
+    tx->inputs = mock_alloc(tx->input_count * sizeof(MockCell));
+    for (size_t i = 0; i < tx->input_count; i++) {
+        MockCell *cell = &tx->inputs[i];
+        const JsonValue *input = from_mock ? json_get(&mock_inputs->items[i], "input") : &inputs->items[i];
+        memset(cell, 0, sizeof(*cell));
+        if (load_cell_input(input, &cell->input) < 0) return -1;
+        const JsonValue *entry = find_mock_entry(mock_inputs, "input", "previous_output", cell->input.ptr + 8, i);
+        if (entry == NULL) return mock_fail("%s", "an input is not in mock_info.inputs");
+        if (load_mock_cell(entry, headers, cell) < 0) return -1;
+    }
+    return 0;
+}
+
+static int load_cell_deps(MockTx *tx, const JsonValue *raw, const JsonValue *mock, const MockHeaders *headers,
+                          MockBytes **deps) {
+    const JsonValue *cell_deps = json_get(raw, "cell_deps");
+    const JsonValue *mock_deps = json_get(mock, "cell_deps");
+    bool from_mock = json_is_null(cell_deps);
+    size_t mock_count;
+
+    if (json_array_length(mock_deps, "cell_deps", &mock_count) < 0) return -1;
+    if (json_array_length(from_mock ? mock_deps : cell_deps, "cell_deps", &tx->cell_dep_count) < 0) return -1;
+    tx->cell_deps = mock_alloc(tx->cell_dep_count * sizeof(MockCell));
+    *deps = mock_alloc(tx->cell_dep_count * sizeof(MockBytes));
+    for (size_t i = 0; i < tx->cell_dep_count; i++) {
+        MockCell *cell = &tx->cell_deps[i];
+        const JsonValue *dep = from_mock ? json_get(&mock_deps->items[i], "cell_dep") : &cell_deps->items[i];
+        memset(cell, 0, sizeof(*cell));
+        if (load_cell_dep(dep, &(*deps)[i]) < 0) return -1;
+        const JsonValue *entry = find_mock_entry(mock_deps, "cell_dep", "out_point", (*deps)[i].ptr, i);
+        if (entry == NULL) return mock_fail("%s", "a cell dep is not in mock_info.cell_deps");
+        if (load_mock_cell(entry, headers, cell) < 0) return -1;
+    }
+    return 0;
+}
+
+static int load_outputs(MockTx *tx, const JsonValue *raw) {
+    const JsonValue *outputs = json_get(raw, "outputs");
+    const JsonValue *outputs_data = json_get(raw, "outputs_data");
+    size_t data_count;
+
+    if (json_array_length(outputs, "outputs", &tx->output_count) < 0) return -1;
+    if (json_array_length(outputs_data, "outputs_data", &data_count) < 0) return -1;
+    tx->outputs = mock_alloc(tx->output_count * sizeof(MockCell));
+    for (size_t i = 0; i < tx->output_count; i++) {
+        MockCell *cell = &tx->outputs[i];
+        MockBytes data;
+        memset(cell, 0, sizeof(*cell));
+        if (load_cell_output(&outputs->items[i], cell) < 0) return -1;
+        if (parse_optional_bytes(i < data_count ? &outputs_data->items[i] : NULL, "outputs_data", &data) < 0) {
+            return -1;
+        }
+        set_cell_data(cell, data);
+        cell->input.ptr = cell->header.ptr = mock_alloc(0);
+    }
+    return 0;
+}
+
+static int load_tx(MockTx *tx, const JsonValue *root) {
+    const JsonValue *mock = json_get(root, "mock_info");
+    const JsonValue *raw = json_get(root, "tx");
+    const JsonValue *mock_headers = json_get(mock, "header_deps");
+    const JsonValue *header_deps = json_get(raw, "header_deps");
+    const JsonValue *witnesses = json_get(raw, "witnesses");
+    MockHeaders headers;
+    MockBytes *deps;
+    uint8_t *version = mock_alloc(4);
+
+    if (mock == NULL || raw == NULL) return mock_fail("%s", "no \"mock_info\" or \"tx\"");
+    // the headers first, the cells refer to them by hash
+    if (json_array_length(mock_headers, "header_deps", &headers.count) < 0) return -1;
+    headers.headers = mock_alloc(headers.count * sizeof(MockBytes));
+    headers.hashes = mock_alloc(headers.count * 32);
+    for (size_t i = 0; i < headers.count; i++) {
+        if (load_header(&mock_headers->items[i], &headers.headers[i], headers.hashes[i]) < 0) return -1;
+    }
+
+    if (load_inputs(tx, raw, mock, &headers) < 0) return -1;
+    if (load_cell_deps(tx, raw, mock, &headers, &deps) < 0) return -1;
+    if (load_outputs(tx, raw) < 0) return -1;
+
+    MockBytes *header_hashes;
+    if (json_is_null(header_deps)) {
+        tx->header_dep_count = headers.count;
+        tx->header_deps = headers.headers;
+        header_hashes = mock_alloc(headers.count * sizeof(MockBytes));
+        for (size_t i = 0; i < headers.count; i++) {
+            header_hashes[i].ptr = headers.hashes[i];
+            header_hashes[i].size = 32;
+        }
+    } else {
+        if (json_array_length(header_deps, "header_deps", &tx->header_dep_count) < 0) return -1;
+        tx->header_deps = mock_alloc(tx->header_dep_count * sizeof(MockBytes));
+        header_hashes = mock_alloc(tx->header_dep_count * sizeof(MockBytes));
+        for (size_t i = 0; i < tx->header_dep_count; i++) {
+            header_hashes[i].ptr = mock_alloc(32);
+            header_hashes[i].size = 32;
+            if (parse_fixed_bytes(&header_deps->items[i], "header_deps", header_hashes[i].ptr, 32) < 0) return -1;
+            if (find_header(&headers, &header_deps->items[i], &tx->header_deps[i]) < 0) return -1;
+        }
+    }
+
+    if (json_array_length(witnesses, "witnesses", &tx->witness_count) < 0) return -1;
+    tx->witnesses = mock_alloc(tx->witness_count * sizeof(MockBytes));
+    for (size_t i = 0; i < tx->witness_count; i++) {
+        if (parse_bytes(&witnesses->items[i], "witnesses", &tx->witnesses[i]) < 0) return -1;
+    }
+
+    const JsonValue *v = json_get(raw, "version");
+    memset(version, 0, 4);
+    if (!json_is_null(v) && parse_number(v, "version", version, 4) < 0) return -1;
+
+    MockBytes *inputs = mock_alloc(tx->input_count * sizeof(MockBytes));
+    for (size_t i = 0; i < tx->input_count; i++) inputs[i] = tx->inputs[i].input;
+    MockBytes *outputs = mock_alloc(tx->output_count * sizeof(MockBytes));
+    MockBytes *outputs_data = mock_alloc(tx->output_count * sizeof(MockBytes));
+    for (size_t i = 0; i < tx->output_count; i++) {
+        outputs[i] = tx->outputs[i].output;
+        outputs_data[i] = mol_bytes(tx->outputs[i].data);
+    }
+    MockBytes *witness_items = mock_alloc(tx->witness_count * sizeof(MockBytes));
+    for (size_t i = 0; i < tx->witness_count; i++) witness_items[i] = mol_bytes(tx->witnesses[i]);
+
+    MockBytes raw_fields[6] = {
+        {version, 4},
+        mol_fixvec(deps, tx->cell_dep_count),
+        mol_fixvec(header_hashes, tx->header_dep_count),
+        mol_fixvec(inputs, tx->input_count),
+        mol_dynvec(outputs, tx->output_count),
+        mol_dynvec(outputs_data, tx->output_count),
+    };
+    MockBytes tx_fields[2] = {mol_dynvec(raw_fields, 6), mol_dynvec(witness_items, tx->witness_count)};
+    tx->transaction = mol_dynvec(tx_fields, 2);
+    mock_ckbhash(tx_fields[0].ptr, tx_fields[0].size, tx->tx_hash);
+    return 0;
+}
+
+int mock_tx_load(MockTx *tx, const char *json, size_t len, const char **error) {
+    JsonParser s = {json, json, json + len};
+    JsonValue root;
+
+    memset(tx, 0, sizeof(*tx));
+    *error = s_error;
+    if (json_parse_value(&s, &root, 0) < 0) return -1;
+    json_skip_space(&s);
+    if (s.p != s.end) return json_fail(&s, "unexpected data after the end");
+    if (root.type != JSON_OBJECT) return mock_fail("%s", "not a mock transaction");
+    return load_tx(tx, &root);
+}
@@ -0,0 +1,52 @@
+#ifndef _MOCK_TX_H_
+#define _MOCK_TX_H_
+
+// The transaction of a ckb-debugger mock transaction file (--tx-file), serialized with molecule the way the syscalls
+// return it. Only for the native build, see docs/native.md.
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct MockBytes {
+    uint8_t *ptr;
+    size_t size;
+} MockBytes;
+
+typedef struct MockCell {
+    MockBytes input;   // CellInput, only for the inputs
+    MockBytes output;  // CellOutput
+    MockBytes lock;    // Script
+    MockBytes type;    // Script, empty without a type script
+    MockBytes data;
+    MockBytes header;  // Header of the block of the cell, empty if it's not given
+    uint64_t capacity;
+    uint8_t lock_hash[32];
+    uint8_t type_hash[32];
+    uint8_t data_hash[32];
+} MockCell;
+
+typedef struct MockTx {
+    MockCell *inputs;
+    size_t input_count;
+    MockCell *outputs;
+    size_t output_count;
+    MockCell *cell_deps;
+    size_t cell_dep_count;
+    MockBytes *header_deps;  // Header
+    size_t header_dep_count;
+    MockBytes *witnesses;
+    size_t witness_count;
+    MockBytes transaction;  // Transaction
+    uint8_t tx_hash[32];
+} MockTx;
+
+// Parse the JSON of a mock transaction. Return 0 on success, or -1 with an error message in `*error`.
+int mock_tx_load(MockTx *tx, const char *json, size_t len, const char **error);
+
+// ckbhash, the blake2b-256 hash with the CKB personalization of all the hashes of a transaction.
+void mock_ckbhash(const uint8_t *data, size_t len, uint8_t hash[32]);
+
+// malloc() that aborts when out of memory. The mock transaction is loaded once and never freed.
+void *mock_alloc(size_t size);
+
+#endif  // _MOCK_TX_H_
@@ -1,8 +1,10 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "ckb_module.h"
+#include "my_stdlib.h"
 #include "cutils.h"
 #include "ckb_syscalls.h"
+#include "ckb_dlfcn.h"
 #include "molecule/blockchain.h"
 #include "molecule/molecule_reader.h"
 
@@ -20,26 +22,72 @@ enum SyscallErrorCode {
     SyscallErrorArgument = 82,
 };
 
+// ckb_get_memory_limit() is the memory of the script in units of 512 KB: 8 (4 MB), or less for a script spawned with
+// a smaller memory_limit. The binary is loaded at the bottom of it, the stack starts at the top, and the heap is in
+// between. A quarter of the memory, up to 1 MB, is left for the stack.
+#define MEMORY_UNIT (512 * 1024)
+#define STACK_SIZE_MAX (1024 * 1024)
+
+static uintptr_t memory_top = 0;
+
+int ckb_init_heap(void) {
+#ifndef CONFIG_NATIVE
+    extern char _end[];
+    int limit = ckb_get_memory_limit();
+    if (limit <= 0) return 0;
+    uintptr_t top = (uintptr_t)limit * MEMORY_UNIT;
+    uintptr_t stack_size = top / 4 < STACK_SIZE_MAX ? top / 4 : STACK_SIZE_MAX;
+    uintptr_t sp = (uintptr_t)&limit;
+    // keep the default heap if the stack isn't where it's expected
+    if (sp >= top || sp < top - stack_size) return 0;
+    // the default heap would be above the memory of the script
+    if (top - stack_size <= (uintptr_t)_end) return -1;
+    malloc_config((uintptr_t)_end, top - stack_size);
+    memory_top = top;
+#endif
+    return 0;
+}
+
+#ifdef CONFIG_PROFILE
+static void profile_write(void *opaque, const char *line) { ckb_debug(line); }
+
+int ckb_enable_profile(JSRuntime *rt) { return JS_EnableProfile(rt, ckb_current_cycles); }
+
+// The memory map, before the report of JS_DumpProfile()
+static void dump_memory_map(JSProfileWriteFunc *write, void *opaque) {
+    char line[128];
+    MallocHeapInfo heap;
+    malloc_heap_info(&heap);
+    write(opaque, "profile: memory");
+    snprintf(line, sizeof(line), "code   0x%08lx-0x%08lx", 0ul, (unsigned long)heap.start);
+    write(opaque, line);
+    snprintf(line, sizeof(line), "heap   0x%08lx-0x%08lx  used %lu  peak %lu", (unsigned long)heap.start,
+             (unsigned long)(heap.start + heap.size), (unsigned long)heap.used, (unsigned long)heap.peak);
+    write(opaque, line);
+    if (memory_top) {
+        snprintf(line, sizeof(line), "stack  0x%08lx-0x%08lx", (unsigned long)(heap.start + heap.size),
+                 (unsigned long)memory_top);
+        write(opaque, line);
+    }
+}
+
+void ckb_dump_profile(JSRuntime *rt) {
+    dump_memory_map(profile_write, NULL);
+    JS_DumpProfile(rt, profile_write, NULL);
+}
+#endif
+
 static JSValue syscall_exit(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
     int32_t status;
     if (JS_ToInt32(ctx, &status, argv[0])) return JS_EXCEPTION;
+#ifdef CONFIG_PROFILE
+    ckb_dump_profile(JS_GetRuntime(ctx));
+#endif
     ckb_exit((int8_t)status);
     return JS_UNDEFINED;
 }
 
 static void my_free(JSRuntime *rt, void *opaque, void *_ptr) { free(opaque); }
-struct LoadData;
-typedef int (*LoadFunc)(void *addr, uint64_t *len, struct LoadData *data);
-
-typedef struct LoadData {
-    uint64_t length;
-    size_t index;
-    size_t source;
-    size_t offset;
-    size_t field;
-    LoadFunc func;
-} LoadData;
-
 static JSValue parse_args(JSContext *ctx, LoadData *data, bool has_field, int argc, JSValueConst *argv, LoadFunc func) {
     int64_t index;
     int64_t source;
@@ -47,28 +95,28 @@ static JSValue parse_args(JSContext *ctx, LoadData *data, bool has_field, int ar
     int64_t offset = NO_VALUE;
     int64_t field = NO_VALUE;
 
-    if (JS_ToInt64(ctx, &index, argv[0])) {
+    if (JS_ToInt64Ext(ctx, &index, argv[0])) {
         return JS_EXCEPTION;
     }
-    if (JS_ToInt64(ctx, &source, argv[1])) {
+    if (JS_ToInt64Ext(ctx, &source, argv[1])) {
         return JS_EXCEPTION;
     }
     int var_arg_index = 2;
     if (has_field) {
         if (argc > 2) {
-            if (JS_ToInt64(ctx, &field, argv[2])) {
+            if (JS_ToInt64Ext(ctx, &field, argv[2])) {
                 return JS_EXCEPTION;
             }
         }
         var_arg_index = 3;
     }
     if (argc > var_arg_index) {
-        if (JS_ToInt64(ctx, &length, argv[var_arg_index])) {
+        if (JS_ToInt64Ext(ctx, &length, argv[var_arg_index])) {
             return JS_EXCEPTION;
         }
     }
     if (argc > (var_arg_index + 1)) {
-        if (JS_ToInt64(ctx, &offset, argv[var_arg_index + 1])) {
+        if (JS_ToInt64Ext(ctx, &offset, argv[var_arg_index + 1])) {
             return JS_EXCEPTION;
         }
     }
@@ -117,7 +165,7 @@ exit:
     }
 }
 
-static int _load_tx_hash(void *addr, uint64_t *len, LoadData *data) {
+int _load_tx_hash(void *addr, uint64_t *len, LoadData *data) {
     return ckb_load_tx_hash(addr, len, data->offset);
 }
 
@@ -130,7 +178,7 @@ static JSValue syscall_load_tx_hash(JSContext *ctx, JSValueConst this_val, int a
     return syscall_load(ctx, &data);
 }
 
-static int _load_transaction(void *addr, uint64_t *len, LoadData *data) {
+int _load_transaction(void *addr, uint64_t *len, LoadData *data) {
     return ckb_load_transaction(addr, len, data->offset);
 }
 
@@ -143,7 +191,7 @@ static JSValue syscall_load_transaction(JSContext *ctx, JSValueConst this_val, i
     return syscall_load(ctx, &data);
 }
 
-static int _load_script_hash(void *addr, uint64_t *len, LoadData *data) {
+int _load_script_hash(void *addr, uint64_t *len, LoadData *data) {
     return ckb_load_script_hash(addr, len, data->offset);
 }
 
@@ -156,7 +204,7 @@ static JSValue syscall_load_script_hash(JSContext *ctx, JSValueConst this_val, i
     return syscall_load(ctx, &data);
 }
 
-static int _load_script(void *addr, uint64_t *len, LoadData *data) { return ckb_load_script(addr, len, data->offset); }
+int _load_script(void *addr, uint64_t *len, LoadData *data) { return ckb_load_script(addr, len, data->offset); }
 
 static JSValue syscall_load_script(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
     LoadData data = {0};
@@ -173,7 +221,7 @@ static JSValue syscall_debug(JSContext *ctx, JSValueConst this_value, int argc,
     return JS_UNDEFINED;
 }
 
-static int _load_cell(void *addr, uint64_t *len, LoadData *data) {
+int _load_cell(void *addr, uint64_t *len, LoadData *data) {
     return ckb_load_cell(addr, len, data->offset, data->index, data->source);
 }
 
@@ -186,7 +234,7 @@ static JSValue syscall_load_cell(JSContext *ctx, JSValueConst this_val, int argc
     return syscall_load(ctx, &data);
 }
 
-static int _load_input(void *addr, uint64_t *len, LoadData *data) {
+int _load_input(void *addr, uint64_t *len, LoadData *data) {
     return ckb_load_input(addr, len, data->offset, data->index, data->source);
 }
 
@@ -199,7 +247,7 @@ static JSValue syscall_load_input(JSContext *ctx, JSValueConst this_val, int arg
     return syscall_load(ctx, &data);
 }
 
-static int _load_header(void *addr, uint64_t *len, LoadData *data) {
+int _load_header(void *addr, uint64_t *len, LoadData *data) {
     return ckb_load_header(addr, len, data->offset, data->index, data->source);
 }
 
@@ -212,7 +260,7 @@ static JSValue syscall_load_header(JSContext *ctx, JSValueConst this_val, int ar
     return syscall_load(ctx, &data);
 }
 
-static int _load_witness(void *addr, uint64_t *len, LoadData *data) {
+int _load_witness(void *addr, uint64_t *len, LoadData *data) {
     return ckb_load_witness(addr, len, data->offset, data->index, data->source);
 }
 
@@ -225,7 +273,7 @@ static JSValue syscall_load_witness(JSContext *ctx, JSValueConst this_val, int a
     return syscall_load(ctx, &data);
 }
 
-static int _load_cell_data(void *addr, uint64_t *len, LoadData *data) {
+int _load_cell_data(void *addr, uint64_t *len, LoadData *data) {
     return ckb_load_cell_data(addr, len, data->offset, data->index, data->source);
 }
 
@@ -238,7 +286,7 @@ static JSValue syscall_load_cell_data(JSContext *ctx, JSValueConst this_val, int
     return syscall_load(ctx, &data);
 }
 
-static int _load_cell_by_field(void *addr, uint64_t *len, LoadData *data) {
+int _load_cell_by_field(void *addr, uint64_t *len, LoadData *data) {
     return ckb_load_cell_by_field(addr, len, data->offset, data->index, data->source, data->field);
 }
 
@@ -251,7 +299,7 @@ static JSValue syscall_load_cell_by_field(JSContext *ctx, JSValueConst this_val,
     return syscall_load(ctx, &data);
 }
 
-static int _load_header_by_field(void *addr, uint64_t *len, LoadData *data) {
+int _load_header_by_field(void *addr, uint64_t *len, LoadData *data) {
     return ckb_load_header_by_field(addr, len, data->offset, data->index, data->source, data->field);
 }
 
@@ -264,7 +312,7 @@ static JSValue syscall_load_header_by_field(JSContext *ctx, JSValueConst this_va
     return syscall_load(ctx, &data);
 }
 
-static int _load_input_by_field(void *addr, uint64_t *len, LoadData *data) {
+int _load_input_by_field(void *addr, uint64_t *len, LoadData *data) {
     return ckb_load_input_by_field(addr, len, data->offset, data->index, data->source, data->field);
 }
 
@@ -277,6 +325,177 @@ static JSValue syscall_load_input_by_field(JSContext *ctx, JSValueConst this_val
     return syscall_load(ctx, &data);
 }
 
+// The `_into` variants of the load syscalls write into a caller supplied ArrayBuffer, TypedArray or DataView instead
+// of allocating a new ArrayBuffer on every call. Their arguments are described as:
+// argument 1: buffer
+// argument 2: offset in buffer (optional, default to 0)
+// argument 3..: index, source and field, as in the regular variant (only those the syscall takes)
+// argument n: offset in the data (optional, default to 0)
+// The data is loaded up to the end of the buffer, the return value is the length of the data from the offset, which
+// means it was truncated when it's larger than the space left in the buffer.
+typedef struct LoadIntoDef {
+    const char *name;
+    LoadFunc func;
+    // number of index/source/field arguments
+    int arg_count;
+} LoadIntoDef;
+
+static const LoadIntoDef load_into_defs[] = {
+    {"load_tx_hash_into", _load_tx_hash, 0},
+    {"load_transaction_into", _load_transaction, 0},
+    {"load_script_hash_into", _load_script_hash, 0},
+    {"load_script_into", _load_script, 0},
+    {"load_cell_into", _load_cell, 2},
+    {"load_input_into", _load_input, 2},
+    {"load_header_into", _load_header, 2},
+    {"load_witness_into", _load_witness, 2},
+    {"load_cell_data_into", _load_cell_data, 2},
+    {"load_cell_by_field_into", _load_cell_by_field, 3},
+    {"load_header_by_field_into", _load_header_by_field, 3},
+    {"load_input_by_field_into", _load_input_by_field, 3},
+};
+
+static JSValue syscall_load_into(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv, int magic) {
+    int err = 0;
+    JSValue ret = JS_EXCEPTION;
+    const LoadIntoDef *def = &load_into_defs[magic];
+    // offset in buffer, index/source/field, offset in the data
+    int64_t args[5] = {0};
+    size_t size = 0;
+
+    uint8_t *buf = JS_GetArrayBufferView(ctx, &size, argv[0]);
+    CHECK2(buf != NULL, SyscallErrorArgument);
+    for (int i = 1; i < argc && i <= def->arg_count + 2; i++) {
+        err = JS_ToInt64Ext(ctx, &args[i - 1], argv[i]);
+        CHECK(err);
+    }
+    int64_t buf_offset = args[0];
+    CHECK2(buf_offset >= 0 && buf_offset <= size, SyscallErrorArgument);
+
+    LoadData data = {
+        .func = def->func,
+        .length = size - buf_offset,
+        .offset = args[def->arg_count + 1],
+    };
+    if (def->arg_count >= 2) {
+        data.index = args[1];
+        data.source = args[2];
+    }
+    if (def->arg_count >= 3) {
+        data.field = args[3];
+    }
+    uint64_t len = data.length;
+    err = data.func(buf + buf_offset, &len, &data);
+    CHECK(err);
+    ret = JS_NewInt64(ctx, (int64_t)len);
+exit:
+    if (err != 0) {
+        return JS_EXCEPTION;
+    } else {
+        return ret;
+    }
+}
+
+// The `load_all_` functions load the data of all the cells (or inputs, headers, witnesses) of a source in one call.
+// Their arguments are described as:
+// argument 1: source
+// argument 2: field (only for the `_by_field` functions)
+// The return value is an object with `data`, an ArrayBuffer holding the data of every index, one after the other,
+// and `offsets`, an array of count + 1 offsets in `data`: the data of index i spans from offsets[i] to offsets[i + 1].
+// The iteration stops at the first index out of bound. Missing items (e.g. the type of a cell without type script)
+// are empty.
+typedef struct LoadAllDef {
+    const char *name;
+    LoadFunc func;
+    bool has_field;
+} LoadAllDef;
+
+static const LoadAllDef load_all_defs[] = {
+    {"load_all_cell", _load_cell, false},
+    {"load_all_input", _load_input, false},
+    {"load_all_header", _load_header, false},
+    {"load_all_witness", _load_witness, false},
+    {"load_all_cell_data", _load_cell_data, false},
+    {"load_all_cell_by_field", _load_cell_by_field, true},
+    {"load_all_header_by_field", _load_header_by_field, true},
+    {"load_all_input_by_field", _load_input_by_field, true},
+};
+
+#define LOAD_ALL_INITIAL_SIZE 1024
+
+static JSValue syscall_load_all(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv, int magic) {
+    int err = 0;
+    JSValue ret = JS_UNDEFINED;
+    JSValue offsets = JS_UNDEFINED;
+    const LoadAllDef *def = &load_all_defs[magic];
+    int64_t source = 0;
+    int64_t field = 0;
+    uint8_t *buf = NULL;
+    size_t size = 0;
+    size_t capacity = LOAD_ALL_INITIAL_SIZE;
+
+    err = JS_ToInt64Ext(ctx, &source, argv[0]);
+    CHECK(err);
+    if (def->has_field) {
+        err = JS_ToInt64Ext(ctx, &field, argv[1]);
+        CHECK(err);
+    }
+    buf = (uint8_t *)malloc(capacity);
+    CHECK2(buf != NULL, SyscallErrorMemory);
+    offsets = JS_NewArray(ctx);
+    CHECK2(!JS_IsException(offsets), SyscallErrorMemory);
+    CHECK2(JS_SetPropertyUint32(ctx, offsets, 0, JS_NewUint32(ctx, 0)) >= 0, SyscallErrorMemory);
+
+    LoadData data = {
+        .func = def->func,
+        .source = source,
+        .field = field,
+    };
+    for (data.index = 0;; data.index++) {
+        uint64_t len = capacity - size;
+        int code = data.func(buf + size, &len, &data);
+        if (code == CKB_INDEX_OUT_OF_BOUND) {
+            break;
+        }
+        if (code == CKB_ITEM_MISSING) {
+            len = 0;
+        } else {
+            CHECK(code);
+        }
+        if (len > capacity - size) {
+            // didn't fit, grow the buffer and load it again
+            while (len > capacity - size) {
+                capacity *= 2;
+            }
+            uint8_t *new_buf = (uint8_t *)realloc(buf, capacity);
+            CHECK2(new_buf != NULL, SyscallErrorMemory);
+            buf = new_buf;
+            err = data.func(buf + size, &len, &data);
+            CHECK(err);
+        }
+        size += len;
+        CHECK2(JS_SetPropertyUint32(ctx, offsets, data.index + 1, JS_NewUint32(ctx, (uint32_t)size)) >= 0,
+               SyscallErrorMemory);
+    }
+
+    ret = JS_NewObject(ctx);
+    CHECK2(!JS_IsException(ret), SyscallErrorMemory);
+    JS_DefinePropertyValueStr(ctx, ret, "data", JS_NewArrayBuffer(ctx, buf, size, my_free, buf, false),
+                              JS_PROP_C_W_E);
+    buf = NULL;
+    JS_DefinePropertyValueStr(ctx, ret, "offsets", offsets, JS_PROP_C_W_E);
+    offsets = JS_UNDEFINED;
+exit:
+    free(buf);
+    JS_FreeValue(ctx, offsets);
+    if (err != 0) {
+        JS_FreeValue(ctx, ret);
+        return JS_EXCEPTION;
+    } else {
+        return ret;
+    }
+}
+
 static JSValue syscall_vm_version(JSContext *ctx, JSValueConst this_value, int argc, JSValueConst *argv) {
     int32_t version = ckb_vm_version();
     return JS_NewInt32(ctx, version);
@@ -287,6 +506,45 @@ static JSValue syscall_current_cycles(JSContext *ctx, JSValueConst this_value, i
     return JS_NewInt64(ctx, cycles);
 }
 
+// The cycle budget is checked by the interrupt handler, which is called every `interval` function calls and
+// backward jumps. Once the budget is crossed, the script is stopped by an uncatchable error.
+static uint64_t cycle_limit = 0;
+static bool cycle_budget_exceeded = false;
+
+static int cycle_budget_handler(JSRuntime *rt, void *opaque) {
+    if (cycle_budget_exceeded) return 1;
+    uint64_t cycles = ckb_current_cycles();
+    if (cycles <= cycle_limit) return 0;
+    printf("cycle budget exceeded: %lu cycles consumed, the limit is %lu\n", (unsigned long)cycles,
+           (unsigned long)cycle_limit);
+    cycle_budget_exceeded = true;
+    return 1;
+}
+
+void ckb_set_cycle_budget(JSRuntime *rt, uint64_t budget, int interval) {
+    if (interval > 0) JS_SetInterruptCounter(rt, interval);
+    cycle_budget_exceeded = false;
+    if (budget == 0) {
+        JS_SetInterruptHandler(rt, NULL, NULL);
+    } else {
+        cycle_limit = ckb_current_cycles() + budget;
+        JS_SetInterruptHandler(rt, cycle_budget_handler, NULL);
+    }
+}
+
+// Arguments are described as:
+// argument 1: number of cycles the script may still consume, 0 removes the budget
+// argument 2: check interval (optional, default to 10000 function calls and backward jumps)
+static JSValue syscall_set_cycle_budget(JSContext *ctx, JSValueConst this_value, int argc, JSValueConst *argv) {
+    int64_t budget = 0;
+    int32_t interval = 0;
+    if (JS_ToInt64Ext(ctx, &budget, argv[0])) return JS_EXCEPTION;
+    if (!JS_IsUndefined(argv[1]) && JS_ToInt32(ctx, &interval, argv[1])) return JS_EXCEPTION;
+    if (budget < 0 || interval < 0) return JS_ThrowRangeError(ctx, "invalid cycle budget");
+    ckb_set_cycle_budget(JS_GetRuntime(ctx), budget, interval);
+    return JS_UNDEFINED;
+}
+
 static JSValue syscall_exec_cell(JSContext *ctx, JSValueConst this_value, int argc, JSValueConst *argv) {
     const size_t argv_offset = 4;
     int err = 0;
@@ -460,26 +718,297 @@ static JSValue syscall_current_memory(JSContext *ctx, JSValueConst this_value, i
     return JS_NewUint32(ctx, (uint32_t)size);
 }
 
-/*
-TODO:
-// who allocated the memory indicated by aligned_addr?
-int ckb_dlopen2(const uint8_t* dep_cell_hash, uint8_t hash_type,
-                uint8_t* aligned_addr, size_t aligned_size, void** handle,
-                size_t* consumed_size);
-void* ckb_dlsym(void* handle, const char* symbol);
-*/
+// The fields of JSMemoryUsage, and of the heap
+static const struct {
+    const char *name;
+    size_t offset;
+} memory_usage_fields[] = {
+#define FIELD(name) {#name, offsetof(JSMemoryUsage, name)}
+    FIELD(malloc_size),
+    FIELD(malloc_limit),
+    FIELD(memory_used_size),
+    FIELD(malloc_count),
+    FIELD(memory_used_count),
+    FIELD(atom_count),
+    FIELD(atom_size),
+    FIELD(str_count),
+    FIELD(str_size),
+    FIELD(obj_count),
+    FIELD(obj_size),
+    FIELD(prop_count),
+    FIELD(prop_size),
+    FIELD(shape_count),
+    FIELD(shape_size),
+    FIELD(js_func_count),
+    FIELD(js_func_size),
+    FIELD(js_func_code_size),
+    FIELD(js_func_pc2line_count),
+    FIELD(js_func_pc2line_size),
+    FIELD(c_func_count),
+    FIELD(array_count),
+    FIELD(fast_array_count),
+    FIELD(fast_array_elements),
+    FIELD(binary_object_count),
+    FIELD(binary_object_size),
+#undef FIELD
+};
+
+static JSValue syscall_memory_usage(JSContext *ctx, JSValueConst this_value, int argc, JSValueConst *argv) {
+    JSMemoryUsage usage;
+    MallocHeapInfo heap;
+    JS_ComputeMemoryUsage(JS_GetRuntime(ctx), &usage);
+    malloc_heap_info(&heap);
+    JSValue ret = JS_NewObject(ctx);
+    if (JS_IsException(ret)) return ret;
+    for (int i = 0; i < countof(memory_usage_fields); i++) {
+        int64_t value = *(int64_t *)((uint8_t *)&usage + memory_usage_fields[i].offset);
+        JS_DefinePropertyValueStr(ctx, ret, memory_usage_fields[i].name, JS_NewInt64(ctx, value), JS_PROP_C_W_E);
+    }
+    JS_DefinePropertyValueStr(ctx, ret, "heap_size", JS_NewInt64(ctx, heap.size), JS_PROP_C_W_E);
+    JS_DefinePropertyValueStr(ctx, ret, "heap_used", JS_NewInt64(ctx, heap.used), JS_PROP_C_W_E);
+    JS_DefinePropertyValueStr(ctx, ret, "heap_peak", JS_NewInt64(ctx, heap.peak), JS_PROP_C_W_E);
+    return ret;
+}
+
+// The threshold of JS_NewRuntime(). After a collection triggered by the threshold, QuickJS sets it to 1.5 times
+// the memory still allocated.
+#define GC_THRESHOLD_AUTO (256 * 1024)
+
+// Arguments are described as:
+// argument 1: options (optional), with `mode`:
+//   "collect" (default): collect the cycles now
+//   "never": never collect cycles automatically, the memory of the objects in cycles is lost
+//   "auto": collect cycles when the memory allocated crosses the threshold, which is the default, not allowed in the
+//   arena
+static JSValue syscall_gc(JSContext *ctx, JSValueConst this_value, int argc, JSValueConst *argv) {
+    JSRuntime *rt = JS_GetRuntime(ctx);
+    const char *mode = NULL;
+    if (argc > 0 && !JS_IsUndefined(argv[0])) {
+        JSValue val = JS_GetPropertyStr(ctx, argv[0], "mode");
+        if (JS_IsException(val)) return val;
+        if (!JS_IsUndefined(val)) {
+            mode = JS_ToCString(ctx, val);
+            JS_FreeValue(ctx, val);
+            if (!mode) return JS_EXCEPTION;
+        }
+    }
+    JSValue ret = JS_UNDEFINED;
+    if (!mode || strcmp(mode, "collect") == 0) {
+        JS_RunGC(rt);
+    } else if (strcmp(mode, "never") == 0) {
+        JS_SetGCThreshold(rt, (size_t)-1);
+    } else if (strcmp(mode, "auto") == 0) {
+        if (malloc_arena_enabled()) {
+            ret = JS_ThrowTypeError(ctx, "the cycle collector can't run automatically in the arena");
+        } else {
+            JS_SetGCThreshold(rt, GC_THRESHOLD_AUTO);
+        }
+    } else {
+        ret = JS_ThrowRangeError(ctx, "invalid gc mode: %s", mode);
+    }
+    JS_FreeCString(ctx, mode);
+    return ret;
+}
+
+// Arguments are described as:
+// argument 1: cycles are collected once the memory allocated by QuickJS crosses this number of bytes
+static JSValue syscall_set_gc_threshold(JSContext *ctx, JSValueConst this_value, int argc, JSValueConst *argv) {
+    int64_t threshold = 0;
+    if (JS_ToInt64Ext(ctx, &threshold, argv[0])) return JS_EXCEPTION;
+    if (threshold < 0) return JS_ThrowRangeError(ctx, "invalid gc threshold");
+    if (malloc_arena_enabled())
+        return JS_ThrowTypeError(ctx, "the cycle collector can't run automatically in the arena");
+    JS_SetGCThreshold(JS_GetRuntime(ctx), threshold);
+    return JS_UNDEFINED;
+}
+
+static JSValue syscall_gc_stats(JSContext *ctx, JSValueConst this_value, int argc, JSValueConst *argv) {
+    JSRuntime *rt = JS_GetRuntime(ctx);
+    JSGCStats stats;
+    JS_GetGCStats(rt, &stats);
+    size_t threshold = JS_GetGCThreshold(rt);
+    JSValue ret = JS_NewObject(ctx);
+    if (JS_IsException(ret)) return ret;
+    JS_DefinePropertyValueStr(ctx, ret, "count", JS_NewInt64(ctx, stats.count), JS_PROP_C_W_E);
+    JS_DefinePropertyValueStr(ctx, ret, "scanned", JS_NewInt64(ctx, stats.scanned), JS_PROP_C_W_E);
+    JS_DefinePropertyValueStr(ctx, ret, "freed", JS_NewInt64(ctx, stats.freed), JS_PROP_C_W_E);
+    JS_DefinePropertyValueStr(ctx, ret, "cycles", JS_NewInt64(ctx, stats.time), JS_PROP_C_W_E);
+    // -1 when cycles are never collected automatically
+    JS_DefinePropertyValueStr(ctx, ret, "threshold",
+                              JS_NewInt64(ctx, threshold == (size_t)-1 ? -1 : (int64_t)threshold), JS_PROP_C_W_E);
+    return ret;
+}
+
+// Native libraries loaded by ckb.dlopen. A library is loaded at most once and stays loaded until the script exits:
+// its code pages are executable and can't be given back to the allocator, and the functions returned by ckb.dlsym
+// may be referenced from anywhere.
+typedef struct DlLibrary {
+    struct DlLibrary *next;
+    uint8_t code_hash[32];
+    uint8_t hash_type;
+    void *handle;
+} DlLibrary;
+
+static DlLibrary *dl_libraries = NULL;
+static JSClassID js_dl_library_class_id;
+
+static JSClassDef js_dl_library_class = {
+    "Library",
+};
+
+// extra memory for the sections which are not in the file, e.g. .bss
+#define DLOPEN_EXTRA_SIZE (64 * 1024)
+// a native function takes at most this number of buffers
+#define DLSYM_MAX_ARGS 16
+
+// Arguments are described as:
+// argument 1: code hash of the library, 32 bytes
+// argument 2: hash type
+// argument 3: size of the memory to load the library in (optional, default to the size of the library plus 64 KB)
+// The return value is a library object to pass to ckb.dlsym.
+static JSValue syscall_dlopen(JSContext *ctx, JSValueConst this_value, int argc, JSValueConst *argv) {
+    int err = 0;
+    size_t code_hash_len = 0;
+    uint32_t hash_type = 0;
+    uint64_t size = 0;
+    size_t consumed_size = 0;
+    DlLibrary *lib = NULL;
+    JSValue ret = JS_EXCEPTION;
+
+    uint8_t *code_hash = JS_GetArrayBufferView(ctx, &code_hash_len, argv[0]);
+    CHECK2(code_hash != NULL && code_hash_len == 32, SyscallErrorArgument);
+    err = JS_ToUint32(ctx, &hash_type, argv[1]);
+    CHECK(err);
+
+    for (lib = dl_libraries; lib != NULL; lib = lib->next) {
+        if (memcmp(lib->code_hash, code_hash, 32) == 0 && lib->hash_type == hash_type) {
+            break;
+        }
+    }
+    if (lib == NULL) {
+        if (argc > 2 && !JS_IsUndefined(argv[2])) {
+            int64_t n = 0;
+            err = JS_ToInt64Ext(ctx, &n, argv[2]);
+            CHECK(err);
+            CHECK2(n > 0, SyscallErrorArgument);
+            size = n;
+        } else {
+            size_t index = 0;
+            err = ckb_look_for_dep_with_hash2(code_hash, (uint8_t)hash_type, &index);
+            CHECK(err);
+            err = ckb_load_cell_data(NULL, &size, 0, index, CKB_SOURCE_CELL_DEP);
+            CHECK(err);
+            size += DLOPEN_EXTRA_SIZE;
+        }
+        size = (size + RISCV_PGSIZE - 1) & ~(uint64_t)(RISCV_PGSIZE - 1);
+        // the library is loaded into whole pages, which must not be shared with other allocations
+        uint8_t *buf = (uint8_t *)malloc(size + RISCV_PGSIZE);
+        CHECK2(buf != NULL, SyscallErrorMemory);
+        uint8_t *aligned_addr = (uint8_t *)(((uintptr_t)buf + RISCV_PGSIZE - 1) & ~(uintptr_t)(RISCV_PGSIZE - 1));
+        lib = (DlLibrary *)malloc(sizeof(DlLibrary));
+        if (lib == NULL) {
+            free(buf);
+            CHECK2(false, SyscallErrorMemory);
+        }
+        err = ckb_dlopen2(code_hash, (uint8_t)hash_type, aligned_addr, size, &lib->handle, &consumed_size);
+        if (err != 0) {
+            // buf is leaked: ckb_dlopen2 may have made some of its pages executable before it failed
+            free(lib);
+            CHECK(err);
+        }
+        memcpy(lib->code_hash, code_hash, 32);
+        lib->hash_type = (uint8_t)hash_type;
+        lib->next = dl_libraries;
+        dl_libraries = lib;
+    }
+
+    ret = JS_NewObjectClass(ctx, js_dl_library_class_id);
+    CHECK2(!JS_IsException(ret), SyscallErrorMemory);
+    JS_SetOpaque(ret, lib);
+exit:
+    if (err != 0) {
+        return JS_EXCEPTION;
+    } else {
+        return ret;
+    }
+}
+
+// Native functions have the following signature, each argument is an ArrayBuffer, a TypedArray or a DataView which
+// is passed in place, so it can also be used for output:
+// int func(size_t argc, uint8_t *argv[], size_t sizes[]);
+// The return value is the return value of the function.
+typedef int (*DlFunc)(size_t argc, uint8_t *argv[], size_t sizes[]);
+
+static JSValue syscall_dlsym_call(JSContext *ctx, JSValueConst this_value, int argc, JSValueConst *argv, int magic,
+                                  JSValue *func_data) {
+    int err = 0;
+    int64_t addr = 0;
+    uint8_t *args[DLSYM_MAX_ARGS];
+    size_t sizes[DLSYM_MAX_ARGS];
+
+    CHECK2(argc <= DLSYM_MAX_ARGS, SyscallErrorArgument);
+    err = JS_ToInt64(ctx, &addr, func_data[0]);
+    CHECK(err);
+    for (int i = 0; i < argc; i++) {
+        args[i] = JS_GetArrayBufferView(ctx, &sizes[i], argv[i]);
+        CHECK2(args[i] != NULL, SyscallErrorArgument);
+    }
+    DlFunc func = (DlFunc)(uintptr_t)addr;
+    return JS_NewInt32(ctx, func(argc, args, sizes));
+exit:
+    return JS_EXCEPTION;
+}
+
+// Arguments are described as:
+// argument 1: library returned by ckb.dlopen
+// argument 2: name of the function
+// The return value is a JS function calling the native one, or undefined if the library has no such function.
+static JSValue syscall_dlsym(JSContext *ctx, JSValueConst this_value, int argc, JSValueConst *argv) {
+    int err = 0;
+    JSValue ret = JS_EXCEPTION;
+    const char *name = NULL;
+
+    DlLibrary *lib = JS_GetOpaque(argv[0], js_dl_library_class_id);
+    CHECK2(lib != NULL, SyscallErrorArgument);
+    name = JS_ToCString(ctx, argv[1]);
+    CHECK2(name != NULL, SyscallErrorArgument);
+    void *func = ckb_dlsym(lib->handle, name);
+    if (func == NULL) {
+        ret = JS_UNDEFINED;
+    } else {
+        JSValue func_data = JS_NewInt64(ctx, (int64_t)(uintptr_t)func);
+        ret = JS_NewCFunctionData(ctx, syscall_dlsym_call, 0, 0, 1, &func_data);
+    }
+exit:
+    JS_FreeCString(ctx, name);
+    if (err != 0) {
+        return JS_EXCEPTION;
+    } else {
+        return ret;
+    }
+}
+
 int js_init_module_ckb(JSContext *ctx) {
     JSValue global_obj, ckb;
     global_obj = JS_GetGlobalObject(ctx);
     ckb = JS_NewObject(ctx);
 
+    // two syscalls per collection, to count the cycles spent in the cycle collector
+    JS_SetGCClock(JS_GetRuntime(ctx), ckb_current_cycles);
+
+    if (js_dl_library_class_id == 0) {
+        JS_NewClassID(&js_dl_library_class_id);
+        JS_NewClass(JS_GetRuntime(ctx), js_dl_library_class_id, &js_dl_library_class);
+    }
+
     JS_SetPropertyStr(ctx, ckb, "exit", JS_NewCFunction(ctx, syscall_exit, "exit", 1));
     JS_SetPropertyStr(ctx, ckb, "load_tx_hash", JS_NewCFunction(ctx, syscall_load_tx_hash, "load_tx_hash", 1));
+    // parse_args() reads the first 2 arguments, which are undefined when they are missing
     JS_SetPropertyStr(ctx, ckb, "load_transaction",
-                      JS_NewCFunction(ctx, syscall_load_transaction, "load_transaction", 1));
+                      JS_NewCFunction(ctx, syscall_load_transaction, "load_transaction", 2));
     JS_SetPropertyStr(ctx, ckb, "load_script_hash",
                       JS_NewCFunction(ctx, syscall_load_script_hash, "load_script_hash", 1));
-    JS_SetPropertyStr(ctx, ckb, "load_script", JS_NewCFunction(ctx, syscall_load_script, "load_script", 1));
+    JS_SetPropertyStr(ctx, ckb, "load_script", JS_NewCFunction(ctx, syscall_load_script, "load_script", 2));
     JS_SetPropertyStr(ctx, ckb, "debug", JS_NewCFunction(ctx, syscall_debug, "debug", 1));
     JS_SetPropertyStr(ctx, ckb, "load_cell", JS_NewCFunction(ctx, syscall_load_cell, "load_cell", 3));
     JS_SetPropertyStr(ctx, ckb, "load_input", JS_NewCFunction(ctx, syscall_load_input, "load_input", 3));
@@ -492,15 +1021,34 @@ int js_init_module_ckb(JSContext *ctx) {
                       JS_NewCFunction(ctx, syscall_load_header_by_field, "load_header_by_field", 4));
     JS_SetPropertyStr(ctx, ckb, "load_input_by_field",
                       JS_NewCFunction(ctx, syscall_load_input_by_field, "load_input_by_field", 4));
+    for (int i = 0; i < countof(load_into_defs); i++) {
+        JS_SetPropertyStr(ctx, ckb, load_into_defs[i].name,
+                          JS_NewCFunctionMagic(ctx, syscall_load_into, load_into_defs[i].name,
+                                               load_into_defs[i].arg_count + 2, JS_CFUNC_generic_magic, i));
+    }
+    for (int i = 0; i < countof(load_all_defs); i++) {
+        JS_SetPropertyStr(ctx, ckb, load_all_defs[i].name,
+                          JS_NewCFunctionMagic(ctx, syscall_load_all, load_all_defs[i].name,
+                                               load_all_defs[i].has_field ? 2 : 1, JS_CFUNC_generic_magic, i));
+    }
     JS_SetPropertyStr(ctx, ckb, "vm_version", JS_NewCFunction(ctx, syscall_vm_version, "vm_version", 0));
     JS_SetPropertyStr(ctx, ckb, "current_cycles", JS_NewCFunction(ctx, syscall_current_cycles, "current_cycles", 0));
+    JS_SetPropertyStr(ctx, ckb, "set_cycle_budget",
+                      JS_NewCFunction(ctx, syscall_set_cycle_budget, "set_cycle_budget", 2));
     JS_SetPropertyStr(ctx, ckb, "exec_cell", JS_NewCFunction(ctx, syscall_exec_cell, "exec_cell", 4));
     JS_SetPropertyStr(ctx, ckb, "spawn_cell", JS_NewCFunction(ctx, syscall_spawn_cell, "spawn_cell", 3));
+    JS_SetPropertyStr(ctx, ckb, "dlopen", JS_NewCFunction(ctx, syscall_dlopen, "dlopen", 3));
+    JS_SetPropertyStr(ctx, ckb, "dlsym", JS_NewCFunction(ctx, syscall_dlsym, "dlsym", 2));
     JS_SetPropertyStr(ctx, ckb, "set_content", JS_NewCFunction(ctx, syscall_set_content, "set_content", 1));
     JS_SetPropertyStr(ctx, ckb, "get_memory_limit",
                       JS_NewCFunction(ctx, syscall_get_memory_limit, "get_memory_limit", 0));
     JS_SetPropertyStr(ctx, ckb, "current_memory",
                       JS_NewCFunction(ctx, syscall_current_memory, "current_memory", 0));
+    JS_SetPropertyStr(ctx, ckb, "memory_usage", JS_NewCFunction(ctx, syscall_memory_usage, "memory_usage", 0));
+    JS_SetPropertyStr(ctx, ckb, "gc", JS_NewCFunction(ctx, syscall_gc, "gc", 1));
+    JS_SetPropertyStr(ctx, ckb, "set_gc_threshold",
+                      JS_NewCFunction(ctx, syscall_set_gc_threshold, "set_gc_threshold", 1));
+    JS_SetPropertyStr(ctx, ckb, "gc_stats", JS_NewCFunction(ctx, syscall_gc_stats, "gc_stats", 0));
     JS_SetPropertyStr(ctx, ckb, "SOURCE_INPUT", JS_NewInt64(ctx, CKB_SOURCE_INPUT));
     JS_SetPropertyStr(ctx, ckb, "SOURCE_OUTPUT", JS_NewInt64(ctx, CKB_SOURCE_OUTPUT));
     JS_SetPropertyStr(ctx, ckb, "SOURCE_CELL_DEP", JS_NewInt64(ctx, CKB_SOURCE_CELL_DEP));
@@ -2,15 +2,55 @@
 #define _CKB_MODULE_H_
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include "quickjs.h"
 
 int js_init_module_ckb(JSContext *ctx);
+// Size the heap from the memory granted to the script, before anything is allocated. Fails if the memory is too
+// small to hold both the stack and a heap.
+int ckb_init_heap(void);
 int read_local_file(char *buf, int size);
 
+struct LoadData;
+typedef int (*LoadFunc)(void *addr, uint64_t *len, struct LoadData *data);
+
+// The arguments of a load syscall. `length` and `func` are only used by the `ckb.load_` functions.
+typedef struct LoadData {
+    uint64_t length;
+    size_t index;
+    size_t source;
+    size_t offset;
+    size_t field;
+    LoadFunc func;
+} LoadData;
+
+// The load syscalls, called with the arguments they take from LoadData
+int _load_tx_hash(void *addr, uint64_t *len, LoadData *data);
+int _load_transaction(void *addr, uint64_t *len, LoadData *data);
+int _load_script_hash(void *addr, uint64_t *len, LoadData *data);
+int _load_script(void *addr, uint64_t *len, LoadData *data);
+int _load_cell(void *addr, uint64_t *len, LoadData *data);
+int _load_input(void *addr, uint64_t *len, LoadData *data);
+int _load_header(void *addr, uint64_t *len, LoadData *data);
+int _load_witness(void *addr, uint64_t *len, LoadData *data);
+int _load_cell_data(void *addr, uint64_t *len, LoadData *data);
+int _load_cell_by_field(void *addr, uint64_t *len, LoadData *data);
+int _load_header_by_field(void *addr, uint64_t *len, LoadData *data);
+int _load_input_by_field(void *addr, uint64_t *len, LoadData *data);
+
 int load_cell_code_info(size_t *buf_size, size_t *index);
 int load_cell_code(size_t buf_size, size_t index, uint8_t *buf);
+// Stop the script with an uncatchable error once it consumes `budget` more cycles, 0 removes the budget. The
+// budget is checked every `interval` function calls and backward jumps, 0 keeps the current interval.
+void ckb_set_cycle_budget(JSRuntime *rt, uint64_t budget, int interval);
+
+#ifdef CONFIG_PROFILE
+// Profile the bytecode functions with the cycles consumed by the VM, see docs/profiling.md
+int ckb_enable_profile(JSRuntime *rt);
+void ckb_dump_profile(JSRuntime *rt);
+#endif
 
 #endif  // _CKB_MODULE_H_
@@ -0,0 +1,341 @@
+/*
+ * Shortest double to decimal conversion, after Ryu (Ulf Adams, "Ryu: fast
+ * float-to-string conversion", PLDI 2018).
+ *
+ * The target has no floating point unit, so the double is only read as bits
+ * and all the computations are done on 64 and 128 bit integers. The powers of
+ * 5 are computed from a few of them with the small tables of the reference
+ * implementation: 5^i is 5^(26 * b) times 5^(i - 26 * b), plus a correction
+ * of 0 to 3 stored on 2 bits, which makes it exact.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "dtoa.h"
+
+typedef unsigned __int128 dtoa_u128;
+
+#define DOUBLE_MANTISSA_BITS 52
+#define DOUBLE_EXPONENT_BITS 11
+#define DOUBLE_BIAS 1023
+/* bits of the powers of 5 and of their inverses in the tables */
+#define DOUBLE_POW5_BITCOUNT 125
+#define DOUBLE_POW5_INV_BITCOUNT 125
+#define POW5_TABLE_SIZE 26
+
+/* 5^i for i < 26 */
+static const uint64_t dtoa_pow5_table[26] = {
+    1ULL, 5ULL, 25ULL,
+    125ULL, 625ULL, 3125ULL,
+    15625ULL, 78125ULL, 390625ULL,
+    1953125ULL, 9765625ULL, 48828125ULL,
+    244140625ULL, 1220703125ULL, 6103515625ULL,
+    30517578125ULL, 152587890625ULL, 762939453125ULL,
+    3814697265625ULL, 19073486328125ULL, 95367431640625ULL,
+    476837158203125ULL, 2384185791015625ULL, 11920928955078125ULL,
+    59604644775390625ULL, 298023223876953125ULL,
+};
+/* 5^(26 * b), normalized to 125 bits */
+static const uint64_t dtoa_pow5_split[13][2] = {
+    { 0x0000000000000000ULL, 0x1000000000000000ULL },
+    { 0x0000000000000000ULL, 0x14adf4b7320334b9ULL },
+    { 0x0e549208b31adb10ULL, 0x1aba4714957d300dULL },
+    { 0x6dc6ad264d8f0866ULL, 0x1145b7e285bf98f5ULL },
+    { 0xeb1dbd923d8596caULL, 0x1652efdc6018a1fcULL },
+    { 0xb4c1b80b22ae923cULL, 0x1cda62055b2d9d83ULL },
+    { 0x5bb28b4e8f7e4c30ULL, 0x12a5568b9f52f416ULL },
+    { 0xf08aed437682d4fbULL, 0x1819651531f9e78fULL },
+    { 0xb4ee134ad99bf150ULL, 0x1f25c186a6f04c28ULL },
+    { 0x16499ecb70c25f03ULL, 0x1420eb449c8842e6ULL },
+    { 0x85a56ead360865b0ULL, 0x1a03fde214caf085ULL },
+    { 0x093db1d57999890bULL, 0x10cfeb353a97dad8ULL },
+    { 0xcf38bb735e3f36acULL, 0x15baaf44fa52673eULL },
+};
+/* 2^(bits of 5^(26 * b) - 1 + 125) / 5^(26 * b) + 1 */
+static const uint64_t dtoa_pow5_inv_split[13][2] = {
+    { 0x0000000000000001ULL, 0x2000000000000000ULL },
+    { 0x52a6c95fc0655034ULL, 0x18c240c4aecb13bbULL },
+    { 0x7ca8d50071dfc806ULL, 0x1327fc58da0f6ff5ULL },
+    { 0x6520247d3556476eULL, 0x1da48ce468e7c702ULL },
+    { 0x6139cdd76802e6e9ULL, 0x16ef5b40c2fc7779ULL },
+    { 0xf951a7ff43de8c79ULL, 0x11bebdf578b2f391ULL },
+    { 0x7be8bee8d6e957e8ULL, 0x1b758d848fac54b0ULL },
+    { 0x8bd3f9e999a423eaULL, 0x153eda614071a3b7ULL },
+    { 0x0848f973cb3ee3ceULL, 0x10701bd527b4978cULL },
+    { 0x153285ebb9efbfa2ULL, 0x196fbb9bb44db44dULL },
+    { 0xadeee7f86c07b696ULL, 0x13ae3591f5b4d936ULL },
+    { 0x4d686a4eaf182222ULL, 0x1e74404f3daada91ULL },
+    { 0x98c0a106e09ebd9fULL, 0x17900ea4fda7c257ULL },
+};
+/* the corrections of 5^i and of its inverse, 2 bits per i */
+static const uint32_t dtoa_pow5_offsets[21] = {
+    0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x40000000, 0x59695995, 0x55545555, 0x56555515,
+    0x41150504, 0x40555410, 0x44555145, 0x44504540,
+    0x45555550, 0x40004000, 0x96440440, 0x55565565,
+    0x54454045, 0x40154151, 0x55559155, 0x51405555,
+    0x00000105,
+};
+static const uint32_t dtoa_pow5_inv_offsets[19] = {
+    0x54544554, 0x04055545, 0x10041000, 0x00400414,
+    0x40010000, 0x41155555, 0x00000454, 0x00010044,
+    0x40000000, 0x44000041, 0x50454450, 0x55550054,
+    0x51655554, 0x40004000, 0x01000001, 0x00010500,
+    0x51515411, 0x05555554, 0x00000000,
+};
+
+/* number of bits of 5^e, 1 for e = 0, valid for 0 <= e <= 3528 */
+static inline int32_t pow5bits(int32_t e)
+{
+    return (int32_t)(((uint32_t)e * 1217359) >> 19) + 1;
+}
+
+/* floor(log10(2^e)) for 0 <= e <= 1650 */
+static inline uint32_t log10_pow2(int32_t e)
+{
+    return ((uint32_t)e * 78913) >> 18;
+}
+
+/* floor(log10(5^e)) for 0 <= e <= 2620 */
+static inline uint32_t log10_pow5(int32_t e)
+{
+    return ((uint32_t)e * 732923) >> 20;
+}
+
+static inline uint32_t pow5_factor(uint64_t v)
+{
+    uint32_t count = 0;
+    while (v % 5 == 0) {
+        v /= 5;
+        count++;
+    }
+    return count;
+}
+
+static inline bool multiple_of_pow5(uint64_t v, uint32_t p)
+{
+    return pow5_factor(v) >= p;
+}
+
+static inline bool multiple_of_pow2(uint64_t v, uint32_t p)
+{
+    return (v & ((1ULL << p) - 1)) == 0;
+}
+
+/* 5^i normalized to 125 bits, for 0 <= i <= 325 */
+static void compute_pow5(uint32_t i, uint64_t *result)
+{
+    uint32_t base = i / POW5_TABLE_SIZE;
+    uint32_t base2 = base * POW5_TABLE_SIZE;
+    uint32_t offset = i - base2;
+    const uint64_t *mul = dtoa_pow5_split[base];
+    uint64_t m;
+    uint32_t delta;
+    dtoa_u128 b0, b2, sum;
+
+    if (offset == 0) {
+        result[0] = mul[0];
+        result[1] = mul[1];
+        return;
+    }
+    m = dtoa_pow5_table[offset];
+    b0 = (dtoa_u128)m * mul[0];
+    b2 = (dtoa_u128)m * mul[1];
+    delta = pow5bits(i) - pow5bits(base2);
+    sum = (b0 >> delta) + (b2 << (64 - delta)) +
+        ((dtoa_pow5_offsets[i / 16] >> ((i % 16) << 1)) & 3);
+    result[0] = (uint64_t)sum;
+    result[1] = (uint64_t)(sum >> 64);
+}
+
+/* 2^(pow5bits(i) - 1 + 125) / 5^i + 1, for 0 <= i <= 291 */
+static void compute_inv_pow5(uint32_t i, uint64_t *result)
+{
+    uint32_t base = (i + POW5_TABLE_SIZE - 1) / POW5_TABLE_SIZE;
+    uint32_t base2 = base * POW5_TABLE_SIZE;
+    uint32_t offset = base2 - i;
+    const uint64_t *mul = dtoa_pow5_inv_split[base];
+    uint64_t m;
+    uint32_t delta;
+    dtoa_u128 b0, b2, sum;
+
+    if (offset == 0) {
+        result[0] = mul[0];
+        result[1] = mul[1];
+        return;
+    }
+    m = dtoa_pow5_table[offset];
+    b0 = (dtoa_u128)m * (mul[0] - 1);
+    b2 = (dtoa_u128)m * mul[1];
+    delta = pow5bits(base2) - pow5bits(i);
+    sum = (b0 >> delta) + (b2 << (64 - delta)) + 1 +
+        ((dtoa_pow5_inv_offsets[i / 16] >> ((i % 16) << 1)) & 3);
+    result[0] = (uint64_t)sum;
+    result[1] = (uint64_t)(sum >> 64);
+}
+
+/* (m * mul) >> j, with 64 < j < 128 and a result below 2^64 */
+static inline uint64_t mul_shift64(uint64_t m, const uint64_t *mul, int32_t j)
+{
+    dtoa_u128 b0 = (dtoa_u128)m * mul[0];
+    dtoa_u128 b2 = (dtoa_u128)m * mul[1];
+    return (uint64_t)(((b0 >> 64) + b2) >> (j - 64));
+}
+
+/* Return the decimal mantissa of the shortest representation of
+   m2 * 2^e2 and store its exponent in *e10. */
+static uint64_t shortest(uint64_t ieee_mantissa, uint32_t ieee_exponent,
+                         int32_t *e10)
+{
+    int32_t e2, removed, exp;
+    uint64_t m2, mv, vr, vp, vm, output;
+    uint64_t mul[2];
+    uint32_t mm_shift, q;
+    bool accept_bounds, vm_trailing_zeros, vr_trailing_zeros;
+    uint8_t last_removed_digit;
+
+    if (ieee_exponent == 0) {
+        e2 = 1 - DOUBLE_BIAS - DOUBLE_MANTISSA_BITS - 2;
+        m2 = ieee_mantissa;
+    } else {
+        e2 = (int32_t)ieee_exponent - DOUBLE_BIAS - DOUBLE_MANTISSA_BITS - 2;
+        m2 = (1ULL << DOUBLE_MANTISSA_BITS) | ieee_mantissa;
+    }
+    /* the bounds of the interval round to d when m2 is even (round to
+       nearest, ties to even) */
+    accept_bounds = (m2 & 1) == 0;
+
+    /* the interval is [4 * m2 - 1 - mm_shift, 4 * m2 + 2] * 2^e2: its lower
+       bound is closer when d is a power of 2 */
+    mv = 4 * m2;
+    mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+
+    /* convert the interval to a decimal power */
+    vm_trailing_zeros = false;
+    vr_trailing_zeros = false;
+    if (e2 >= 0) {
+        int32_t k, i;
+        q = log10_pow2(e2) - (e2 > 3);
+        exp = (int32_t)q;
+        k = DOUBLE_POW5_INV_BITCOUNT + pow5bits((int32_t)q) - 1;
+        i = -e2 + (int32_t)q + k;
+        compute_inv_pow5(q, mul);
+        vr = mul_shift64(4 * m2, mul, i);
+        vp = mul_shift64(4 * m2 + 2, mul, i);
+        vm = mul_shift64(4 * m2 - 1 - mm_shift, mul, i);
+        if (q <= 21) {
+            /* only one of mp, mv and mm can be a multiple of 5 */
+            if (mv % 5 == 0)
+                vr_trailing_zeros = multiple_of_pow5(mv, q);
+            else if (accept_bounds)
+                vm_trailing_zeros = multiple_of_pow5(mv - 1 - mm_shift, q);
+            else
+                vp -= multiple_of_pow5(mv + 2, q);
+        }
+    } else {
+        int32_t i, k, j;
+        q = log10_pow5(-e2) - (-e2 > 1);
+        exp = (int32_t)q + e2;
+        i = -e2 - (int32_t)q;
+        k = pow5bits(i) - DOUBLE_POW5_BITCOUNT;
+        j = (int32_t)q - k;
+        compute_pow5(i, mul);
+        vr = mul_shift64(4 * m2, mul, j);
+        vp = mul_shift64(4 * m2 + 2, mul, j);
+        vm = mul_shift64(4 * m2 - 1 - mm_shift, mul, j);
+        if (q <= 1) {
+            /* mv = 4 * m2 has at least 2 trailing zero bits */
+            vr_trailing_zeros = true;
+            if (accept_bounds)
+                vm_trailing_zeros = mm_shift == 1;
+            else
+                vp--;
+        } else if (q < 63) {
+            vr_trailing_zeros = multiple_of_pow2(mv, q);
+        }
+    }
+
+    /* remove the digits while vp and vm differ */
+    removed = 0;
+    last_removed_digit = 0;
+    if (vm_trailing_zeros || vr_trailing_zeros) {
+        /* rare: the exact value of a bound or of d may be taken */
+        while (vp / 10 > vm / 10) {
+            vm_trailing_zeros &= vm % 10 == 0;
+            vr_trailing_zeros &= last_removed_digit == 0;
+            last_removed_digit = vr % 10;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        if (vm_trailing_zeros) {
+            while (vm % 10 == 0) {
+                vr_trailing_zeros &= last_removed_digit == 0;
+                last_removed_digit = vr % 10;
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed++;
+            }
+        }
+        /* round to even if the exact value is ...50...0 */
+        if (vr_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0)
+            last_removed_digit = 4;
+        output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) ||
+                       last_removed_digit >= 5);
+    } else {
+        bool round_up = false;
+        if (vp / 100 > vm / 100) {
+            round_up = vr % 100 >= 50;
+            vr /= 100;
+            vp /= 100;
+            vm /= 100;
+            removed += 2;
+        }
+        while (vp / 10 > vm / 10) {
+            round_up = vr % 10 >= 5;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        output = vr + (vr == vm || round_up);
+    }
+    *e10 = exp + removed;
+    return output;
+}
+
+int dtoa_shortest(char *buf, int *decpt, int *sign, double d)
+{
+    uint64_t bits, mantissa, output;
+    uint32_t exponent;
+    int32_t e10;
+    int len, i;
+
+    memcpy(&bits, &d, sizeof(bits));
+    *sign = bits >> 63;
+    mantissa = bits & ((1ULL << DOUBLE_MANTISSA_BITS) - 1);
+    exponent = (bits >> DOUBLE_MANTISSA_BITS) & ((1u << DOUBLE_EXPONENT_BITS) - 1);
+    if (exponent == 0 && mantissa == 0) {
+        buf[0] = '0';
+        *decpt = 1;
+        return 1;
+    }
+    output = shortest(mantissa, exponent, &e10);
+    /* remove the trailing zeros, d = output * 10^e10 */
+    while (output % 10 == 0) {
+        output /= 10;
+        e10++;
+    }
+    len = 0;
+    for (uint64_t v = output; v != 0; v /= 10)
+        len++;
+    for (i = len - 1; i >= 0; i--) {
+        buf[i] = '0' + output % 10;
+        output /= 10;
+    }
+    *decpt = e10 + len;
+    return len;
+}
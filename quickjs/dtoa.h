@@ -0,0 +1,12 @@
+#ifndef _DTOA_H_
+#define _DTOA_H_
+
+/* Shortest decimal digits that read back as the finite double d, computed
+   with integer arithmetic only (Ryu). They are stored in buf as characters,
+   without trailing zeros and not null terminated, so that
+   |d| = 0.buf * 10^decpt. Return the number of digits, at most
+   DTOA_SHORTEST_MAX. 0 is "0" with decpt = 1. */
+#define DTOA_SHORTEST_MAX 17
+int dtoa_shortest(char *buf, int *decpt, int *sign, double d);
+
+#endif  // _DTOA_H_
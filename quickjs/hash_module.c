@@ -0,0 +1,578 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "cutils.h"
+#include "hash_module.h"
+#include "ckb_module.h"
+#include "blake2b.h"
+
+// Streaming hashers: blake2b (and ckbhash, blake2b-256 with the CKB personalization), sha256 and keccak256. Data is
+// hashed straight from the ArrayBuffer or from the syscalls, without being copied into a JS object first.
+
+#define CKB_HASH_PERSONALIZATION "ckb-default-hash"
+#define HASH_MAX_DIGEST_SIZE 64
+// size of the chunks of syscall data hashed at once
+#define HASH_LOAD_CHUNK_SIZE 4096
+
+typedef struct Sha256State {
+    uint32_t h[8];
+    uint64_t length;
+    uint8_t buf[64];
+    uint32_t buf_len;
+} Sha256State;
+
+#define KECCAK256_RATE 136
+
+typedef struct Keccak256State {
+    uint64_t a[25];
+    uint8_t buf[KECCAK256_RATE];
+    uint32_t buf_len;
+} Keccak256State;
+
+typedef enum HashKind {
+    HashKindBlake2b,
+    HashKindSha256,
+    HashKindKeccak256,
+} HashKind;
+
+typedef struct Hasher {
+    HashKind kind;
+    bool finalized;
+    uint32_t digest_size;
+    union {
+        blake2b_state blake2b;
+        Sha256State sha256;
+        Keccak256State keccak256;
+    } u;
+} Hasher;
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline uint32_t ror32(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+static inline uint64_t rol64(uint64_t x, int n) { return (x << n) | (x >> (64 - n)); }
+
+static void sha256_init(Sha256State *s) {
+    static const uint32_t h[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                  0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    memcpy(s->h, h, sizeof(h));
+    s->length = 0;
+    s->buf_len = 0;
+}
+
+static void sha256_compress(uint32_t h[8], const uint8_t *p) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t)p[i * 4] << 24 | (uint32_t)p[i * 4 + 1] << 16 | (uint32_t)p[i * 4 + 2] << 8 | p[i * 4 + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = ror32(w[i - 15], 7) ^ ror32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = ror32(w[i - 2], 17) ^ ror32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = hh + (ror32(e, 6) ^ ror32(e, 11) ^ ror32(e, 25)) + ((e & f) ^ (~e & g)) + sha256_k[i] + w[i];
+        uint32_t t2 = (ror32(a, 2) ^ ror32(a, 13) ^ ror32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        hh = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+    h[5] += f;
+    h[6] += g;
+    h[7] += hh;
+}
+
+static void sha256_update(Sha256State *s, const uint8_t *data, size_t len) {
+    s->length += len;
+    if (s->buf_len > 0) {
+        size_t n = len < sizeof(s->buf) - s->buf_len ? len : sizeof(s->buf) - s->buf_len;
+        memcpy(s->buf + s->buf_len, data, n);
+        s->buf_len += n;
+        data += n;
+        len -= n;
+        if (s->buf_len < sizeof(s->buf)) {
+            return;
+        }
+        sha256_compress(s->h, s->buf);
+        s->buf_len = 0;
+    }
+    for (; len >= sizeof(s->buf); data += sizeof(s->buf), len -= sizeof(s->buf)) {
+        sha256_compress(s->h, data);
+    }
+    memcpy(s->buf, data, len);
+    s->buf_len = len;
+}
+
+static void sha256_final(Sha256State *s, uint8_t *out) {
+    uint64_t bits = s->length * 8;
+    uint8_t pad[72] = {0x80};
+    // pad to 56 bytes modulo 64, then append the length in bits
+    size_t pad_len = (s->buf_len < 56 ? 56 : 120) - s->buf_len;
+    for (int i = 0; i < 8; i++) {
+        pad[pad_len + i] = (uint8_t)(bits >> (56 - i * 8));
+    }
+    sha256_update(s, pad, pad_len + 8);
+    for (int i = 0; i < 8; i++) {
+        out[i * 4] = (uint8_t)(s->h[i] >> 24);
+        out[i * 4 + 1] = (uint8_t)(s->h[i] >> 16);
+        out[i * 4 + 2] = (uint8_t)(s->h[i] >> 8);
+        out[i * 4 + 3] = (uint8_t)s->h[i];
+    }
+}
+
+static const uint64_t keccak_rc[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL, 0x8000000080008000ULL,
+    0x000000000000808bULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+    0x000000000000008aULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+    0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800aULL, 0x800000008000000aULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL,
+};
+
+static const uint8_t keccak_rotc[24] = {1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14, 27, 41, 56, 8, 25, 43, 62, 18,
+                                        39, 61, 20, 44};
+
+static const uint8_t keccak_piln[24] = {10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4, 15, 23, 19, 13, 12, 2, 20, 14,
+                                        22, 9, 6, 1};
+
+static void keccakf(uint64_t a[25]) {
+    uint64_t bc[5], t;
+    for (int round = 0; round < 24; round++) {
+        // theta
+        for (int i = 0; i < 5; i++) {
+            bc[i] = a[i] ^ a[i + 5] ^ a[i + 10] ^ a[i + 15] ^ a[i + 20];
+        }
+        for (int i = 0; i < 5; i++) {
+            t = bc[(i + 4) % 5] ^ rol64(bc[(i + 1) % 5], 1);
+            for (int j = 0; j < 25; j += 5) {
+                a[j + i] ^= t;
+            }
+        }
+        // rho and pi
+        t = a[1];
+        for (int i = 0; i < 24; i++) {
+            int j = keccak_piln[i];
+            bc[0] = a[j];
+            a[j] = rol64(t, keccak_rotc[i]);
+            t = bc[0];
+        }
+        // chi
+        for (int j = 0; j < 25; j += 5) {
+            for (int i = 0; i < 5; i++) {
+                bc[i] = a[j + i];
+            }
+            for (int i = 0; i < 5; i++) {
+                a[j + i] ^= ~bc[(i + 1) % 5] & bc[(i + 2) % 5];
+            }
+        }
+        // iota
+        a[0] ^= keccak_rc[round];
+    }
+}
+
+static void keccak256_absorb(Keccak256State *s, const uint8_t *block) {
+    for (int i = 0; i < KECCAK256_RATE / 8; i++) {
+        uint64_t lane = 0;
+        for (int j = 7; j >= 0; j--) {
+            lane = lane << 8 | block[i * 8 + j];
+        }
+        s->a[i] ^= lane;
+    }
+    keccakf(s->a);
+}
+
+static void keccak256_init(Keccak256State *s) {
+    memset(s->a, 0, sizeof(s->a));
+    s->buf_len = 0;
+}
+
+static void keccak256_update(Keccak256State *s, const uint8_t *data, size_t len) {
+    if (s->buf_len > 0) {
+        size_t n = len < KECCAK256_RATE - s->buf_len ? len : KECCAK256_RATE - s->buf_len;
+        memcpy(s->buf + s->buf_len, data, n);
+        s->buf_len += n;
+        data += n;
+        len -= n;
+        if (s->buf_len < KECCAK256_RATE) {
+            return;
+        }
+        keccak256_absorb(s, s->buf);
+        s->buf_len = 0;
+    }
+    for (; len >= KECCAK256_RATE; data += KECCAK256_RATE, len -= KECCAK256_RATE) {
+        keccak256_absorb(s, data);
+    }
+    memcpy(s->buf, data, len);
+    s->buf_len = len;
+}
+
+// The original keccak padding used by Ethereum, not the one of SHA-3
+static void keccak256_final(Keccak256State *s, uint8_t *out) {
+    memset(s->buf + s->buf_len, 0, KECCAK256_RATE - s->buf_len);
+    s->buf[s->buf_len] ^= 0x01;
+    s->buf[KECCAK256_RATE - 1] ^= 0x80;
+    keccak256_absorb(s, s->buf);
+    for (int i = 0; i < 32; i++) {
+        out[i] = (uint8_t)(s->a[i / 8] >> (8 * (i % 8)));
+    }
+}
+
+static void hasher_update(Hasher *h, const uint8_t *data, size_t len) {
+    switch (h->kind) {
+        case HashKindBlake2b:
+            blake2b_update(&h->u.blake2b, data, len);
+            break;
+        case HashKindSha256:
+            sha256_update(&h->u.sha256, data, len);
+            break;
+        case HashKindKeccak256:
+            keccak256_update(&h->u.keccak256, data, len);
+            break;
+    }
+}
+
+static void hasher_final(Hasher *h, uint8_t *out) {
+    switch (h->kind) {
+        case HashKindBlake2b:
+            blake2b_final(&h->u.blake2b, out, h->digest_size);
+            break;
+        case HashKindSha256:
+            sha256_final(&h->u.sha256, out);
+            break;
+        case HashKindKeccak256:
+            keccak256_final(&h->u.keccak256, out);
+            break;
+    }
+    h->finalized = true;
+}
+
+static JSClassID js_hasher_class_id;
+
+static void js_hasher_finalizer(JSRuntime *rt, JSValue val) {
+    Hasher *h = JS_GetOpaque(val, js_hasher_class_id);
+    js_free_rt(rt, h);
+}
+
+static JSClassDef js_hasher_class = {
+    "Hasher",
+    .finalizer = js_hasher_finalizer,
+};
+
+static JSValue js_hasher_new(JSContext *ctx, HashKind kind, Hasher **ph) {
+    JSValue obj = JS_NewObjectClass(ctx, js_hasher_class_id);
+    if (JS_IsException(obj)) {
+        return obj;
+    }
+    Hasher *h = js_mallocz(ctx, sizeof(Hasher));
+    if (!h) {
+        JS_FreeValue(ctx, obj);
+        return JS_EXCEPTION;
+    }
+    h->kind = kind;
+    JS_SetOpaque(obj, h);
+    *ph = h;
+    return obj;
+}
+
+// Get the hasher `obj`, which must not be finalized yet
+static Hasher *js_get_hasher(JSContext *ctx, JSValueConst obj) {
+    Hasher *h = JS_GetOpaque2(ctx, obj, js_hasher_class_id);
+    if (h && h->finalized) {
+        JS_ThrowTypeError(ctx, "hasher already finalized");
+        return NULL;
+    }
+    return h;
+}
+
+// hash.blake2b(digest_size, personal): a blake2b hasher, digest_size defaults to 32 bytes and personal, a string or a
+// buffer of at most 16 bytes, to none
+static JSValue js_hash_blake2b(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    blake2b_param param;
+    int32_t digest_size = 32;
+    Hasher *h = NULL;
+
+    memset(&param, 0, sizeof(param));
+    if (argc > 0 && !JS_IsUndefined(argv[0]) && JS_ToInt32(ctx, &digest_size, argv[0])) {
+        return JS_EXCEPTION;
+    }
+    if (digest_size < 1 || digest_size > HASH_MAX_DIGEST_SIZE) {
+        return JS_ThrowRangeError(ctx, "invalid digest size");
+    }
+    if (argc > 1 && !JS_IsUndefined(argv[1])) {
+        size_t len = 0;
+        if (JS_IsString(argv[1])) {
+            const char *str = JS_ToCStringLen(ctx, &len, argv[1]);
+            if (!str) {
+                return JS_EXCEPTION;
+            }
+            if (len <= sizeof(param.personal)) {
+                memcpy(param.personal, str, len);
+            }
+            JS_FreeCString(ctx, str);
+        } else {
+            uint8_t *buf = JS_GetArrayBufferView(ctx, &len, argv[1]);
+            if (!buf) {
+                return JS_EXCEPTION;
+            }
+            if (len <= sizeof(param.personal)) {
+                memcpy(param.personal, buf, len);
+            }
+        }
+        if (len > sizeof(param.personal)) {
+            return JS_ThrowRangeError(ctx, "personalization longer than 16 bytes");
+        }
+    }
+    param.digest_length = digest_size;
+    param.fanout = 1;
+    param.depth = 1;
+
+    JSValue obj = js_hasher_new(ctx, HashKindBlake2b, &h);
+    if (JS_IsException(obj)) {
+        return obj;
+    }
+    h->digest_size = digest_size;
+    blake2b_init_param(&h->u.blake2b, &param);
+    return obj;
+}
+
+// hash.ckbhash(): the blake2b-256 hasher used for the hashes of CKB
+static JSValue js_hash_ckbhash(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    JSValueConst args[2] = {JS_NewInt32(ctx, 32), JS_NewString(ctx, CKB_HASH_PERSONALIZATION)};
+    JSValue ret = js_hash_blake2b(ctx, this_val, 2, args);
+    JS_FreeValue(ctx, args[1]);
+    return ret;
+}
+
+static JSValue js_hash_sha256(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    Hasher *h = NULL;
+    JSValue obj = js_hasher_new(ctx, HashKindSha256, &h);
+    if (JS_IsException(obj)) {
+        return obj;
+    }
+    h->digest_size = 32;
+    sha256_init(&h->u.sha256);
+    return obj;
+}
+
+static JSValue js_hash_keccak256(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    Hasher *h = NULL;
+    JSValue obj = js_hasher_new(ctx, HashKindKeccak256, &h);
+    if (JS_IsException(obj)) {
+        return obj;
+    }
+    h->digest_size = 32;
+    keccak256_init(&h->u.keccak256);
+    return obj;
+}
+
+// hasher.update(data): hash an ArrayBuffer, a TypedArray, a DataView or a string (as UTF-8), returns the hasher
+static JSValue js_hasher_update(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    Hasher *h = js_get_hasher(ctx, this_val);
+    if (!h) {
+        return JS_EXCEPTION;
+    }
+    size_t len = 0;
+    if (JS_IsString(argv[0])) {
+        const char *str = JS_ToCStringLen(ctx, &len, argv[0]);
+        if (!str) {
+            return JS_EXCEPTION;
+        }
+        hasher_update(h, (const uint8_t *)str, len);
+        JS_FreeCString(ctx, str);
+    } else {
+        uint8_t *buf = JS_GetArrayBufferView(ctx, &len, argv[0]);
+        if (!buf) {
+            return JS_EXCEPTION;
+        }
+        hasher_update(h, buf, len);
+    }
+    return JS_DupValue(ctx, this_val);
+}
+
+// hasher.finalize(): the digest as an ArrayBuffer, the hasher can't be used afterwards
+static JSValue js_hasher_finalize(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    uint8_t digest[HASH_MAX_DIGEST_SIZE];
+    Hasher *h = js_get_hasher(ctx, this_val);
+    if (!h) {
+        return JS_EXCEPTION;
+    }
+    hasher_final(h, digest);
+    return JS_NewArrayBufferCopy(ctx, digest, h->digest_size);
+}
+
+static JSValue js_hasher_get_digest_size(JSContext *ctx, JSValueConst this_val) {
+    Hasher *h = JS_GetOpaque2(ctx, this_val, js_hasher_class_id);
+    if (!h) {
+        return JS_EXCEPTION;
+    }
+    return JS_NewUint32(ctx, h->digest_size);
+}
+
+// The `update_` methods of a hasher hash the data of a load syscall, loaded in chunks by partial loading, so large
+// data is never held in memory at once. Their arguments are described as:
+// argument 1..: index, source and field, as in the `ckb.load_` function (only those the syscall takes)
+// argument n: offset in the data (optional, default to 0)
+// The return value is the number of bytes hashed.
+typedef struct HashLoadDef {
+    const char *name;
+    LoadFunc func;
+    // number of index/source/field arguments
+    int arg_count;
+} HashLoadDef;
+
+static const HashLoadDef hash_load_defs[] = {
+    {"update_tx_hash", _load_tx_hash, 0},
+    {"update_transaction", _load_transaction, 0},
+    {"update_script_hash", _load_script_hash, 0},
+    {"update_script", _load_script, 0},
+    {"update_cell", _load_cell, 2},
+    {"update_input", _load_input, 2},
+    {"update_header", _load_header, 2},
+    {"update_witness", _load_witness, 2},
+    {"update_cell_data", _load_cell_data, 2},
+    {"update_cell_by_field", _load_cell_by_field, 3},
+    {"update_header_by_field", _load_header_by_field, 3},
+    {"update_input_by_field", _load_input_by_field, 3},
+};
+
+static JSValue js_hasher_update_load(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv, int magic) {
+    int err = 0;
+    const HashLoadDef *def = &hash_load_defs[magic];
+    // index/source/field, offset in the data
+    int64_t args[4] = {0};
+    uint8_t chunk[HASH_LOAD_CHUNK_SIZE];
+
+    Hasher *h = js_get_hasher(ctx, this_val);
+    if (!h) {
+        return JS_EXCEPTION;
+    }
+    for (int i = 0; i < argc && i <= def->arg_count; i++) {
+        err = JS_ToInt64Ext(ctx, &args[i], argv[i]);
+        CHECK(err);
+    }
+    LoadData load_args = {
+        .offset = args[def->arg_count],
+    };
+    if (def->arg_count >= 2) {
+        load_args.index = args[0];
+        load_args.source = args[1];
+    }
+    if (def->arg_count >= 3) {
+        load_args.field = args[2];
+    }
+    size_t start = load_args.offset;
+    for (;;) {
+        uint64_t len = sizeof(chunk);
+        err = def->func(chunk, &len, &load_args);
+        CHECK(err);
+        // len is the length of the remaining data, which may be larger than the chunk
+        size_t n = len < sizeof(chunk) ? len : sizeof(chunk);
+        hasher_update(h, chunk, n);
+        load_args.offset += n;
+        if (len <= sizeof(chunk)) {
+            break;
+        }
+    }
+exit:
+    if (err != 0) {
+        return JS_EXCEPTION;
+    }
+    return JS_NewInt64(ctx, (int64_t)(load_args.offset - start));
+}
+
+static const JSCFunctionListEntry js_hasher_proto_funcs[] = {
+    JS_CGETSET_DEF("digest_size", js_hasher_get_digest_size, NULL),
+    JS_CFUNC_DEF("update", 1, js_hasher_update),
+    JS_CFUNC_DEF("finalize", 0, js_hasher_finalize),
+};
+
+static const JSCFunctionListEntry js_hash_funcs[] = {
+    JS_CFUNC_DEF("blake2b", 2, js_hash_blake2b),
+    JS_CFUNC_DEF("ckbhash", 0, js_hash_ckbhash),
+    JS_CFUNC_DEF("sha256", 0, js_hash_sha256),
+    JS_CFUNC_DEF("keccak256", 0, js_hash_keccak256),
+};
+
+// Register the class, once per runtime, and create the prototype of the hashers, once per context
+static int js_hash_init_context(JSContext *ctx) {
+    JSRuntime *rt = JS_GetRuntime(ctx);
+
+    if (!JS_IsRegisteredClass(rt, js_hasher_class_id)) {
+        JS_NewClassID(&js_hasher_class_id);
+        if (JS_NewClass(rt, js_hasher_class_id, &js_hasher_class)) {
+            return -1;
+        }
+    }
+    JSValue proto = JS_GetClassProto(ctx, js_hasher_class_id);
+    if (JS_IsObject(proto)) {
+        JS_FreeValue(ctx, proto);
+        return 0;
+    }
+    proto = JS_NewObject(ctx);
+    if (JS_IsException(proto)) {
+        return -1;
+    }
+    JS_SetPropertyFunctionList(ctx, proto, js_hasher_proto_funcs, countof(js_hasher_proto_funcs));
+    for (int i = 0; i < countof(hash_load_defs); i++) {
+        JS_SetPropertyStr(ctx, proto, hash_load_defs[i].name,
+                          JS_NewCFunctionMagic(ctx, js_hasher_update_load, hash_load_defs[i].name,
+                                               hash_load_defs[i].arg_count, JS_CFUNC_generic_magic, i));
+    }
+    JS_SetClassProto(ctx, js_hasher_class_id, proto);
+    return 0;
+}
+
+static JSValue js_hash_global_init(JSContext *ctx, JSAtom prop) {
+    if (js_hash_init_context(ctx)) {
+        return JS_EXCEPTION;
+    }
+    JSValue hash = JS_NewObject(ctx);
+    if (JS_IsException(hash)) {
+        return hash;
+    }
+    JS_SetPropertyFunctionList(ctx, hash, js_hash_funcs, countof(js_hash_funcs));
+    return hash;
+}
+
+static int js_hash_module_init(JSContext *ctx, JSModuleDef *m) {
+    if (js_hash_init_context(ctx)) {
+        return -1;
+    }
+    return JS_SetModuleExportList(ctx, m, js_hash_funcs, countof(js_hash_funcs));
+}
+
+int js_init_module_hash(JSContext *ctx) {
+    JSValue global_obj = JS_GetGlobalObject(ctx);
+    int ret = JS_DefineLazyPropertyStr(ctx, global_obj, "hash", js_hash_global_init,
+                                       JS_PROP_WRITABLE | JS_PROP_CONFIGURABLE);
+    JS_FreeValue(ctx, global_obj);
+    return ret < 0 ? -1 : 0;
+}
+
+JSModuleDef *js_new_module_hash(JSContext *ctx, const char *module_name) {
+    JSModuleDef *m = JS_NewCModule(ctx, module_name, js_hash_module_init);
+    if (!m || JS_AddModuleExportList(ctx, m, js_hash_funcs, countof(js_hash_funcs))) {
+        return NULL;
+    }
+    return m;
+}
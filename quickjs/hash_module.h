@@ -0,0 +1,12 @@
+#ifndef _HASH_MODULE_H_
+#define _HASH_MODULE_H_
+
+#include "quickjs.h"
+
+// The hash module is available both as the global object `hash` and as the "hash" ES module. Both are created when
+// they are first used.
+int js_init_module_hash(JSContext *ctx);
+// Called by the module loader when "hash" is first imported
+JSModuleDef *js_new_module_hash(JSContext *ctx, const char *module_name);
+
+#endif  // _HASH_MODULE_H_
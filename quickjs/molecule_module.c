@@ -0,0 +1,980 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "cutils.h"
+#include "molecule_module.h"
+#include "molecule/molecule_reader.h"
+
+// Zero-copy Molecule reader. A cursor references a range of an ArrayBuffer, the data is never copied: reading a field
+// or an item returns a new cursor over the same buffer. Since scripts can still write into the buffer after it has
+// been verified, every access checks the offsets it depends on and never reads outside of the cursor.
+
+typedef enum MolKind {
+    MolKindByte,    // byte, read as a number
+    MolKindUint32,  // [byte; 4], read as a number
+    MolKindUint64,  // [byte; 8], read as a BigInt
+    MolKindArray,   // array or struct
+    MolKindFixVec,  // fixvec, a fixvec of bytes is read as a cursor over its raw bytes
+    MolKindDynVec,
+    MolKindTable,
+    MolKindOption,  // read as undefined when none
+} MolKind;
+
+// Prototypes of the typed cursors, MolProtoNone is Cursor.prototype
+enum {
+    MolProtoNone,
+    MolProtoOutPoint,
+    MolProtoCellInput,
+    MolProtoCellDep,
+    MolProtoScript,
+    MolProtoCellOutput,
+    MolProtoWitnessArgs,
+    MolProtoRawTransaction,
+    MolProtoTransaction,
+    MolProtoBytesVec,
+    MolProtoByte32Vec,
+    MolProtoCellDepVec,
+    MolProtoCellInputVec,
+    MolProtoCellOutputVec,
+    MolProtoCount,
+};
+
+typedef struct MolType MolType;
+
+typedef struct MolField {
+    const char *name;
+    const MolType *type;
+    // offset in a struct
+    uint32_t offset;
+} MolField;
+
+struct MolType {
+    const char *name;
+    MolKind kind;
+    // size of a fixed size type
+    uint32_t size;
+    // item type of vectors and options
+    const MolType *item;
+    // fields of structs and tables
+    const MolField *fields;
+    uint32_t field_count;
+    int proto;
+};
+
+// The types of blockchain.mol used by scripts
+static const MolType mol_byte = {.name = "byte", .kind = MolKindByte, .size = 1};
+static const MolType mol_Uint32 = {.name = "Uint32", .kind = MolKindUint32, .size = 4};
+static const MolType mol_Uint64 = {.name = "Uint64", .kind = MolKindUint64, .size = 8};
+static const MolType mol_Byte32 = {.name = "Byte32", .kind = MolKindArray, .size = 32};
+static const MolType mol_Bytes = {.name = "Bytes", .kind = MolKindFixVec, .item = &mol_byte};
+static const MolType mol_BytesOpt = {.name = "BytesOpt", .kind = MolKindOption, .item = &mol_Bytes};
+
+static const MolType mol_BytesVec = {
+    .name = "BytesVec", .kind = MolKindDynVec, .item = &mol_Bytes, .proto = MolProtoBytesVec};
+static const MolType mol_Byte32Vec = {
+    .name = "Byte32Vec", .kind = MolKindFixVec, .item = &mol_Byte32, .proto = MolProtoByte32Vec};
+
+static const MolField mol_OutPoint_fields[] = {
+    {"tx_hash", &mol_Byte32, 0},
+    {"index", &mol_Uint32, 32},
+};
+static const MolType mol_OutPoint = {.name = "OutPoint",
+                                     .kind = MolKindArray,
+                                     .size = 36,
+                                     .fields = mol_OutPoint_fields,
+                                     .field_count = countof(mol_OutPoint_fields),
+                                     .proto = MolProtoOutPoint};
+
+static const MolField mol_CellInput_fields[] = {
+    {"since", &mol_Uint64, 0},
+    {"previous_output", &mol_OutPoint, 8},
+};
+static const MolType mol_CellInput = {.name = "CellInput",
+                                      .kind = MolKindArray,
+                                      .size = 44,
+                                      .fields = mol_CellInput_fields,
+                                      .field_count = countof(mol_CellInput_fields),
+                                      .proto = MolProtoCellInput};
+static const MolType mol_CellInputVec = {
+    .name = "CellInputVec", .kind = MolKindFixVec, .item = &mol_CellInput, .proto = MolProtoCellInputVec};
+
+static const MolField mol_CellDep_fields[] = {
+    {"out_point", &mol_OutPoint, 0},
+    {"dep_type", &mol_byte, 36},
+};
+static const MolType mol_CellDep = {.name = "CellDep",
+                                    .kind = MolKindArray,
+                                    .size = 37,
+                                    .fields = mol_CellDep_fields,
+                                    .field_count = countof(mol_CellDep_fields),
+                                    .proto = MolProtoCellDep};
+static const MolType mol_CellDepVec = {
+    .name = "CellDepVec", .kind = MolKindFixVec, .item = &mol_CellDep, .proto = MolProtoCellDepVec};
+
+static const MolField mol_Script_fields[] = {
+    {"code_hash", &mol_Byte32},
+    {"hash_type", &mol_byte},
+    {"args", &mol_Bytes},
+};
+static const MolType mol_Script = {.name = "Script",
+                                   .kind = MolKindTable,
+                                   .fields = mol_Script_fields,
+                                   .field_count = countof(mol_Script_fields),
+                                   .proto = MolProtoScript};
+static const MolType mol_ScriptOpt = {.name = "ScriptOpt", .kind = MolKindOption, .item = &mol_Script};
+
+static const MolField mol_CellOutput_fields[] = {
+    {"capacity", &mol_Uint64},
+    {"lock", &mol_Script},
+    {"type", &mol_ScriptOpt},
+};
+static const MolType mol_CellOutput = {.name = "CellOutput",
+                                       .kind = MolKindTable,
+                                       .fields = mol_CellOutput_fields,
+                                       .field_count = countof(mol_CellOutput_fields),
+                                       .proto = MolProtoCellOutput};
+static const MolType mol_CellOutputVec = {
+    .name = "CellOutputVec", .kind = MolKindDynVec, .item = &mol_CellOutput, .proto = MolProtoCellOutputVec};
+
+static const MolField mol_WitnessArgs_fields[] = {
+    {"lock", &mol_BytesOpt},
+    {"input_type", &mol_BytesOpt},
+    {"output_type", &mol_BytesOpt},
+};
+static const MolType mol_WitnessArgs = {.name = "WitnessArgs",
+                                        .kind = MolKindTable,
+                                        .fields = mol_WitnessArgs_fields,
+                                        .field_count = countof(mol_WitnessArgs_fields),
+                                        .proto = MolProtoWitnessArgs};
+
+static const MolField mol_RawTransaction_fields[] = {
+    {"version", &mol_Uint32},        {"cell_deps", &mol_CellDepVec},     {"header_deps", &mol_Byte32Vec},
+    {"inputs", &mol_CellInputVec},   {"outputs", &mol_CellOutputVec},    {"outputs_data", &mol_BytesVec},
+};
+static const MolType mol_RawTransaction = {.name = "RawTransaction",
+                                           .kind = MolKindTable,
+                                           .fields = mol_RawTransaction_fields,
+                                           .field_count = countof(mol_RawTransaction_fields),
+                                           .proto = MolProtoRawTransaction};
+
+static const MolField mol_Transaction_fields[] = {
+    {"raw", &mol_RawTransaction},
+    {"witnesses", &mol_BytesVec},
+};
+static const MolType mol_Transaction = {.name = "Transaction",
+                                        .kind = MolKindTable,
+                                        .fields = mol_Transaction_fields,
+                                        .field_count = countof(mol_Transaction_fields),
+                                        .proto = MolProtoTransaction};
+
+// Indexed by prototype, each of them is exported as a function verifying its argument and returning a typed cursor
+static const MolType *const mol_types[MolProtoCount] = {
+    [MolProtoOutPoint] = &mol_OutPoint,
+    [MolProtoCellInput] = &mol_CellInput,
+    [MolProtoCellDep] = &mol_CellDep,
+    [MolProtoScript] = &mol_Script,
+    [MolProtoCellOutput] = &mol_CellOutput,
+    [MolProtoWitnessArgs] = &mol_WitnessArgs,
+    [MolProtoRawTransaction] = &mol_RawTransaction,
+    [MolProtoTransaction] = &mol_Transaction,
+    [MolProtoBytesVec] = &mol_BytesVec,
+    [MolProtoByte32Vec] = &mol_Byte32Vec,
+    [MolProtoCellDepVec] = &mol_CellDepVec,
+    [MolProtoCellInputVec] = &mol_CellInputVec,
+    [MolProtoCellOutputVec] = &mol_CellOutputVec,
+};
+
+// The field getters get the field index and the prototype in their magic
+#define MOL_FIELD_MAGIC(proto, index) ((proto) * 16 + (index))
+
+typedef struct MolCursor {
+    JSValue buffer;
+    uint32_t offset;
+    uint32_t size;
+    // NULL for an untyped cursor
+    const MolType *type;
+} MolCursor;
+
+// A cursor has the class of its prototype, so that the prototypes are the class prototypes of each context. They are
+// only created on the first access of the global object `molecule` or the first import of the "molecule" module.
+static JSClassID js_mol_class_ids[MolProtoCount];
+
+static uint64_t mol_unpack_uint64(const uint8_t *src) {
+    uint64_t v;
+    memcpy(&v, src, sizeof(v));
+    return v;
+}
+
+static mol_errno mol_slice(const mol_seg_t *seg, uint32_t offset, uint32_t size, mol_seg_t *item) {
+    if (offset > seg->size || size > seg->size - offset) {
+        return MOL_ERR_INDEX_OUT_OF_BOUNDS;
+    }
+    item->ptr = seg->ptr + offset;
+    item->size = size;
+    return MOL_OK;
+}
+
+// Number of items of a dynvec or fields of a table, only the header is checked
+static mol_errno mol_dynvec_count(const mol_seg_t *seg, mol_num_t *count) {
+    if (seg->size < MOL_NUM_T_SIZE) {
+        return MOL_ERR_HEADER;
+    }
+    mol_num_t total_size = mol_unpack_number(seg->ptr);
+    if (total_size != seg->size) {
+        return MOL_ERR_TOTAL_SIZE;
+    }
+    if (total_size == MOL_NUM_T_SIZE) {
+        *count = 0;
+        return MOL_OK;
+    }
+    if (total_size < MOL_NUM_T_SIZE * 2) {
+        return MOL_ERR_HEADER;
+    }
+    mol_num_t first_offset = mol_unpack_number(seg->ptr + MOL_NUM_T_SIZE);
+    if (first_offset % MOL_NUM_T_SIZE != 0 || first_offset < MOL_NUM_T_SIZE * 2 || first_offset > total_size) {
+        return MOL_ERR_OFFSET;
+    }
+    *count = first_offset / MOL_NUM_T_SIZE - 1;
+    return MOL_OK;
+}
+
+// Item of a dynvec or field of a table, only the offsets of this item are checked
+static mol_errno mol_dynvec_item(const mol_seg_t *seg, mol_num_t index, mol_seg_t *item) {
+    mol_num_t count = 0;
+    mol_errno err = mol_dynvec_count(seg, &count);
+    if (err != MOL_OK) {
+        return err;
+    }
+    if (index >= count) {
+        return MOL_ERR_INDEX_OUT_OF_BOUNDS;
+    }
+    mol_num_t start = mol_unpack_number(seg->ptr + MOL_NUM_T_SIZE * (index + 1));
+    mol_num_t end = index + 1 == count ? seg->size : mol_unpack_number(seg->ptr + MOL_NUM_T_SIZE * (index + 2));
+    if (start < MOL_NUM_T_SIZE * (count + 1) || start > end || end > seg->size) {
+        return MOL_ERR_OFFSET;
+    }
+    item->ptr = seg->ptr + start;
+    item->size = end - start;
+    return MOL_OK;
+}
+
+static mol_errno mol_fixvec_item(const mol_seg_t *seg, uint32_t item_size, mol_num_t index, mol_seg_t *item) {
+    mol_errno err = mol_fixvec_verify(seg, item_size);
+    if (err != MOL_OK) {
+        return err;
+    }
+    if (index >= mol_fixvec_length(seg)) {
+        return MOL_ERR_INDEX_OUT_OF_BOUNDS;
+    }
+    item->ptr = seg->ptr + MOL_NUM_T_SIZE + item_size * index;
+    item->size = item_size;
+    return MOL_OK;
+}
+
+static mol_errno mol_verify(const MolType *type, const mol_seg_t *seg, bool compatible) {
+    mol_errno err = MOL_OK;
+    mol_num_t count = 0;
+    mol_seg_t item;
+    switch (type->kind) {
+        case MolKindByte:
+        case MolKindUint32:
+        case MolKindUint64:
+        case MolKindArray:
+            return mol_verify_fixed_size(seg, type->size);
+        case MolKindFixVec:
+            return mol_fixvec_verify(seg, type->item->size);
+        case MolKindOption:
+            return mol_option_is_none(seg) ? MOL_OK : mol_verify(type->item, seg, compatible);
+        case MolKindDynVec:
+        case MolKindTable:
+            err = mol_dynvec_count(seg, &count);
+            if (err != MOL_OK) {
+                return err;
+            }
+            if (type->kind == MolKindTable) {
+                if (count < type->field_count || (count > type->field_count && !compatible)) {
+                    return MOL_ERR_FIELD_COUNT;
+                }
+            }
+            // checking every item also checks that the offsets are increasing
+            for (mol_num_t i = 0; i < count; i++) {
+                err = mol_dynvec_item(seg, i, &item);
+                if (err != MOL_OK) {
+                    return err;
+                }
+                if (type->kind == MolKindDynVec) {
+                    err = mol_verify(type->item, &item, compatible);
+                } else if (i < type->field_count) {
+                    err = mol_verify(type->fields[i].type, &item, compatible);
+                }
+                if (err != MOL_OK) {
+                    return err;
+                }
+            }
+            return MOL_OK;
+    }
+    return MOL_ERR;
+}
+
+static JSValue js_mol_throw(JSContext *ctx, mol_errno err) {
+    switch (err) {
+        case MOL_ERR_INDEX_OUT_OF_BOUNDS:
+            return JS_ThrowRangeError(ctx, "molecule: index out of bounds");
+        case MOL_ERR_TOTAL_SIZE:
+            return JS_ThrowTypeError(ctx, "molecule: invalid total size");
+        case MOL_ERR_HEADER:
+            return JS_ThrowTypeError(ctx, "molecule: invalid header");
+        case MOL_ERR_OFFSET:
+            return JS_ThrowTypeError(ctx, "molecule: invalid offset");
+        case MOL_ERR_FIELD_COUNT:
+            return JS_ThrowTypeError(ctx, "molecule: invalid field count");
+        case MOL_ERR_UNKNOWN_ITEM:
+            return JS_ThrowTypeError(ctx, "molecule: unknown union item");
+        default:
+            return JS_ThrowTypeError(ctx, "molecule: invalid data");
+    }
+}
+
+// NULL if obj is not a cursor
+static MolCursor *js_mol_get_opaque(JSValueConst obj) {
+    JSClassID class_id = JS_GetClassID(obj);
+    for (int i = 0; i < MolProtoCount; i++) {
+        if (class_id == js_mol_class_ids[i]) {
+            return JS_GetOpaque(obj, class_id);
+        }
+    }
+    return NULL;
+}
+
+static MolCursor *js_mol_get_opaque2(JSContext *ctx, JSValueConst obj) {
+    MolCursor *c = js_mol_get_opaque(obj);
+    if (!c) {
+        JS_ThrowTypeError(ctx, "molecule: not a cursor");
+    }
+    return c;
+}
+
+static void js_mol_cursor_finalizer(JSRuntime *rt, JSValue val) {
+    MolCursor *c = JS_GetOpaque(val, JS_GetClassID(val));
+    if (c) {
+        JS_FreeValueRT(rt, c->buffer);
+        js_free_rt(rt, c);
+    }
+}
+
+static void js_mol_cursor_mark(JSRuntime *rt, JSValueConst val, JS_MarkFunc *mark_func) {
+    MolCursor *c = JS_GetOpaque(val, JS_GetClassID(val));
+    if (c) {
+        JS_MarkValue(rt, c->buffer, mark_func);
+    }
+}
+
+static JSValue js_mol_cursor_new(JSContext *ctx, JSValueConst buffer, uint32_t offset, uint32_t size,
+                                 const MolType *type) {
+    int proto = type ? type->proto : MolProtoNone;
+    JSValue obj = JS_NewObjectClass(ctx, js_mol_class_ids[proto]);
+    if (JS_IsException(obj)) {
+        return obj;
+    }
+    MolCursor *c = js_malloc(ctx, sizeof(MolCursor));
+    if (!c) {
+        JS_FreeValue(ctx, obj);
+        return JS_EXCEPTION;
+    }
+    c->buffer = JS_DupValue(ctx, buffer);
+    c->offset = offset;
+    c->size = size;
+    c->type = type;
+    JS_SetOpaque(obj, c);
+    return obj;
+}
+
+// Get the cursor `obj` and the data it references
+static MolCursor *js_mol_get_cursor(JSContext *ctx, JSValueConst obj, mol_seg_t *seg) {
+    MolCursor *c = js_mol_get_opaque2(ctx, obj);
+    if (!c) {
+        return NULL;
+    }
+    size_t len = 0;
+    uint8_t *ptr = JS_GetArrayBuffer(ctx, &len, c->buffer);
+    if (!ptr) {
+        return NULL;
+    }
+    if (c->offset > len || c->size > len - c->offset) {
+        JS_ThrowRangeError(ctx, "molecule: cursor out of its buffer");
+        return NULL;
+    }
+    seg->ptr = ptr + c->offset;
+    seg->size = c->size;
+    return c;
+}
+
+// A new cursor over `item`, which is inside the data `seg` of the cursor `c`
+static JSValue js_mol_sub_cursor(JSContext *ctx, const MolCursor *c, const mol_seg_t *seg, mol_seg_t item,
+                                 const MolType *type) {
+    return js_mol_cursor_new(ctx, c->buffer, c->offset + (uint32_t)(item.ptr - seg->ptr), item.size, type);
+}
+
+// Read `item` as a value of `type`
+static JSValue js_mol_read(JSContext *ctx, const MolCursor *c, const mol_seg_t *seg, mol_seg_t item,
+                           const MolType *type) {
+    mol_errno err = MOL_OK;
+    switch (type->kind) {
+        case MolKindByte:
+        case MolKindUint32:
+        case MolKindUint64:
+        case MolKindArray:
+            err = mol_verify_fixed_size(&item, type->size);
+            break;
+        case MolKindFixVec:
+            err = mol_fixvec_verify(&item, type->item->size);
+            break;
+        default:
+            break;
+    }
+    if (err != MOL_OK) {
+        return js_mol_throw(ctx, err);
+    }
+    switch (type->kind) {
+        case MolKindByte:
+            return JS_NewUint32(ctx, item.ptr[0]);
+        case MolKindUint32:
+            return JS_NewUint32(ctx, mol_unpack_number(item.ptr));
+        case MolKindUint64:
+            return JS_NewBigUint64(ctx, mol_unpack_uint64(item.ptr));
+        case MolKindOption:
+            if (mol_option_is_none(&item)) {
+                return JS_UNDEFINED;
+            }
+            return js_mol_read(ctx, c, seg, item, type->item);
+        case MolKindFixVec:
+            if (type->item->kind == MolKindByte) {
+                return js_mol_sub_cursor(ctx, c, seg, mol_fixvec_slice_raw_bytes(&item), NULL);
+            }
+            return js_mol_sub_cursor(ctx, c, seg, item, type);
+        default:
+            return js_mol_sub_cursor(ctx, c, seg, item, type);
+    }
+}
+
+static int js_mol_to_index(JSContext *ctx, uint32_t *pres, JSValueConst val) {
+    uint64_t v = 0;
+    if (JS_ToIndex(ctx, &v, val)) {
+        return -1;
+    }
+    if (v > UINT32_MAX) {
+        JS_ThrowRangeError(ctx, "molecule: index out of bounds");
+        return -1;
+    }
+    *pres = (uint32_t)v;
+    return 0;
+}
+
+// molecule.cursor(source, offset, length): an untyped cursor over an ArrayBuffer, a TypedArray, a DataView or
+// another cursor. offset and length are optional and relative to source.
+static JSValue js_mol_cursor(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    JSValue buffer;
+    size_t offset = 0;
+    size_t size = 0;
+    uint32_t start = 0;
+    uint32_t length = 0;
+
+    MolCursor *c = js_mol_get_opaque(argv[0]);
+    if (c) {
+        buffer = JS_DupValue(ctx, c->buffer);
+        offset = c->offset;
+        size = c->size;
+    } else {
+        buffer = JS_GetArrayBufferViewBuffer(ctx, argv[0], &offset, &size);
+        if (JS_IsException(buffer)) {
+            return buffer;
+        }
+    }
+    if (offset + size > UINT32_MAX) {
+        JS_FreeValue(ctx, buffer);
+        return JS_ThrowRangeError(ctx, "molecule: buffer too large");
+    }
+    if (argc > 1 && js_mol_to_index(ctx, &start, argv[1])) {
+        goto fail;
+    }
+    if (start > size) {
+        goto out_of_bounds;
+    }
+    length = size - start;
+    if (argc > 2 && !JS_IsUndefined(argv[2])) {
+        if (js_mol_to_index(ctx, &length, argv[2])) {
+            goto fail;
+        }
+        if (length > size - start) {
+            goto out_of_bounds;
+        }
+    }
+    JSValue ret = js_mol_cursor_new(ctx, buffer, offset + start, length, NULL);
+    JS_FreeValue(ctx, buffer);
+    return ret;
+out_of_bounds:
+    JS_ThrowRangeError(ctx, "molecule: index out of bounds");
+fail:
+    JS_FreeValue(ctx, buffer);
+    return JS_EXCEPTION;
+}
+
+// molecule.<Type>(source, compatible): verify source as a Type and return a typed cursor over it
+static JSValue js_mol_type_new(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv, int magic) {
+    const MolType *type = mol_types[magic];
+    mol_seg_t seg;
+    JSValue cursor = js_mol_cursor(ctx, this_val, 1, argv);
+    if (JS_IsException(cursor)) {
+        return cursor;
+    }
+    MolCursor *c = js_mol_get_cursor(ctx, cursor, &seg);
+    if (!c) {
+        goto fail;
+    }
+    mol_errno err = mol_verify(type, &seg, argc > 1 && JS_ToBool(ctx, argv[1]));
+    if (err != MOL_OK) {
+        js_mol_throw(ctx, err);
+        goto fail;
+    }
+    JSValue ret = js_mol_cursor_new(ctx, c->buffer, c->offset, c->size, type);
+    JS_FreeValue(ctx, cursor);
+    return ret;
+fail:
+    JS_FreeValue(ctx, cursor);
+    return JS_EXCEPTION;
+}
+
+static JSValue js_mol_get_field(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv, int magic) {
+    const MolType *type = mol_types[magic / 16];
+    const MolField *field = &type->fields[magic % 16];
+    mol_seg_t seg, item;
+    mol_errno err;
+    MolCursor *c = js_mol_get_cursor(ctx, this_val, &seg);
+    if (!c) {
+        return JS_EXCEPTION;
+    }
+    if (c->type != type) {
+        return JS_ThrowTypeError(ctx, "molecule: not a %s", type->name);
+    }
+    if (type->kind == MolKindTable) {
+        err = mol_dynvec_item(&seg, magic % 16, &item);
+    } else {
+        err = mol_slice(&seg, field->offset, field->type->size, &item);
+    }
+    if (err != MOL_OK) {
+        return js_mol_throw(ctx, err);
+    }
+    return js_mol_read(ctx, c, &seg, item, field->type);
+}
+
+static MolCursor *js_mol_get_vector(JSContext *ctx, JSValueConst this_val, mol_seg_t *seg) {
+    MolCursor *c = js_mol_get_cursor(ctx, this_val, seg);
+    if (c && (!c->type || (c->type->kind != MolKindFixVec && c->type->kind != MolKindDynVec))) {
+        JS_ThrowTypeError(ctx, "molecule: not a vector");
+        return NULL;
+    }
+    return c;
+}
+
+static JSValue js_mol_vector_get_length(JSContext *ctx, JSValueConst this_val) {
+    mol_seg_t seg;
+    mol_num_t count = 0;
+    mol_errno err;
+    MolCursor *c = js_mol_get_vector(ctx, this_val, &seg);
+    if (!c) {
+        return JS_EXCEPTION;
+    }
+    if (c->type->kind == MolKindFixVec) {
+        err = mol_fixvec_verify(&seg, c->type->item->size);
+        count = err == MOL_OK ? mol_fixvec_length(&seg) : 0;
+    } else {
+        err = mol_dynvec_count(&seg, &count);
+    }
+    if (err != MOL_OK) {
+        return js_mol_throw(ctx, err);
+    }
+    return JS_NewUint32(ctx, count);
+}
+
+static JSValue js_mol_vector_get(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    mol_seg_t seg, item;
+    uint32_t index = 0;
+    mol_errno err;
+    MolCursor *c = js_mol_get_vector(ctx, this_val, &seg);
+    if (!c || js_mol_to_index(ctx, &index, argv[0])) {
+        return JS_EXCEPTION;
+    }
+    if (c->type->kind == MolKindFixVec) {
+        err = mol_fixvec_item(&seg, c->type->item->size, index, &item);
+    } else {
+        err = mol_dynvec_item(&seg, index, &item);
+    }
+    if (err != MOL_OK) {
+        return js_mol_throw(ctx, err);
+    }
+    return js_mol_read(ctx, c, &seg, item, c->type->item);
+}
+
+static JSValue js_mol_cursor_get_byte_length(JSContext *ctx, JSValueConst this_val) {
+    MolCursor *c = js_mol_get_opaque2(ctx, this_val);
+    if (!c) {
+        return JS_EXCEPTION;
+    }
+    return JS_NewUint32(ctx, c->size);
+}
+
+static JSValue js_mol_cursor_get_byte_offset(JSContext *ctx, JSValueConst this_val) {
+    MolCursor *c = js_mol_get_opaque2(ctx, this_val);
+    if (!c) {
+        return JS_EXCEPTION;
+    }
+    return JS_NewUint32(ctx, c->offset);
+}
+
+static JSValue js_mol_cursor_get_buffer(JSContext *ctx, JSValueConst this_val) {
+    MolCursor *c = js_mol_get_opaque2(ctx, this_val);
+    if (!c) {
+        return JS_EXCEPTION;
+    }
+    return JS_DupValue(ctx, c->buffer);
+}
+
+// cursor.bytes(): a Uint8Array over the data of the cursor, without copying
+static JSValue js_mol_cursor_bytes(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    mol_seg_t seg;
+    MolCursor *c = js_mol_get_cursor(ctx, this_val, &seg);
+    if (!c) {
+        return JS_EXCEPTION;
+    }
+    return JS_NewUint8Array(ctx, c->buffer, c->offset, c->size);
+}
+
+// cursor.slice(offset, length): an untyped cursor over a part of the data, length defaults to the end
+static JSValue js_mol_cursor_slice(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    if (!js_mol_get_opaque2(ctx, this_val)) {
+        return JS_EXCEPTION;
+    }
+    JSValueConst args[3] = {this_val, argc > 0 ? argv[0] : JS_UNDEFINED, argc > 1 ? argv[1] : JS_UNDEFINED};
+    return js_mol_cursor(ctx, JS_UNDEFINED, 3, args);
+}
+
+// cursor.u8(offset), cursor.u32(offset) and cursor.u64(offset): little endian numbers, u64 returns a BigInt
+static JSValue js_mol_cursor_read_number(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv,
+                                         int magic) {
+    mol_seg_t seg, item;
+    uint32_t offset = 0;
+    MolCursor *c = js_mol_get_cursor(ctx, this_val, &seg);
+    if (!c || (argc > 0 && js_mol_to_index(ctx, &offset, argv[0]))) {
+        return JS_EXCEPTION;
+    }
+    mol_errno err = mol_slice(&seg, offset, magic, &item);
+    if (err != MOL_OK) {
+        return js_mol_throw(ctx, err);
+    }
+    switch (magic) {
+        case 1:
+            return JS_NewUint32(ctx, item.ptr[0]);
+        case 4:
+            return JS_NewUint32(ctx, mol_unpack_number(item.ptr));
+        default:
+            return JS_NewBigUint64(ctx, mol_unpack_uint64(item.ptr));
+    }
+}
+
+// cursor.field_count(): the number of fields of a table, including extra fields
+static JSValue js_mol_cursor_field_count(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    mol_seg_t seg;
+    mol_num_t count = 0;
+    MolCursor *c = js_mol_get_cursor(ctx, this_val, &seg);
+    if (!c) {
+        return JS_EXCEPTION;
+    }
+    mol_errno err = mol_dynvec_count(&seg, &count);
+    if (err != MOL_OK) {
+        return js_mol_throw(ctx, err);
+    }
+    return JS_NewUint32(ctx, count);
+}
+
+// cursor.field(index) and cursor.dynvec(index): a field of a table or an item of a dynvec, they share the layout
+static JSValue js_mol_cursor_dynvec(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    mol_seg_t seg, item;
+    uint32_t index = 0;
+    MolCursor *c = js_mol_get_cursor(ctx, this_val, &seg);
+    if (!c || js_mol_to_index(ctx, &index, argv[0])) {
+        return JS_EXCEPTION;
+    }
+    mol_errno err = mol_dynvec_item(&seg, index, &item);
+    if (err != MOL_OK) {
+        return js_mol_throw(ctx, err);
+    }
+    return js_mol_sub_cursor(ctx, c, &seg, item, NULL);
+}
+
+// cursor.fixvec_length(item_size)
+static JSValue js_mol_cursor_fixvec_length(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    mol_seg_t seg;
+    uint32_t item_size = 0;
+    MolCursor *c = js_mol_get_cursor(ctx, this_val, &seg);
+    if (!c || js_mol_to_index(ctx, &item_size, argv[0])) {
+        return JS_EXCEPTION;
+    }
+    mol_errno err = mol_fixvec_verify(&seg, item_size);
+    if (err != MOL_OK) {
+        return js_mol_throw(ctx, err);
+    }
+    return JS_NewUint32(ctx, mol_fixvec_length(&seg));
+}
+
+// cursor.fixvec(index, item_size)
+static JSValue js_mol_cursor_fixvec(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    mol_seg_t seg, item;
+    uint32_t index = 0;
+    uint32_t item_size = 0;
+    MolCursor *c = js_mol_get_cursor(ctx, this_val, &seg);
+    if (!c || js_mol_to_index(ctx, &index, argv[0]) || js_mol_to_index(ctx, &item_size, argv[1])) {
+        return JS_EXCEPTION;
+    }
+    mol_errno err = mol_fixvec_item(&seg, item_size, index, &item);
+    if (err != MOL_OK) {
+        return js_mol_throw(ctx, err);
+    }
+    return js_mol_sub_cursor(ctx, c, &seg, item, NULL);
+}
+
+// cursor.dynvec_length()
+static JSValue js_mol_cursor_dynvec_length(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    return js_mol_cursor_field_count(ctx, this_val, argc, argv);
+}
+
+// cursor.raw(): the content of a Bytes, i.e. a fixvec of bytes, without its header
+static JSValue js_mol_cursor_raw(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    mol_seg_t seg;
+    MolCursor *c = js_mol_get_cursor(ctx, this_val, &seg);
+    if (!c) {
+        return JS_EXCEPTION;
+    }
+    return js_mol_read(ctx, c, &seg, seg, &mol_Bytes);
+}
+
+// cursor.is_none(): true for an empty option
+static JSValue js_mol_cursor_is_none(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    mol_seg_t seg;
+    MolCursor *c = js_mol_get_cursor(ctx, this_val, &seg);
+    if (!c) {
+        return JS_EXCEPTION;
+    }
+    return JS_NewBool(ctx, mol_option_is_none(&seg));
+}
+
+// cursor.union(): an object with the item id and a cursor over the item
+static JSValue js_mol_cursor_union(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
+    mol_seg_t seg;
+    MolCursor *c = js_mol_get_cursor(ctx, this_val, &seg);
+    if (!c) {
+        return JS_EXCEPTION;
+    }
+    if (seg.size < MOL_NUM_T_SIZE) {
+        return js_mol_throw(ctx, MOL_ERR_HEADER);
+    }
+    mol_union_t u = mol_union_unpack(&seg);
+    JSValue item = js_mol_sub_cursor(ctx, c, &seg, u.seg, NULL);
+    if (JS_IsException(item)) {
+        return item;
+    }
+    JSValue ret = JS_NewObject(ctx);
+    if (JS_IsException(ret)) {
+        JS_FreeValue(ctx, item);
+        return ret;
+    }
+    JS_DefinePropertyValueStr(ctx, ret, "id", JS_NewUint32(ctx, u.item_id), JS_PROP_C_W_E);
+    JS_DefinePropertyValueStr(ctx, ret, "item", item, JS_PROP_C_W_E);
+    return ret;
+}
+
+// cursor.verify_table(field_count, compatible), cursor.verify_dynvec(), cursor.verify_fixvec(item_size) and
+// cursor.verify_size(size): check the layout of the data, without checking the items. Throw when it's invalid.
+static JSValue js_mol_cursor_verify(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv,
+                                    int magic) {
+    mol_seg_t seg, item;
+    mol_num_t count = 0;
+    uint32_t n = 0;
+    mol_errno err = MOL_OK;
+    MolCursor *c = js_mol_get_cursor(ctx, this_val, &seg);
+    if (!c || (magic != MolKindDynVec && js_mol_to_index(ctx, &n, argv[0]))) {
+        return JS_EXCEPTION;
+    }
+    switch (magic) {
+        case MolKindTable:
+        case MolKindDynVec:
+            err = mol_dynvec_count(&seg, &count);
+            if (err == MOL_OK && magic == MolKindTable &&
+                (count < n || (count > n && !(argc > 1 && JS_ToBool(ctx, argv[1]))))) {
+                err = MOL_ERR_FIELD_COUNT;
+            }
+            for (mol_num_t i = 0; err == MOL_OK && i < count; i++) {
+                err = mol_dynvec_item(&seg, i, &item);
+            }
+            break;
+        case MolKindFixVec:
+            err = mol_fixvec_verify(&seg, n);
+            break;
+        default:
+            err = mol_verify_fixed_size(&seg, n);
+            break;
+    }
+    if (err != MOL_OK) {
+        return js_mol_throw(ctx, err);
+    }
+    return JS_UNDEFINED;
+}
+
+static const JSCFunctionListEntry js_mol_cursor_proto_funcs[] = {
+    JS_CGETSET_DEF("byte_length", js_mol_cursor_get_byte_length, NULL),
+    JS_CGETSET_DEF("byte_offset", js_mol_cursor_get_byte_offset, NULL),
+    JS_CGETSET_DEF("buffer", js_mol_cursor_get_buffer, NULL),
+    JS_CFUNC_DEF("bytes", 0, js_mol_cursor_bytes),
+    JS_CFUNC_DEF("slice", 2, js_mol_cursor_slice),
+    JS_CFUNC_MAGIC_DEF("u8", 1, js_mol_cursor_read_number, 1),
+    JS_CFUNC_MAGIC_DEF("u32", 1, js_mol_cursor_read_number, 4),
+    JS_CFUNC_MAGIC_DEF("u64", 1, js_mol_cursor_read_number, 8),
+    JS_CFUNC_DEF("field_count", 0, js_mol_cursor_field_count),
+    JS_CFUNC_DEF("field", 1, js_mol_cursor_dynvec),
+    JS_CFUNC_DEF("fixvec_length", 1, js_mol_cursor_fixvec_length),
+    JS_CFUNC_DEF("fixvec", 2, js_mol_cursor_fixvec),
+    JS_CFUNC_DEF("dynvec_length", 0, js_mol_cursor_dynvec_length),
+    JS_CFUNC_DEF("dynvec", 1, js_mol_cursor_dynvec),
+    JS_CFUNC_DEF("raw", 0, js_mol_cursor_raw),
+    JS_CFUNC_DEF("is_none", 0, js_mol_cursor_is_none),
+    JS_CFUNC_DEF("union", 0, js_mol_cursor_union),
+    JS_CFUNC_MAGIC_DEF("verify_table", 2, js_mol_cursor_verify, MolKindTable),
+    JS_CFUNC_MAGIC_DEF("verify_dynvec", 0, js_mol_cursor_verify, MolKindDynVec),
+    JS_CFUNC_MAGIC_DEF("verify_fixvec", 1, js_mol_cursor_verify, MolKindFixVec),
+    JS_CFUNC_MAGIC_DEF("verify_size", 1, js_mol_cursor_verify, MolKindArray),
+};
+
+static const JSCFunctionListEntry js_mol_vector_proto_funcs[] = {
+    JS_CGETSET_DEF("length", js_mol_vector_get_length, NULL),
+    JS_CFUNC_DEF("get", 1, js_mol_vector_get),
+};
+
+// Names of the exported functions, indexed by prototype
+static const char *js_mol_export_name(int proto) { return proto == MolProtoNone ? "cursor" : mol_types[proto]->name; }
+
+// Register the classes, once per runtime, and create their prototypes, once per context. The exported functions are
+// the constructors of the prototypes.
+static int js_mol_init_context(JSContext *ctx) {
+    int err = 0;
+    JSRuntime *rt = JS_GetRuntime(ctx);
+    JSValue func = JS_UNDEFINED;
+
+    if (!JS_IsRegisteredClass(rt, js_mol_class_ids[MolProtoNone])) {
+        for (int i = 0; i < MolProtoCount; i++) {
+            JSClassDef def = {
+                i == MolProtoNone ? "Cursor" : mol_types[i]->name,
+                .finalizer = js_mol_cursor_finalizer,
+                .gc_mark = js_mol_cursor_mark,
+            };
+            JS_NewClassID(&js_mol_class_ids[i]);
+            CHECK2(JS_NewClass(rt, js_mol_class_ids[i], &def) == 0, -1);
+        }
+    }
+    JSValue cursor_proto = JS_GetClassProto(ctx, js_mol_class_ids[MolProtoNone]);
+    if (JS_IsObject(cursor_proto)) {
+        JS_FreeValue(ctx, cursor_proto);
+        return 0;
+    }
+
+    cursor_proto = JS_NewObject(ctx);
+    CHECK2(!JS_IsException(cursor_proto), -1);
+    JS_SetPropertyFunctionList(ctx, cursor_proto, js_mol_cursor_proto_funcs, countof(js_mol_cursor_proto_funcs));
+    JS_SetClassProto(ctx, js_mol_class_ids[MolProtoNone], cursor_proto);
+    func = JS_NewCFunction(ctx, js_mol_cursor, "cursor", 3);
+    CHECK2(!JS_IsException(func), -1);
+    JS_SetConstructor(ctx, func, cursor_proto);
+    JS_FreeValue(ctx, func);
+
+    for (int i = MolProtoNone + 1; i < MolProtoCount; i++) {
+        const MolType *type = mol_types[i];
+        JSValue proto = JS_NewObjectProto(ctx, cursor_proto);
+        CHECK2(!JS_IsException(proto), -1);
+        JS_SetClassProto(ctx, js_mol_class_ids[i], proto);
+        if (type->kind == MolKindFixVec || type->kind == MolKindDynVec) {
+            JS_SetPropertyFunctionList(ctx, proto, js_mol_vector_proto_funcs, countof(js_mol_vector_proto_funcs));
+        }
+        for (uint32_t j = 0; j < type->field_count; j++) {
+            const char *name = type->fields[j].name;
+            JSAtom atom = JS_NewAtom(ctx, name);
+            JSValue getter = JS_NewCFunctionMagic(ctx, js_mol_get_field, name, 0, JS_CFUNC_generic_magic,
+                                                  MOL_FIELD_MAGIC(i, j));
+            JS_DefinePropertyGetSet(ctx, proto, atom, getter, JS_UNDEFINED, JS_PROP_CONFIGURABLE);
+            JS_FreeAtom(ctx, atom);
+        }
+        func = JS_NewCFunctionMagic(ctx, js_mol_type_new, type->name, 2, JS_CFUNC_generic_magic, i);
+        CHECK2(!JS_IsException(func), -1);
+        JS_SetConstructor(ctx, func, proto);
+        JS_FreeValue(ctx, func);
+    }
+exit:
+    return err;
+}
+
+// The exported function of a prototype
+static JSValue js_mol_get_export(JSContext *ctx, int proto) {
+    JSValue obj = JS_GetClassProto(ctx, js_mol_class_ids[proto]);
+    JSValue func = JS_GetPropertyStr(ctx, obj, "constructor");
+    JS_FreeValue(ctx, obj);
+    return func;
+}
+
+static JSValue js_mol_global_init(JSContext *ctx, JSAtom prop) {
+    if (js_mol_init_context(ctx)) {
+        return JS_EXCEPTION;
+    }
+    JSValue obj = JS_NewObject(ctx);
+    if (JS_IsException(obj)) {
+        return obj;
+    }
+    for (int i = 0; i < MolProtoCount; i++) {
+        JSValue func = js_mol_get_export(ctx, i);
+        if (JS_IsException(func) || JS_SetPropertyStr(ctx, obj, js_mol_export_name(i), func) < 0) {
+            JS_FreeValue(ctx, obj);
+            return JS_EXCEPTION;
+        }
+    }
+    return obj;
+}
+
+static int js_mol_module_init(JSContext *ctx, JSModuleDef *m) {
+    if (js_mol_init_context(ctx)) {
+        return -1;
+    }
+    for (int i = 0; i < MolProtoCount; i++) {
+        JSValue func = js_mol_get_export(ctx, i);
+        if (JS_IsException(func) || JS_SetModuleExport(ctx, m, js_mol_export_name(i), func)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int js_init_module_molecule(JSContext *ctx) {
+    JSValue global_obj = JS_GetGlobalObject(ctx);
+    int ret = JS_DefineLazyPropertyStr(ctx, global_obj, "molecule", js_mol_global_init,
+                                       JS_PROP_WRITABLE | JS_PROP_CONFIGURABLE);
+    JS_FreeValue(ctx, global_obj);
+    return ret < 0 ? -1 : 0;
+}
+
+JSModuleDef *js_new_module_molecule(JSContext *ctx, const char *module_name) {
+    JSModuleDef *m = JS_NewCModule(ctx, module_name, js_mol_module_init);
+    if (!m) {
+        return NULL;
+    }
+    for (int i = 0; i < MolProtoCount; i++) {
+        if (JS_AddModuleExport(ctx, m, js_mol_export_name(i))) {
+            return NULL;
+        }
+    }
+    return m;
+}
@@ -0,0 +1,12 @@
+#ifndef _MOLECULE_MODULE_H_
+#define _MOLECULE_MODULE_H_
+
+#include "quickjs.h"
+
+// The molecule module is available both as the global object `molecule` and as the "molecule" ES module. Both are
+// created when they are first used.
+int js_init_module_molecule(JSContext *ctx);
+// Called by the module loader when "molecule" is first imported
+JSModuleDef *js_new_module_molecule(JSContext *ctx, const char *module_name);
+
+#endif  // _MOLECULE_MODULE_H_
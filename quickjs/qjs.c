@@ -28,12 +28,18 @@
 #include "my_stdio.h"
 #include <stdarg.h>
 #include <string.h>
+#include "my_string.h"
 #include <stddef.h>
 #include <stdbool.h>
 #include "cutils.h"
 #include "std_module.h"
 #include "ckb_module.h"
+#include "molecule_module.h"
+#include "hash_module.h"
 #include "ckb_exec.h"
+#ifdef CONFIG_NATIVE
+#include "native/ckb_native.h"
+#endif
 
 #define MAIN_FILE_NAME "main.js"
 #define MAIN_FILE_NAME_BC "main.bc"
@@ -48,6 +54,7 @@ typedef enum {
     RunJsWithDbgFileSystem,
 
     CompileWithFile,
+    CompileWithFileSystem,
 } RunJSType;
 
 static RunJSType parse_args(int argc, const char **argv) {
@@ -69,7 +76,10 @@ static RunJSType parse_args(int argc, const char **argv) {
     }
 
     if (has_c) {
-        return CompileWithFile;
+        if (has_f)
+            return CompileWithFileSystem;
+        else
+            return CompileWithFile;
     } else if (has_e) {
         if (argc < 2 || argv[1] == NULL) return RunJsError;
         if (has_r || has_f)
@@ -88,6 +98,47 @@ static RunJSType parse_args(int argc, const char **argv) {
     }
 }
 
+static bool has_option(int argc, const char **argv, const char *name) {
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], name) == 0) return true;
+    }
+    return false;
+}
+
+// Parse an option with a value such as --cycle-budget=1000000. Return 0 if it's not present, 1 if it's parsed and
+// -1 if the value is invalid.
+static int parse_uint64_option(int argc, const char **argv, const char *name, uint64_t *value) {
+    size_t len = strlen(name);
+    for (int i = 0; i < argc; i++) {
+        if (strncmp(argv[i], name, len) != 0 || argv[i][len] != '=') continue;
+        const char *p = argv[i] + len + 1;
+        if (*p == 0) return -1;
+        uint64_t v = 0;
+        for (; *p; p++) {
+            if (*p < '0' || *p > '9' || v > (UINT64_MAX - 9) / 10) return -1;
+            v = v * 10 + (*p - '0');
+        }
+        *value = v;
+        return 1;
+    }
+    return 0;
+}
+
+#ifdef CONFIG_NATIVE
+// Parse an option with a string value such as --output=main.bc. Return 0 if it's not present, 1 if it's parsed and -1
+// if the value is empty.
+static int parse_string_option(int argc, const char **argv, const char *name, const char **value) {
+    size_t len = strlen(name);
+    for (int i = 0; i < argc; i++) {
+        if (strncmp(argv[i], name, len) != 0 || argv[i][len] != '=') continue;
+        if (argv[i][len + 1] == 0) return -1;
+        *value = argv[i] + len + 1;
+        return 1;
+    }
+    return 0;
+}
+#endif
+
 static void js_dump_obj(JSContext *ctx, JSValueConst val) {
     const char *str;
 
@@ -123,7 +174,39 @@ void js_std_dump_error(JSContext *ctx) {
     JS_FreeValue(ctx, exception_val);
 }
 
-int compile_from_file(JSContext *ctx) {
+#ifdef CONFIG_NATIVE
+static bool s_binary_output = false;
+#endif
+
+// The output of -c: in hexadecimal, or in the native build with --output, as binary to a file.
+static void write_output(const uint8_t *buf, size_t buf_len) {
+#ifdef CONFIG_NATIVE
+    if (s_binary_output) {
+        ckb_native_write_output(buf, buf_len);
+        return;
+    }
+#endif
+    char msg_buf[65];
+    for (int i = 0; i < buf_len; i += 32) {
+        uint32_t size = i + 32 > buf_len ? buf_len - i : 32;
+        _exec_bin2hex(&buf[i], size, msg_buf, 65, &size, true);
+        msg_buf[size - 1] = 0;
+        printf("%s", msg_buf);
+    }
+}
+
+static int write_bytecode(JSContext *ctx, JSValueConst val, uint8_t **out_buf, size_t *out_buf_len) {
+    *out_buf = JS_WriteObject(ctx, out_buf_len, val, JS_WRITE_OBJ_BYTECODE);
+    if (!*out_buf) {
+        js_std_dump_error(ctx);
+        return -1;
+    }
+    return 0;
+}
+
+// With `release`, the debug info (line numbers, source code, file name) and the variable names not needed at runtime
+// are stripped, and a size report follows the hexadecimal output.
+int compile_from_file(JSContext *ctx, bool release) {
     enable_local_access(1);
     char buf[1024 * 512];
     int buf_len = read_local_file(buf, sizeof(buf));
@@ -137,21 +220,108 @@ int compile_from_file(JSContext *ctx) {
     }
 
     JSValue val;
-    val = JS_Eval(ctx, buf, buf_len, "", JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY);
+    uint8_t *out_buf;
+    size_t out_buf_len;
+    size_t debug_len = 0;
+    int eval_flags = JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY;
+    if (release) {
+        // Only compiled to report the size of the bytecode with the debug info.
+        val = JS_Eval(ctx, buf, buf_len, "", eval_flags);
+        if (JS_IsException(val)) {
+            js_std_dump_error(ctx);
+            return -1;
+        }
+        if (write_bytecode(ctx, val, &out_buf, &debug_len) < 0) return -1;
+        js_free(ctx, out_buf);
+        eval_flags |= JS_EVAL_FLAG_STRIP;
+    }
+    val = JS_Eval(ctx, buf, buf_len, "", eval_flags);
     if (JS_IsException(val)) {
         js_std_dump_error(ctx);
         return -1;
     }
-    uint8_t *out_buf;
-    size_t out_buf_len;
-    out_buf = JS_WriteObject(ctx, &out_buf_len, val, JS_WRITE_OBJ_BYTECODE);
-    if (!out_buf) return -1;
-    char msg_buf[65];
-    for (int i = 0; i < out_buf_len; i += 32) {
-        uint32_t size = i + 32 > out_buf_len ? out_buf_len - i : 32;
-        _exec_bin2hex(&out_buf[i], size, msg_buf, 65, &size, true);
-        msg_buf[size - 1] = 0;
-        printf("%s", msg_buf);
+    if (write_bytecode(ctx, val, &out_buf, &out_buf_len) < 0) return -1;
+    write_output(out_buf, out_buf_len);
+    if (release) {
+        // Not hexadecimal, so that it can be filtered out of the output.
+        printf("bytecode size: %d bytes with debug info, %d bytes stripped (-%d%%)", (int)debug_len, (int)out_buf_len,
+               (int)((debug_len - out_buf_len) * 100 / debug_len));
+    }
+    return 0;
+}
+
+// The extra eval flags of the modules loaded while compiling a bundle. The module loader keeps a pointer to them for
+// the lifetime of the runtime.
+static int s_bundle_eval_flags = 0;
+
+// Compile main.js (or main.bc) of a file system and all the modules it imports into a bundle, see js_read_bundle().
+// The file system is only needed at compile time.
+int compile_from_file_system(JSContext *ctx, bool release) {
+    enable_local_access(1);
+    char buf[1024 * 512];
+    int buf_len = read_local_file(buf, sizeof(buf));
+    if (buf_len < 0 || buf_len == sizeof(buf)) {
+        if (buf_len == sizeof(buf)) {
+            printf("Error while reading from file: file too large\n");
+        } else {
+            printf("Error while reading from file: %d\n", buf_len);
+        }
+        return -1;
+    }
+    int err = ckb_load_fs(buf, buf_len);
+    if (err != 0) {
+        printf("Error while loading the file system: %d\n", err);
+        return -1;
+    }
+    FSFile *main_file = NULL;
+    err = ckb_get_file(MAIN_FILE_NAME, &main_file);
+    if (err != 0) {
+        err = ckb_get_file(MAIN_FILE_NAME_BC, &main_file);
+    }
+    if (err != 0 || main_file->size == 0) {
+        printf("Error: no %s in the file system\n", MAIN_FILE_NAME);
+        return -1;
+    }
+
+    s_bundle_eval_flags = release ? JS_EVAL_FLAG_STRIP : 0;
+    JS_SetModuleLoaderFunc(JS_GetRuntime(ctx), NULL, js_module_loader, &s_bundle_eval_flags);
+    JSValue val;
+    if (js_is_bytecode(main_file->content, main_file->size)) {
+        val = js_read_bytecode(ctx, main_file->content, main_file->size);
+    } else {
+        val = JS_Eval(ctx, main_file->content, main_file->size, MAIN_FILE_NAME,
+                      JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY | s_bundle_eval_flags);
+    }
+    if (JS_IsException(val) || JS_ResolveModule(ctx, val) < 0) {
+        js_std_dump_error(ctx);
+        return -1;
+    }
+    JSModuleDef *modules[256];
+    int count = JS_PrepareModuleBundle(ctx, JS_VALUE_GET_PTR(val), modules, countof(modules));
+    if (count < 0) {
+        printf("Error: more than %d modules\n", (int)countof(modules));
+        return -1;
+    }
+
+    uint8_t header[5];
+    header[0] = BC_BUNDLE;
+    put_u32(header + 1, count);
+    write_output(header, sizeof(header));
+    size_t bundle_len = sizeof(header);
+    for (int i = 0; i < count; i++) {
+        uint8_t *out_buf;
+        size_t out_buf_len;
+        uint8_t len_buf[4];
+        if (write_bytecode(ctx, JS_MKPTR(JS_TAG_MODULE, modules[i]), &out_buf, &out_buf_len) < 0) return -1;
+        put_u32(len_buf, out_buf_len);
+        write_output(len_buf, sizeof(len_buf));
+        write_output(out_buf, out_buf_len);
+        bundle_len += sizeof(len_buf) + out_buf_len;
+        js_free(ctx, out_buf);
+    }
+    if (release) {
+        // Not hexadecimal, so that it can be filtered out of the output.
+        printf("bytecode size: %d bytes stripped, %d modules", (int)bundle_len, count);
     }
     return 0;
 }
@@ -160,8 +330,12 @@ static int eval_buf(JSContext *ctx, const void *buf, int buf_len, const char *fi
     JSValue val;
     int ret;
 
-    if (((const char *)buf)[0] == (char)BC_VERSION) {
-        val = JS_ReadObject(ctx, buf, buf_len, JS_READ_OBJ_BYTECODE);
+    if (js_is_bundle(buf, buf_len) || js_is_bytecode(buf, buf_len)) {
+        if (js_is_bundle(buf, buf_len)) {
+            val = js_read_bundle(ctx, buf, buf_len);
+        } else {
+            val = js_read_bytecode(ctx, buf, buf_len);
+        }
         if (JS_IsException(val)) {
             js_std_dump_error(ctx);
             return -1;
@@ -262,11 +436,19 @@ static int run_from_cell_data(JSContext *ctx, bool enable_fs) {
 /* also used to initialize the worker context */
 static JSContext *JS_NewCustomContext(JSRuntime *rt) {
     JSContext *ctx;
-    ctx = JS_NewContext(rt);
+    ctx = JS_NewContextRaw(rt);
     if (!ctx) return NULL;
-    JS_AddIntrinsicBigFloat(ctx);
-    JS_AddIntrinsicBigDecimal(ctx);
-    JS_AddIntrinsicOperators(ctx);
+    // Same intrinsics as JS_NewContext(), the rarely used ones are only
+    // created when first accessed.
+    JS_AddIntrinsicBaseObjects(ctx);
+    JS_AddIntrinsicEval(ctx);
+    JS_AddIntrinsicStringNormalize(ctx);
+    JS_AddIntrinsicRegExp(ctx);
+    JS_AddIntrinsicJSON(ctx);
+    JS_AddIntrinsicTypedArrays(ctx);
+    JS_AddIntrinsicPromise(ctx);
+    JS_AddIntrinsicBigInt(ctx);
+    JS_AddIntrinsicLazy(ctx, JS_INTRINSIC_LAZY_ALL);
     JS_EnableBignumExt(ctx, TRUE);
     return ctx;
 }
@@ -278,18 +460,48 @@ int main(int argc, const char **argv) {
     size_t memory_limit = 0;
     size_t stack_size = 0;
     size_t optind = 1;
+    uint64_t cycle_budget = 0;
+    uint64_t cycle_check_interval = 0;
+    if (ckb_init_heap() != 0) {
+        printf("ckb-js: not enough memory for the heap");
+        return -1;
+    }
     RunJSType type = parse_args(argc, argv);
-    if (type == RunJsError) {
+    if (type == RunJsError || parse_uint64_option(argc, argv, "--cycle-budget", &cycle_budget) < 0 ||
+        parse_uint64_option(argc, argv, "--cycle-check-interval", &cycle_check_interval) < 0 ||
+        cycle_check_interval > INT32_MAX) {
         printf("ckb-js: args failed");
         return -1;
     }
+#ifdef CONFIG_NATIVE
+    const char *output = NULL;
+    int has_output = parse_string_option(argc, argv, "--output", &output);
+    if (has_output < 0 || (has_output > 0 && ckb_native_set_output(output) != 0)) {
+        printf("ckb-js: can't open the output file");
+        return -1;
+    }
+    s_binary_output = has_output > 0;
+#endif
+    bool arena = has_option(argc, argv, "--arena");
+    if (arena) malloc_enable_arena();
     rt = JS_NewRuntime();
     if (!rt) {
         printf("qjs: cannot allocate JS runtime\n");
         return -2;
     }
+    // Collecting cycles would give back almost nothing in the arena.
+    if (arena) JS_SetGCThreshold(rt, (size_t)-1);
+    // Fail with an out of memory error a bit before the heap is exhausted, so that the error can still be thrown.
+    MallocHeapInfo heap;
+    malloc_heap_info(&heap);
+    memory_limit = heap.size - heap.size / 32;
     if (memory_limit != 0) JS_SetMemoryLimit(rt, memory_limit);
     if (stack_size != 0) JS_SetMaxStackSize(rt, stack_size);
+    if (cycle_budget != 0 || cycle_check_interval != 0) ckb_set_cycle_budget(rt, cycle_budget, cycle_check_interval);
+#ifdef CONFIG_PROFILE
+    err = ckb_enable_profile(rt);
+    CHECK(err);
+#endif
     // TODO:
     // js_std_set_worker_new_context_func(JS_NewCustomContext);
     // js_std_init_handlers(rt);
@@ -300,6 +512,10 @@ int main(int argc, const char **argv) {
     js_std_add_helpers(ctx, argc - optind, argv + optind);
     err = js_init_module_ckb(ctx);
     CHECK(err);
+    err = js_init_module_molecule(ctx);
+    CHECK(err);
+    err = js_init_module_hash(ctx);
+    CHECK(err);
 
     switch (type) {
         case RunJsWithCode:
@@ -319,7 +535,10 @@ int main(int argc, const char **argv) {
             break;
         case CompileWithFile:
             JS_SetModuleLoaderFunc(rt, NULL, js_module_dummy_loader, NULL);
-            err = compile_from_file(ctx);
+            err = compile_from_file(ctx, has_option(argc, argv, "--release"));
+            break;
+        case CompileWithFileSystem:
+            err = compile_from_file_system(ctx, has_option(argc, argv, "--release"));
             break;
         default:
             printf("unknow type: %d", type);
@@ -327,6 +546,9 @@ int main(int argc, const char **argv) {
     }
     CHECK(err);
 exit:
+#ifdef CONFIG_PROFILE
+    ckb_dump_profile(rt);
+#endif
     // No cleanup is needed.
     // js_std_free_handlers(rt);
     // JS_FreeContext(ctx);
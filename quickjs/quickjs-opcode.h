@@ -53,6 +53,7 @@ FMT(atom_u16)
 FMT(atom_label_u8)
 FMT(atom_label_u16)
 FMT(label_u16)
+FMT(loc8_label8)
 #undef FMT
 #endif /* FMT */
 
@@ -358,6 +359,17 @@ DEF(   is_undefined, 1, 1, 1, none)
 DEF(        is_null, 1, 1, 1, none)
 DEF(typeof_is_undefined, 1, 1, 1, none)
 DEF( typeof_is_function, 1, 1, 1, none)
+
+/* superinstructions for the most frequent opcode pairs, emitted by
+   resolve_labels() */
+DEF(   lt_if_false8, 2, 2, 0, label8)
+DEF(  lte_if_false8, 2, 2, 0, label8) /* must come after lt_if_false8 */
+DEF(   gt_if_false8, 2, 2, 0, label8) /* must come after lte_if_false8 */
+DEF(  gte_if_false8, 2, 2, 0, label8) /* must come after gt_if_false8 */
+DEF(  inc_loc_goto8, 3, 0, 0, loc8_label8)
+DEF(get_loc_get_field, 6, 0, 1, atom_u8) /* atom, local index */
+DEF(get_loc_get_field2, 6, 0, 2, atom_u8) /* atom, local index */
+DEF(get_loc_get_array_el, 2, 1, 1, loc8)
 #endif
 
 #undef DEF
@@ -43,6 +43,7 @@
 #include "list.h"
 #include "quickjs.h"
 #include "libregexp.h"
+#include "dtoa.h"
 #ifdef CONFIG_BIGNUM
 #include "libbf.h"
 #endif
@@ -85,6 +86,18 @@ double trunc(double x) { return __builtin_truncl(x); }
 // #define CONFIG_STACK_CHECK
 // #endif
 
+/* define to cache the property lookups of the get_field, put_field and
+   get_array_el opcodes in each bytecode function */
+#define CONFIG_INLINE_CACHE
+
+/* define to record the time spent in each bytecode function and C
+   function and to count the executed opcodes, see JS_EnableProfile().
+   Set by the profiling build (build/ckb-js-vm-prof) */
+// #define CONFIG_PROFILE
+/* define to also record the time spent in each opcode. The clock is read
+   at each opcode, so it slows down the profiled code a lot */
+// #define CONFIG_PROFILE_OPCODE_CYCLES
+
 
 /* dump object free */
 //#define DUMP_FREE
@@ -112,6 +125,8 @@ double trunc(double x) { return __builtin_truncl(x); }
 //#define DUMP_MODULE_RESOLVE
 //#define DUMP_PROMISE
 //#define DUMP_READ_OBJECT
+/* dump the allocations done when a lazy intrinsic is created */
+//#define DUMP_LAZY_INTRINSICS
 
 /* test the GC by forcing it before each object allocation */
 //#define FORCE_GC_AT_MALLOC
@@ -270,6 +285,8 @@ struct JSRuntime {
     struct list_head tmp_obj_list; /* used during GC */
     JSGCPhaseEnum gc_phase : 8;
     size_t malloc_gc_threshold;
+    JSGCStats gc_stats;
+    JSGCClockFunc *gc_clock;
 #ifdef DUMP_LEAKS
     struct list_head string_list; /* list of JSString.link */
 #endif
@@ -286,6 +303,21 @@ struct JSRuntime {
 
     JSInterruptHandler *interrupt_handler;
     void *interrupt_opaque;
+    int interrupt_counter_init; /* number of polls between two calls of the handler */
+#ifdef CONFIG_PROFILE
+    JSProfileClockFunc *profile_clock;
+    struct JSProfileNode *profile_root;
+    struct JSProfileNode *profile_current; /* node of the running function */
+    struct JSProfileCFunc *profile_cfuncs;
+    int profile_cfunc_count;
+    int profile_cfunc_size;
+    uint64_t profile_op_count[256];
+#ifdef CONFIG_PROFILE_OPCODE_CYCLES
+    uint64_t profile_op_cycles[256];
+    uint64_t profile_op_start;
+    int profile_op_last; /* -1 if no opcode was executed */
+#endif
+#endif
 
     JSHostPromiseRejectionTracker *host_promise_rejection_tracker;
     void *host_promise_rejection_tracker_opaque;
@@ -411,6 +443,7 @@ typedef enum {
     JS_AUTOINIT_ID_PROTOTYPE,
     JS_AUTOINIT_ID_MODULE_NS,
     JS_AUTOINIT_ID_PROP,
+    JS_AUTOINIT_ID_LAZY, /* lazy intrinsics and JS_DefineLazyProperty() */
 } JSAutoInitIDEnum;
 
 /* must be large enough to have a negligible runtime cost and small
@@ -442,6 +475,9 @@ struct JSContext {
 
     JSValue global_obj; /* global object */
     JSValue global_var_obj; /* contains the global let/const definitions */
+    /* holds the global properties of the lazy intrinsics once created */
+    JSValue lazy_global_obj;
+    int lazy_intrinsics; /* JS_INTRINSIC_LAZY_x not created yet */
 
     uint64_t random_state;
 #ifdef CONFIG_BIGNUM
@@ -589,6 +625,28 @@ typedef enum JSFunctionKindEnum {
     JS_FUNC_ASYNC_GENERATOR = (JS_FUNC_GENERATOR | JS_FUNC_ASYNC),
 } JSFunctionKindEnum;
 
+#ifdef CONFIG_INLINE_CACHE
+/* maximum number of prototypes between an object and the holder of a
+   cached property */
+#define JS_IC_MAX_DEPTH   2
+/* an inline cache is no longer updated after this number of updates */
+#define JS_IC_MAX_UPDATES 64
+
+/* Inline cache of a get_field, get_field2, put_field, get_array_el or
+   get_array_el2 instruction. The cached shapes are referenced, so they
+   are never modified in place: js_shape_prepare_update() and
+   add_property() give a new shape to an object whose shape is shared. */
+typedef struct JSInlineCache {
+    uint32_t pos; /* position after the opcode, 0 if the slot is unused */
+    uint16_t class_id; /* class of the object */
+    uint8_t depth; /* the property is in the depth-th prototype */
+    uint8_t updates;
+    uint32_t prop_index; /* index of the property in its holder */
+    JSAtom key; /* get_array_el: key of the cached property */
+    JSShape *shapes[JS_IC_MAX_DEPTH + 1]; /* shapes[0] = NULL if empty */
+} JSInlineCache;
+#endif
+
 typedef struct JSFunctionBytecode {
     JSGCObjectHeader header; /* must come first */
     uint8_t js_mode;
@@ -605,7 +663,10 @@ typedef struct JSFunctionBytecode {
     uint8_t has_debug : 1;
     uint8_t backtrace_barrier : 1; /* stop backtrace on this function */
     uint8_t read_only_bytecode : 1;
-    /* XXX: 4 bits available */
+#ifdef CONFIG_INLINE_CACHE
+    uint8_t ic_initialized : 1; /* true once js_ic_init() was called */
+#endif
+    /* XXX: 3 bits available */
     uint8_t *byte_code_buf; /* (self pointer) */
     int byte_code_len;
     JSAtom func_name;
@@ -619,6 +680,12 @@ typedef struct JSFunctionBytecode {
     JSValue *cpool; /* constant pool (self pointer) */
     int cpool_count;
     int closure_var_count;
+#ifdef CONFIG_INLINE_CACHE
+    /* hash table of the inline caches, indexed by instruction position.
+       Allocated when the function is called for the first time */
+    uint8_t ic_bits; /* log2 of the table size */
+    JSInlineCache *ic_tab;
+#endif
     struct {
         /* debug info, move to separate structure to save memory? */
         JSAtom filename;
@@ -928,6 +995,9 @@ struct JSObject {
             uint8_t length;
             uint8_t cproto;
             int16_t magic;
+#ifdef CONFIG_PROFILE
+            int profile_index; /* 1 + index in rt->profile_cfuncs, 0 if none */
+#endif
         } cfunc;
         /* array part for fast arrays and typed arrays */
         struct { /* JS_CLASS_ARRAY, JS_CLASS_ARGUMENTS, JS_CLASS_UINT8C_ARRAY..JS_CLASS_FLOAT64_ARRAY */
@@ -1007,6 +1077,9 @@ static JSAtom __JS_NewAtomInit(JSRuntime *rt, const char *str, int len,
                                int atom_type);
 static void JS_FreeAtomStruct(JSRuntime *rt, JSAtomStruct *p);
 static void free_function_bytecode(JSRuntime *rt, JSFunctionBytecode *b);
+#ifdef CONFIG_INLINE_CACHE
+static void js_ic_init(JSRuntime *rt, JSFunctionBytecode *b);
+#endif
 static JSValue js_call_c_function(JSContext *ctx, JSValueConst func_obj,
                                   JSValueConst this_obj,
                                   int argc, JSValueConst *argv, int flags);
@@ -1256,6 +1329,9 @@ static JSValue js_module_ns_autoinit(JSContext *ctx, JSObject *p, JSAtom atom,
                                  void *opaque);
 static JSValue JS_InstantiateFunctionListItem2(JSContext *ctx, JSObject *p,
                                                JSAtom atom, void *opaque);
+static JSValue js_lazy_property_autoinit(JSContext *ctx, JSObject *p,
+                                         JSAtom atom, void *opaque);
+static int js_init_lazy_intrinsics(JSContext *ctx, int mask);
 void JS_SetUncatchableError(JSContext *ctx, JSValueConst val, BOOL flag);
 
 static const JSClassExoticMethods js_arguments_exotic_methods;
@@ -1623,6 +1699,7 @@ JSRuntime *JS_NewRuntime2(const JSMallocFunctions *mf, void *opaque)
     }
     rt->malloc_state = ms;
     rt->malloc_gc_threshold = 256 * 1024;
+    rt->interrupt_counter_init = JS_INTERRUPT_COUNTER_INIT;
 
 #ifdef CONFIG_BIGNUM
     bf_context_init(&rt->bf_ctx, js_bf_realloc, rt);
@@ -1683,7 +1760,7 @@ void JS_SetRuntimeOpaque(JSRuntime *rt, void *opaque)
 /* default memory allocation functions with memory limitation */
 static inline size_t js_def_malloc_usable_size(void *ptr)
 {
-    return 0;
+    return ckb_malloc_usable_size(ptr);
 }
 
 static void *js_def_malloc(JSMallocState *s, size_t size)
@@ -1746,18 +1823,7 @@ static const JSMallocFunctions def_malloc_funcs = {
     js_def_malloc,
     js_def_free,
     js_def_realloc,
-#if defined(__APPLE__)
-    malloc_size,
-#elif defined(_WIN32)
-    (size_t (*)(const void *))_msize,
-#elif defined(EMSCRIPTEN)
-    NULL,
-#elif defined(__linux__)
-    (size_t (*)(const void *))malloc_usable_size,
-#else
-    /* change this to `NULL,` if compilation fails */
-    NULL,
-#endif
+    ckb_malloc_usable_size,
 };
 
 JSRuntime *JS_NewRuntime(void)
@@ -1776,6 +1842,11 @@ void JS_SetGCThreshold(JSRuntime *rt, size_t gc_threshold)
     rt->malloc_gc_threshold = gc_threshold;
 }
 
+size_t JS_GetGCThreshold(JSRuntime *rt)
+{
+    return rt->malloc_gc_threshold;
+}
+
 #define malloc(s) malloc_is_forbidden(s)
 #define free(p) free_is_forbidden(p)
 #define realloc(p,s) realloc_is_forbidden(p,s)
@@ -1786,6 +1857,19 @@ void JS_SetInterruptHandler(JSRuntime *rt, JSInterruptHandler *cb, void *opaque)
     rt->interrupt_opaque = opaque;
 }
 
+void JS_SetInterruptCounter(JSRuntime *rt, int count)
+{
+    struct list_head *el;
+
+    count = max_int(count, 1);
+    rt->interrupt_counter_init = count;
+    /* take the new value into account at the next poll */
+    list_for_each(el, &rt->context_list) {
+        JSContext *ctx = list_entry(el, JSContext, link);
+        ctx->interrupt_counter = min_int(ctx->interrupt_counter, count);
+    }
+}
+
 void JS_SetCanBlock(JSRuntime *rt, BOOL can_block)
 {
     rt->can_block = can_block;
@@ -2137,6 +2221,7 @@ JSContext *JS_NewContextRaw(JSRuntime *rt)
     ctx->array_ctor = JS_NULL;
     ctx->regexp_ctor = JS_NULL;
     ctx->promise_ctor = JS_NULL;
+    ctx->lazy_global_obj = JS_UNDEFINED;
     init_list_head(&ctx->loaded_modules);
 
     JS_AddIntrinsicBasicObjects(ctx);
@@ -2243,6 +2328,7 @@ static void JS_MarkContext(JSRuntime *rt, JSContext *ctx,
 
     JS_MarkValue(rt, ctx->global_obj, mark_func);
     JS_MarkValue(rt, ctx->global_var_obj, mark_func);
+    JS_MarkValue(rt, ctx->lazy_global_obj, mark_func);
 
     JS_MarkValue(rt, ctx->throw_type_error, mark_func);
     JS_MarkValue(rt, ctx->eval_obj, mark_func);
@@ -2306,6 +2392,7 @@ void JS_FreeContext(JSContext *ctx)
 
     JS_FreeValue(ctx, ctx->global_obj);
     JS_FreeValue(ctx, ctx->global_var_obj);
+    JS_FreeValue(ctx, ctx->lazy_global_obj);
 
     JS_FreeValue(ctx, ctx->throw_type_error);
     JS_FreeValue(ctx, ctx->eval_obj);
@@ -2588,7 +2675,11 @@ static int JS_InitAtoms(JSRuntime *rt)
     rt->atom_count = 0;
     rt->atom_size = 0;
     rt->atom_free_index = 0;
-    if (JS_ResizeAtomHash(rt, 256))     /* there are at least 195 predefined atoms */
+    /* there are at least 195 predefined atoms and the initial context,
+       even with the lazy intrinsics, holds about 500: with 256 entries
+       the table would be resized, and its 512 atoms rehashed, as soon as
+       a script adds a few names of its own */
+    if (JS_ResizeAtomHash(rt, 512))
         return -1;
 
     p = js_atom_init;
@@ -4249,7 +4340,9 @@ static inline JSShapeProperty *get_shape_prop(JSShape *sh)
 
 static int init_shape_hash(JSRuntime *rt)
 {
-    rt->shape_hash_bits = 4;   /* 16 shapes */
+    /* the initial context creates about 50 shapes, which would take three
+       resizes starting from 16 */
+    rt->shape_hash_bits = 7;   /* 128 shapes */
     rt->shape_hash_size = 1 << rt->shape_hash_bits;
     rt->shape_hash_count = 0;
     rt->shape_hash = js_mallocz_rt(rt, sizeof(rt->shape_hash[0]) *
@@ -5032,6 +5125,9 @@ static JSValue JS_NewCFunction3(JSContext *ctx, JSCFunction *func,
     p->u.cfunc.length = length;
     p->u.cfunc.cproto = cproto;
     p->u.cfunc.magic = magic;
+#ifdef CONFIG_PROFILE
+    p->u.cfunc.profile_index = 0;
+#endif
     p->is_constructor = (cproto == JS_CFUNC_constructor ||
                          cproto == JS_CFUNC_constructor_magic ||
                          cproto == JS_CFUNC_constructor_or_func ||
@@ -5634,6 +5730,18 @@ static void mark_children(JSRuntime *rt, JSGCObjectHeader *gp,
             }
             if (b->realm)
                 mark_func(rt, &b->realm->header);
+#ifdef CONFIG_INLINE_CACHE
+            if (b->ic_tab) {
+                int j;
+                for(i = 0; i < (1 << b->ic_bits); i++) {
+                    JSInlineCache *ic = &b->ic_tab[i];
+                    if (ic->shapes[0]) {
+                        for(j = 0; j <= ic->depth; j++)
+                            mark_func(rt, &ic->shapes[j]->header);
+                    }
+                }
+            }
+#endif
         }
         break;
     case JS_GC_OBJ_TYPE_VAR_REF:
@@ -5695,6 +5803,7 @@ static void gc_decref(JSRuntime *rt)
     list_for_each_safe(el, el1, &rt->gc_obj_list) {
         p = list_entry(el, JSGCObjectHeader, link);
         assert(p->mark == 0);
+        rt->gc_stats.scanned++;
         mark_children(rt, p, gc_decref_child);
         p->mark = 1;
         if (p->ref_count == 0) {
@@ -5770,6 +5879,7 @@ static void gc_free_cycles(JSRuntime *rt)
             }
             JS_DumpGCObject(rt, p);
 #endif
+            rt->gc_stats.freed++;
             free_gc_object(rt, p);
             break;
         default:
@@ -5792,6 +5902,8 @@ static void gc_free_cycles(JSRuntime *rt)
 
 void JS_RunGC(JSRuntime *rt)
 {
+    uint64_t start = rt->gc_clock ? rt->gc_clock() : 0;
+
     /* decrement the reference of the children of each object. mark =
        1 after this pass. */
     gc_decref(rt);
@@ -5801,6 +5913,20 @@ void JS_RunGC(JSRuntime *rt)
 
     /* free the GC objects in a cycle */
     gc_free_cycles(rt);
+
+    rt->gc_stats.count++;
+    if (rt->gc_clock)
+        rt->gc_stats.time += rt->gc_clock() - start;
+}
+
+void JS_SetGCClock(JSRuntime *rt, JSGCClockFunc *clock)
+{
+    rt->gc_clock = clock;
+}
+
+void JS_GetGCStats(JSRuntime *rt, JSGCStats *s)
+{
+    *s = rt->gc_stats;
 }
 
 /* Return false if not an object or if the object has already been
@@ -5868,7 +5994,7 @@ static void compute_bytecode_size(JSFunctionBytecode *b, JSMemoryUsage_helper *h
             memory_used_count++;
             js_func_size += b->debug.source_len + 1;
         }
-        if (b->debug.pc2line_len) {
+        if (b->debug.pc2line_len && !b->read_only_bytecode) {
             memory_used_count++;
             hp->js_func_pc2line_count += 1;
             hp->js_func_pc2line_size += b->debug.pc2line_len;
@@ -6767,10 +6893,429 @@ static JSValue JS_ThrowTypeErrorInvalidClass(JSContext *ctx, int class_id)
     return JS_ThrowTypeErrorAtom(ctx, "%s object expected", name);
 }
 
+#ifdef CONFIG_PROFILE
+/* The profile is a calling context tree: there is one node per call
+   path, so that the collapsed stacks can be written. */
+typedef struct JSProfileNode {
+    struct JSProfileNode *parent;
+    struct JSProfileNode *first_child;
+    struct JSProfileNode *next_sibling;
+    /* the key of the function. Its bytecode may be freed and its address
+       reused, so the atoms are held instead */
+    JSAtom func_name;
+    JSAtom filename; /* JS_ATOM_NULL without debug info */
+    int line_num;
+    char *name; /* "func_name (filename:line)" */
+    uint64_t calls;
+    uint64_t cycles; /* inclusive */
+    uint64_t child_cycles;
+    uint64_t start; /* clock when the running call was entered */
+} JSProfileNode;
+
+typedef struct JSProfileCFunc {
+    void *func;
+    int magic;
+    char *name;
+    uint64_t calls;
+    uint64_t cycles; /* inclusive */
+    uint64_t start;
+    int depth; /* number of running calls */
+} JSProfileCFunc;
+
+typedef struct JSProfileEntry {
+    const char *name;
+    uint64_t calls;
+    uint64_t cycles;
+    uint64_t self_cycles;
+} JSProfileEntry;
+
+static char *js_profile_strdup(JSRuntime *rt, const char *str)
+{
+    size_t len = strlen(str) + 1;
+    char *p = js_malloc_rt(rt, len);
+    if (p)
+        memcpy(p, str, len);
+    return p;
+}
+
+static JSProfileNode *js_profile_new_node(JSRuntime *rt, JSProfileNode *parent,
+                                          JSFunctionBytecode *b)
+{
+    JSProfileNode *node;
+    char func_buf[ATOM_GET_STR_BUF_SIZE], file_buf[ATOM_GET_STR_BUF_SIZE];
+    char name[2 * ATOM_GET_STR_BUF_SIZE + 16];
+    const char *func_name;
+
+    if (!b) {
+        pstrcpy(name, sizeof(name), "<root>");
+    } else {
+        func_name = JS_AtomGetStrRT(rt, func_buf, sizeof(func_buf), b->func_name);
+        if (b->func_name == JS_ATOM_NULL || func_name[0] == '\0')
+            func_name = "<anonymous>";
+        if (b->has_debug) {
+            snprintf(name, sizeof(name), "%s (%s:%d)", func_name,
+                     JS_AtomGetStrRT(rt, file_buf, sizeof(file_buf),
+                                     b->debug.filename),
+                     b->debug.line_num);
+        } else {
+            pstrcpy(name, sizeof(name), func_name);
+        }
+    }
+    node = js_mallocz_rt(rt, sizeof(*node));
+    if (!node)
+        return NULL;
+    node->name = js_profile_strdup(rt, name);
+    if (!node->name) {
+        js_free_rt(rt, node);
+        return NULL;
+    }
+    if (b) {
+        node->func_name = JS_DupAtomRT(rt, b->func_name);
+        if (b->has_debug) {
+            node->filename = JS_DupAtomRT(rt, b->debug.filename);
+            node->line_num = b->debug.line_num;
+        }
+    }
+    node->parent = parent;
+    if (parent) {
+        node->next_sibling = parent->first_child;
+        parent->first_child = node;
+    }
+    return node;
+}
+
+int JS_EnableProfile(JSRuntime *rt, JSProfileClockFunc *clock)
+{
+    if (!rt->profile_root) {
+        rt->profile_root = js_profile_new_node(rt, NULL, NULL);
+        if (!rt->profile_root)
+            return -1;
+    }
+    rt->profile_clock = clock;
+    rt->profile_current = rt->profile_root;
+#ifdef CONFIG_PROFILE_OPCODE_CYCLES
+    rt->profile_op_last = -1;
+#endif
+    return 0;
+}
+
+static inline BOOL js_profile_node_match(JSProfileNode *node,
+                                          JSFunctionBytecode *b)
+{
+    if (node->func_name != b->func_name)
+        return FALSE;
+    if (b->has_debug)
+        return node->filename == b->debug.filename &&
+            node->line_num == b->debug.line_num;
+    return node->filename == JS_ATOM_NULL;
+}
+
+/* return NULL if profiling is disabled */
+static JSProfileNode *js_profile_enter(JSRuntime *rt, JSFunctionBytecode *b)
+{
+    JSProfileNode *parent, *node;
+
+    parent = rt->profile_current;
+    if (!parent)
+        return NULL;
+    for(node = parent->first_child; node != NULL; node = node->next_sibling) {
+        if (js_profile_node_match(node, b))
+            break;
+    }
+    if (!node) {
+        node = js_profile_new_node(rt, parent, b);
+        if (!node)
+            return NULL; /* the call is accounted to the caller */
+    }
+    node->calls++;
+    rt->profile_current = node;
+    node->start = rt->profile_clock();
+    return node;
+}
+
+static void js_profile_leave(JSRuntime *rt, JSProfileNode *node)
+{
+    uint64_t cycles;
+
+    if (!node)
+        return;
+    cycles = rt->profile_clock() - node->start;
+    node->cycles += cycles;
+    node->parent->child_cycles += cycles;
+    rt->profile_current = node->parent;
+}
+
+static inline int js_profile_opcode(JSRuntime *rt, int op)
+{
+    rt->profile_op_count[op]++;
+#ifdef CONFIG_PROFILE_OPCODE_CYCLES
+    if (rt->profile_clock) {
+        uint64_t now = rt->profile_clock();
+        if (rt->profile_op_last >= 0)
+            rt->profile_op_cycles[rt->profile_op_last] += now - rt->profile_op_start;
+        rt->profile_op_last = op;
+        rt->profile_op_start = now;
+    }
+#endif
+    return op;
+}
+
+/* return the index of the C function in rt->profile_cfuncs or -1 if
+   profiling is disabled */
+static int js_profile_cfunc_enter(JSContext *ctx, JSObject *p)
+{
+    JSRuntime *rt = ctx->rt;
+    JSProfileCFunc *e, *new_cfuncs;
+    const char *name;
+    int i, new_size;
+
+    if (!rt->profile_clock)
+        return -1;
+    i = p->u.cfunc.profile_index - 1;
+    if (i < 0) {
+        for(i = 0; i < rt->profile_cfunc_count; i++) {
+            e = &rt->profile_cfuncs[i];
+            if (e->func == (void *)p->u.cfunc.c_function.generic &&
+                e->magic == p->u.cfunc.magic)
+                break;
+        }
+        if (i == rt->profile_cfunc_count) {
+            if (rt->profile_cfunc_count >= rt->profile_cfunc_size) {
+                new_size = max_int(16, rt->profile_cfunc_size * 3 / 2);
+                new_cfuncs = js_realloc_rt(rt, rt->profile_cfuncs,
+                                           sizeof(JSProfileCFunc) * new_size);
+                if (!new_cfuncs)
+                    return -1;
+                rt->profile_cfuncs = new_cfuncs;
+                rt->profile_cfunc_size = new_size;
+            }
+            e = &rt->profile_cfuncs[i];
+            memset(e, 0, sizeof(*e));
+            e->func = (void *)p->u.cfunc.c_function.generic;
+            e->magic = p->u.cfunc.magic;
+            name = get_func_name(ctx, JS_MKPTR(JS_TAG_OBJECT, p));
+            e->name = js_profile_strdup(rt, (name && name[0] != '\0') ? name : "<anonymous>");
+            JS_FreeCString(ctx, name);
+            if (!e->name)
+                return -1;
+            rt->profile_cfunc_count++;
+        }
+        p->u.cfunc.profile_index = i + 1;
+    }
+    e = &rt->profile_cfuncs[i];
+    e->calls++;
+    if (e->depth++ == 0)
+        e->start = rt->profile_clock();
+    return i;
+}
+
+static void js_profile_cfunc_leave(JSRuntime *rt, int i)
+{
+    JSProfileCFunc *e;
+
+    if (i < 0)
+        return;
+    e = &rt->profile_cfuncs[i];
+    /* recursive calls are included in the outermost call */
+    if (--e->depth == 0)
+        e->cycles += rt->profile_clock() - e->start;
+}
+
+static int js_profile_add_entry(JSRuntime *rt, JSProfileEntry **pentries,
+                                int *pcount, int *psize, JSProfileNode *node)
+{
+    JSProfileEntry *e, *new_entries;
+    JSProfileNode *p;
+    int i, new_size;
+
+    for(i = 0; i < *pcount; i++) {
+        if (!strcmp((*pentries)[i].name, node->name))
+            break;
+    }
+    if (i == *pcount) {
+        if (*pcount >= *psize) {
+            new_size = max_int(16, *psize * 3 / 2);
+            new_entries = js_realloc_rt(rt, *pentries,
+                                        sizeof(JSProfileEntry) * new_size);
+            if (!new_entries)
+                return -1;
+            *pentries = new_entries;
+            *psize = new_size;
+        }
+        e = &(*pentries)[(*pcount)++];
+        memset(e, 0, sizeof(*e));
+        e->name = node->name;
+    }
+    e = &(*pentries)[i];
+    e->calls += node->calls;
+    e->self_cycles += node->cycles - node->child_cycles;
+    /* recursive calls are already included in the outermost call */
+    for(p = node->parent; p != NULL; p = p->parent) {
+        if (!strcmp(p->name, node->name))
+            return 0;
+    }
+    e->cycles += node->cycles;
+    return 0;
+}
+
+static int js_profile_entry_cmp(const void *a, const void *b, void *opaque)
+{
+    const JSProfileEntry *e1 = a, *e2 = b;
+    if (e1->self_cycles != e2->self_cycles)
+        return e1->self_cycles < e2->self_cycles ? 1 : -1;
+    return strcmp(e1->name, e2->name);
+}
+
+static int js_profile_cfunc_cmp(const void *a, const void *b, void *opaque)
+{
+    const JSProfileCFunc *e1 = a, *e2 = b;
+    if (e1->cycles != e2->cycles)
+        return e1->cycles < e2->cycles ? 1 : -1;
+    return strcmp(e1->name, e2->name);
+}
+
+static const char * const js_profile_opcode_names[OP_COUNT] = {
+#define FMT(f)
+#define DEF(id, size, n_pop, n_push, f) #id,
+#define def(id, size, n_pop, n_push, f)
+#include "quickjs-opcode.h"
+#undef def
+#undef DEF
+#undef FMT
+};
+
+static int js_profile_opcode_cmp(const void *a, const void *b, void *opaque)
+{
+    JSRuntime *rt = opaque;
+    int op1 = *(const uint8_t *)a, op2 = *(const uint8_t *)b;
+    if (rt->profile_op_count[op1] != rt->profile_op_count[op2])
+        return rt->profile_op_count[op1] < rt->profile_op_count[op2] ? 1 : -1;
+    return op1 - op2;
+}
+
+static void js_profile_dump_stacks(JSRuntime *rt, JSProfileNode *node,
+                                   DynBuf *path, JSProfileWriteFunc *write,
+                                   void *opaque, JSProfileEntry **pentries,
+                                   int *pcount, int *psize)
+{
+    JSProfileNode *child;
+    size_t len, path_len;
+
+    len = path->size;
+    if (len != 0)
+        dbuf_putc(path, ';');
+    dbuf_putstr(path, node->name);
+    path_len = path->size;
+    dbuf_printf(path, " %" PRIu64, node->cycles - node->child_cycles);
+    dbuf_putc(path, '\0');
+    if (!path->error) {
+        write(opaque, (const char *)path->buf);
+        js_profile_add_entry(rt, pentries, pcount, psize, node);
+    }
+    path->size = path_len;
+    for(child = node->first_child; child != NULL; child = child->next_sibling) {
+        js_profile_dump_stacks(rt, child, path, write, opaque,
+                               pentries, pcount, psize);
+    }
+    path->size = len;
+}
+
+void JS_DumpProfile(JSRuntime *rt, JSProfileWriteFunc *write, void *opaque)
+{
+    JSProfileNode *root, *node, *child;
+    JSProfileEntry *entries;
+    JSProfileCFunc *cfuncs;
+    int i, count, size;
+    uint64_t now;
+    DynBuf path;
+    char line[128];
+    uint8_t ops[OP_COUNT];
+
+    root = rt->profile_root;
+    if (!root)
+        return;
+    /* account the calls which are still running (e.g. ckb.exit()) */
+    now = rt->profile_clock();
+    for(node = rt->profile_current; node != root; node = node->parent) {
+        node->cycles += now - node->start;
+        node->parent->child_cycles += now - node->start;
+        node->start = now;
+    }
+
+    entries = NULL;
+    count = 0;
+    size = 0;
+    dbuf_init2(&path, rt, (DynBufReallocFunc *)js_realloc_rt);
+    write(opaque, "profile: stacks");
+    for(child = root->first_child; child != NULL; child = child->next_sibling) {
+        js_profile_dump_stacks(rt, child, &path, write, opaque,
+                               &entries, &count, &size);
+    }
+    dbuf_free(&path);
+
+    write(opaque, "profile: functions");
+    snprintf(line, sizeof(line), "%10s %14s %14s  %s",
+             "calls", "inclusive", "exclusive", "function");
+    write(opaque, line);
+    rqsort(entries, count, sizeof(entries[0]), js_profile_entry_cmp, NULL);
+    for(i = 0; i < count; i++) {
+        snprintf(line, sizeof(line), "%10" PRIu64 " %14" PRIu64 " %14" PRIu64 "  %s",
+                 entries[i].calls, entries[i].cycles, entries[i].self_cycles,
+                 entries[i].name);
+        write(opaque, line);
+    }
+    snprintf(line, sizeof(line), "%10s %14" PRIu64 " %14s  %s",
+             "", root->child_cycles, "", "total");
+    write(opaque, line);
+    js_free_rt(rt, entries);
+
+    /* the running C functions are not accounted */
+    write(opaque, "profile: native functions");
+    snprintf(line, sizeof(line), "%10s %14s  %s", "calls", "inclusive", "function");
+    write(opaque, line);
+    /* sort a copy: the indexes are kept in the function objects */
+    cfuncs = js_malloc_rt(rt, sizeof(JSProfileCFunc) * max_int(rt->profile_cfunc_count, 1));
+    if (cfuncs) {
+        memcpy(cfuncs, rt->profile_cfuncs, sizeof(JSProfileCFunc) * rt->profile_cfunc_count);
+        rqsort(cfuncs, rt->profile_cfunc_count, sizeof(JSProfileCFunc),
+               js_profile_cfunc_cmp, NULL);
+        for(i = 0; i < rt->profile_cfunc_count; i++) {
+            snprintf(line, sizeof(line), "%10" PRIu64 " %14" PRIu64 "  %s",
+                     cfuncs[i].calls, cfuncs[i].cycles, cfuncs[i].name);
+            write(opaque, line);
+        }
+        js_free_rt(rt, cfuncs);
+    }
+
+    write(opaque, "profile: opcodes");
+#ifdef CONFIG_PROFILE_OPCODE_CYCLES
+    snprintf(line, sizeof(line), "%14s %14s  %s", "count", "cycles", "opcode");
+#else
+    snprintf(line, sizeof(line), "%14s  %s", "count", "opcode");
+#endif
+    write(opaque, line);
+    for(i = 0; i < OP_COUNT; i++)
+        ops[i] = i;
+    rqsort(ops, OP_COUNT, sizeof(ops[0]), js_profile_opcode_cmp, rt);
+    for(i = 0; i < OP_COUNT && rt->profile_op_count[ops[i]] != 0; i++) {
+#ifdef CONFIG_PROFILE_OPCODE_CYCLES
+        snprintf(line, sizeof(line), "%14" PRIu64 " %14" PRIu64 "  %s",
+                 rt->profile_op_count[ops[i]], rt->profile_op_cycles[ops[i]],
+                 js_profile_opcode_names[ops[i]]);
+#else
+        snprintf(line, sizeof(line), "%14" PRIu64 "  %s",
+                 rt->profile_op_count[ops[i]], js_profile_opcode_names[ops[i]]);
+#endif
+        write(opaque, line);
+    }
+    write(opaque, "profile: end");
+}
+#endif /* CONFIG_PROFILE */
+
 static no_inline __exception int __js_poll_interrupts(JSContext *ctx)
 {
     JSRuntime *rt = ctx->rt;
-    ctx->interrupt_counter = JS_INTERRUPT_COUNTER_INIT;
+    ctx->interrupt_counter = rt->interrupt_counter_init;
     if (rt->interrupt_handler) {
         if (rt->interrupt_handler(rt, rt->interrupt_opaque)) {
             /* XXX: should set a specific flag to avoid catching */
@@ -6868,7 +7413,9 @@ int JS_SetPrototype(JSContext *ctx, JSValueConst obj, JSValueConst proto_val)
     return JS_SetPrototypeInternal(ctx, obj, proto_val, TRUE);
 }
 
-/* Only works for primitive types, otherwise return JS_NULL. */
+/* Only works for primitive types, otherwise return JS_NULL. Return
+   JS_EXCEPTION if the lazy intrinsics holding the prototype cannot be
+   created. */
 static JSValueConst JS_GetPrototypePrimitive(JSContext *ctx, JSValueConst val)
 {
     switch(JS_VALUE_GET_NORM_TAG(val)) {
@@ -6877,9 +7424,13 @@ static JSValueConst JS_GetPrototypePrimitive(JSContext *ctx, JSValueConst val)
         val = ctx->class_proto[JS_CLASS_BIG_INT];
         break;
     case JS_TAG_BIG_FLOAT:
+        if (js_init_lazy_intrinsics(ctx, JS_INTRINSIC_LAZY_BIGNUM))
+            return JS_EXCEPTION;
         val = ctx->class_proto[JS_CLASS_BIG_FLOAT];
         break;
     case JS_TAG_BIG_DECIMAL:
+        if (js_init_lazy_intrinsics(ctx, JS_INTRINSIC_LAZY_BIGNUM))
+            return JS_EXCEPTION;
         val = ctx->class_proto[JS_CLASS_BIG_DECIMAL];
         break;
 #endif
@@ -7042,6 +7593,7 @@ static JSAutoInitFunc *js_autoinit_func_table[] = {
     js_instantiate_prototype, /* JS_AUTOINIT_ID_PROTOTYPE */
     js_module_ns_autoinit, /* JS_AUTOINIT_ID_MODULE_NS */
     JS_InstantiateFunctionListItem2, /* JS_AUTOINIT_ID_PROP */
+    js_lazy_property_autoinit, /* JS_AUTOINIT_ID_LAZY */
 };
 
 /* warning: 'prs' is reallocated after it */
@@ -7075,6 +7627,7 @@ JSValue JS_GetPropertyInternal(JSContext *ctx, JSValueConst obj,
     JSObject *p;
     JSProperty *pr;
     JSShapeProperty *prs;
+    JSValueConst proto;
     uint32_t tag;
 
     tag = JS_VALUE_GET_TAG(obj);
@@ -7107,8 +7660,10 @@ JSValue JS_GetPropertyInternal(JSContext *ctx, JSValueConst obj,
         default:
             break;
         }
-        /* cannot raise an exception */
-        p = JS_VALUE_GET_OBJ(JS_GetPrototypePrimitive(ctx, obj));
+        proto = JS_GetPrototypePrimitive(ctx, obj);
+        if (JS_IsException(proto))
+            return JS_EXCEPTION;
+        p = JS_VALUE_GET_OBJ(proto);
         if (!p)
             return JS_UNDEFINED;
     } else {
@@ -8425,6 +8980,7 @@ int JS_SetPropertyInternal(JSContext *ctx, JSValueConst this_obj,
     JSProperty *pr;
     uint32_t tag;
     JSPropertyDescriptor desc;
+    JSValueConst proto;
     int ret;
 #if 0
     printf("JS_SetPropertyInternal: "); print_atom(ctx, prop); printf("\n");
@@ -8442,8 +8998,13 @@ int JS_SetPropertyInternal(JSContext *ctx, JSValueConst this_obj,
             return -1;
         default:
             /* even on a primitive type we can have setters on the prototype */
+            proto = JS_GetPrototypePrimitive(ctx, this_obj);
+            if (JS_IsException(proto)) {
+                JS_FreeValue(ctx, val);
+                return -1;
+            }
             p = NULL;
-            p1 = JS_VALUE_GET_OBJ(JS_GetPrototypePrimitive(ctx, this_obj));
+            p1 = JS_VALUE_GET_OBJ(proto);
             goto prototype_lookup;
         }
     }
@@ -9790,6 +10351,14 @@ void JS_SetOpaque(JSValue obj, void *opaque)
     }
 }
 
+/* return 0 if not an object */
+JSClassID JS_GetClassID(JSValueConst obj)
+{
+    if (JS_VALUE_GET_TAG(obj) != JS_TAG_OBJECT)
+        return 0;
+    return JS_VALUE_GET_OBJ(obj)->class_id;
+}
+
 /* return NULL if not an object of class class_id */
 void *JS_GetOpaque(JSValueConst obj, JSClassID class_id)
 {
@@ -10016,7 +10585,7 @@ static double js_strtod(const char *p, int radix, BOOL is_float)
     double d;
     int c;
     
-    if (!is_float || radix != 10) {
+    if (radix != 10) {
         uint64_t n_max, n;
         int int_exp, is_neg;
         
@@ -10030,10 +10599,7 @@ static double js_strtod(const char *p, int radix, BOOL is_float)
         while (*p == '0')
             p++;
         n = 0;
-        if (radix == 10)
-            n_max = ((uint64_t)-1 - 9) / 10; /* most common case */
-        else
-            n_max = ((uint64_t)-1 - (radix - 1)) / radix;
+        n_max = ((uint64_t)-1 - (radix - 1)) / radix;
         /* XXX: could be more precise */
         int_exp = 0;
         while (*p != '\0') {
@@ -10054,6 +10620,7 @@ static double js_strtod(const char *p, int radix, BOOL is_float)
         if (is_neg)
             d = -d;
     } else {
+        /* exact, also for the integers of more than 19 digits */
         d = strtod(p, NULL);
     }
     return d;
@@ -11327,54 +11894,37 @@ static int js_ecvt(double d, int n_digits, int *decpt, int *sign, char *buf,
     char buf_tmp[JS_DTOA_BUF_SIZE];
 
     if (!is_fixed) {
-        unsigned int n_digits_min, n_digits_max;
-        /* find the minimum amount of digits (XXX: inefficient but simple) */
-        n_digits_min = 1;
-        n_digits_max = 17;
-        while (n_digits_min < n_digits_max) {
-            n_digits = (n_digits_min + n_digits_max) / 2;
-            js_ecvt1(d, n_digits, decpt, sign, buf, FE_TONEAREST,
-                     buf_tmp, sizeof(buf_tmp));
-            if (strtod(buf_tmp, NULL) == d) {
-                /* no need to keep the trailing zeros */
-                while (n_digits >= 2 && buf[n_digits - 1] == '0')
-                    n_digits--;
-                n_digits_max = n_digits;
-            } else {
-                n_digits_min = n_digits + 1;
-            }
-        }
-        n_digits = n_digits_max;
-        rounding_mode = FE_TONEAREST;
-    } else {
-        rounding_mode = FE_TONEAREST;
+        /* shortest representation that reads back as d, without printf
+           and floating point operations */
+        return dtoa_shortest(buf, decpt, sign, d);
+    }
+    rounding_mode = FE_TONEAREST;
 #ifdef CONFIG_PRINTF_RNDN
-        {
-            char buf1[JS_DTOA_BUF_SIZE], buf2[JS_DTOA_BUF_SIZE];
-            int decpt1, sign1, decpt2, sign2;
-            /* The JS rounding is specified as round to nearest ties away
-               from zero (RNDNA), but in printf the "ties" case is not
-               specified (for example it is RNDN for glibc, RNDNA for
-               Windows), so we must round manually. */
-            js_ecvt1(d, n_digits + 1, &decpt1, &sign1, buf1, FE_TONEAREST,
+    {
+        char buf1[JS_DTOA_BUF_SIZE], buf2[JS_DTOA_BUF_SIZE];
+        int decpt1, sign1, decpt2, sign2;
+        /* The JS rounding is specified as round to nearest ties away
+           from zero (RNDNA), but in printf the "ties" case is not
+           specified (for example it is RNDN for glibc, RNDNA for
+           Windows), so we must round manually. */
+        js_ecvt1(d, n_digits + 1, &decpt1, &sign1, buf1, FE_TONEAREST,
+                 buf_tmp, sizeof(buf_tmp));
+        /* XXX: could use 2 digits to reduce the average running time */
+        if (buf1[n_digits] == '5') {
+            js_ecvt1(d, n_digits + 1, &decpt1, &sign1, buf1, FE_DOWNWARD,
                      buf_tmp, sizeof(buf_tmp));
-            /* XXX: could use 2 digits to reduce the average running time */
-            if (buf1[n_digits] == '5') {
-                js_ecvt1(d, n_digits + 1, &decpt1, &sign1, buf1, FE_DOWNWARD,
-                         buf_tmp, sizeof(buf_tmp));
-                js_ecvt1(d, n_digits + 1, &decpt2, &sign2, buf2, FE_UPWARD,
-                         buf_tmp, sizeof(buf_tmp));
-                if (memcmp(buf1, buf2, n_digits + 1) == 0 && decpt1 == decpt2) {
-                    /* exact result: round away from zero */
-                    if (sign1)
-                        rounding_mode = FE_DOWNWARD;
-                    else
-                        rounding_mode = FE_UPWARD;
-                }
+            js_ecvt1(d, n_digits + 1, &decpt2, &sign2, buf2, FE_UPWARD,
+                     buf_tmp, sizeof(buf_tmp));
+            if (memcmp(buf1, buf2, n_digits + 1) == 0 && decpt1 == decpt2) {
+                /* exact result: round away from zero */
+                if (sign1)
+                    rounding_mode = FE_DOWNWARD;
+                else
+                    rounding_mode = FE_UPWARD;
             }
         }
-#endif /* CONFIG_PRINTF_RNDN */
     }
+#endif /* CONFIG_PRINTF_RNDN */
     js_ecvt1(d, n_digits, decpt, sign, buf, rounding_mode,
              buf_tmp, sizeof(buf_tmp));
     return n_digits;
@@ -11467,7 +12017,7 @@ static void js_dtoa1(char *buf, double d, int radix, int n_digits, int flags)
         if (flags == JS_DTOA_FRAC_FORMAT) {
             js_fcvt(buf, JS_DTOA_BUF_SIZE, d, n_digits);
         } else {
-            char buf1[JS_DTOA_BUF_SIZE];
+            char buf1[JS_DTOA_BUF_SIZE], buf2[16];
             int sign, decpt, k, n, i, p, n_max;
             BOOL is_fixed;
         generic_conv:
@@ -11522,7 +12072,7 @@ static void js_dtoa1(char *buf, double d, int radix, int n_digits, int flags)
                 p = n - 1;
                 if (p >= 0)
                     *q++ = '+';
-                sprintf(q, "%d", p);
+                strcpy(q, i64toa(buf2 + sizeof(buf2), p, 10));
             }
         }
     }
@@ -11547,8 +12097,7 @@ JSValue JS_ToStringInternal(JSContext *ctx, JSValueConst val, BOOL is_ToProperty
     case JS_TAG_STRING:
         return JS_DupValue(ctx, val);
     case JS_TAG_INT:
-        snprintf(buf, sizeof(buf), "%d", JS_VALUE_GET_INT(val));
-        str = buf;
+        str = i64toa(buf + sizeof(buf), JS_VALUE_GET_INT(val), 10);
         goto new_string;
     case JS_TAG_BOOL:
         return JS_AtomToString(ctx, JS_VALUE_GET_BOOL(val) ?
@@ -16016,6 +16565,9 @@ static JSValue js_call_c_function(JSContext *ctx, JSValueConst func_obj,
     JSValueConst *arg_buf;
     int arg_count, i;
     JSCFunctionEnum cproto;
+#ifdef CONFIG_PROFILE
+    int prof_index;
+#endif
 
     p = JS_VALUE_GET_OBJ(func_obj);
     cproto = p->u.cfunc.cproto;
@@ -16056,6 +16608,9 @@ static JSValue js_call_c_function(JSContext *ctx, JSValueConst func_obj,
     }
     sf->arg_buf = (JSValue*)arg_buf;
 
+#ifdef CONFIG_PROFILE
+    prof_index = js_profile_cfunc_enter(ctx, p);
+#endif
     func = p->u.cfunc.c_function;
     switch(cproto) {
     case JS_CFUNC_constructor:
@@ -16140,6 +16695,9 @@ static JSValue js_call_c_function(JSContext *ctx, JSValueConst func_obj,
         abort();
     }
 
+#ifdef CONFIG_PROFILE
+    js_profile_cfunc_leave(rt, prof_index);
+#endif
     rt->current_stack_frame = sf->prev_frame;
     return ret_val;
 }
@@ -16193,6 +16751,216 @@ typedef enum {
 #define FUNC_RET_YIELD      1
 #define FUNC_RET_YIELD_STAR 2
 
+#ifdef CONFIG_INLINE_CACHE
+static inline BOOL js_ic_is_cached_opcode(int op)
+{
+    return (op == OP_get_field || op == OP_get_field2 || op == OP_put_field ||
+            op == OP_get_array_el || op == OP_get_array_el2
+#if SHORT_OPCODES
+            || op == OP_get_loc_get_field || op == OP_get_loc_get_field2 ||
+            op == OP_get_loc_get_array_el
+#endif
+            );
+}
+
+/* the low bits of the position are the hash. Cached instructions can be
+   adjacent (get_array_el is 1 byte), so a collision can move an entry into
+   the slot of the next instruction: lookups rely on linear probing, and the
+   table is kept at most half full */
+static inline uint32_t js_ic_hash(uint32_t pos, uint32_t mask)
+{
+    return pos & mask;
+}
+
+/* return NULL if the instruction has no inline cache */
+static inline JSInlineCache *js_ic_find(JSFunctionBytecode *b,
+                                        const uint8_t *pc)
+{
+    JSInlineCache *ic;
+    uint32_t pos, h, mask;
+
+    if (unlikely(!b->ic_tab))
+        return NULL;
+    pos = pc - b->byte_code_buf;
+    mask = (1 << b->ic_bits) - 1;
+    h = js_ic_hash(pos, mask);
+    for(;;) {
+        ic = &b->ic_tab[h];
+        if (likely(ic->pos == pos))
+            return ic;
+        if (ic->pos == 0)
+            return NULL;
+        h = (h + 1) & mask;
+    }
+}
+
+static void js_ic_clear(JSRuntime *rt, JSInlineCache *ic)
+{
+    int i;
+
+    if (ic->shapes[0]) {
+        for(i = 0; i <= ic->depth; i++)
+            js_free_shape(rt, ic->shapes[i]);
+        ic->shapes[0] = NULL;
+    }
+    if (ic->key != JS_ATOM_NULL) {
+        JS_FreeAtomRT(rt, ic->key);
+        ic->key = JS_ATOM_NULL;
+    }
+}
+
+/* the exotic behaviors of arrays only concern the array indexes. Typed
+   arrays also have an exotic behavior for the other numeric strings. */
+static inline BOOL js_ic_is_cacheable(JSObject *p, JSAtom atom)
+{
+    if (!p->is_exotic)
+        return TRUE;
+    return (p->fast_array && !__JS_AtomIsTaggedInt(atom) &&
+            (p->class_id == JS_CLASS_ARRAY ||
+             p->class_id == JS_CLASS_ARGUMENTS));
+}
+
+/* return the object holding the property if the cache is valid for 'p' */
+static inline JSObject *js_ic_get_holder(JSInlineCache *ic, JSObject *p)
+{
+    int i;
+
+    if (p->shape != ic->shapes[0] || p->class_id != ic->class_id)
+        return NULL;
+    for(i = 1; i <= ic->depth; i++) {
+        p = ic->shapes[i - 1]->proto;
+        if (p->shape != ic->shapes[i])
+            return NULL;
+    }
+    return p;
+}
+
+/* Look up a data property in 'p' and its prototypes and cache it. For
+   put_field, only a writable own property is cached. Return the object
+   holding the property, or NULL if it cannot be cached. */
+static JSObject *js_ic_update(JSContext *ctx, JSInlineCache *ic, JSObject *p,
+                              JSAtom atom, BOOL is_put)
+{
+    JSShape *shapes[JS_IC_MAX_DEPTH + 1];
+    JSShapeProperty *prs;
+    JSProperty *pr;
+    JSObject *p1;
+    int depth, i;
+
+    if (ic->updates >= JS_IC_MAX_UPDATES)
+        return NULL;
+    ic->updates++;
+    p1 = p;
+    for(depth = 0;; depth++) {
+        if (!js_ic_is_cacheable(p1, atom) || !p1->shape->is_hashed)
+            return NULL;
+        shapes[depth] = p1->shape;
+        prs = find_own_property(&pr, p1, atom);
+        if (prs)
+            break;
+        if (is_put || depth == JS_IC_MAX_DEPTH)
+            return NULL;
+        p1 = p1->shape->proto;
+        if (!p1)
+            return NULL;
+    }
+    if (is_put) {
+        if ((prs->flags & (JS_PROP_TMASK | JS_PROP_WRITABLE |
+                           JS_PROP_LENGTH)) != JS_PROP_WRITABLE)
+            return NULL;
+    } else {
+        if (prs->flags & JS_PROP_TMASK)
+            return NULL;
+    }
+    js_ic_clear(ctx->rt, ic);
+    for(i = 0; i <= depth; i++)
+        ic->shapes[i] = js_dup_shape(shapes[i]);
+    ic->depth = depth;
+    ic->class_id = p->class_id;
+    ic->prop_index = prs - get_shape_prop(shapes[depth]);
+    return p1;
+}
+
+/* return the data property found with the inline cache of the
+   instruction at 'pc', or NULL if the generic lookup must be used */
+static inline JSProperty *js_ic_get_field(JSContext *ctx, JSFunctionBytecode *b,
+                                          const uint8_t *pc, JSValueConst obj,
+                                          JSAtom atom)
+{
+    JSInlineCache *ic;
+    JSObject *p, *p1;
+
+    if (unlikely(JS_VALUE_GET_TAG(obj) != JS_TAG_OBJECT))
+        return NULL;
+    ic = js_ic_find(b, pc);
+    if (unlikely(!ic))
+        return NULL;
+    p = JS_VALUE_GET_OBJ(obj);
+    p1 = js_ic_get_holder(ic, p);
+    if (unlikely(!p1)) {
+        p1 = js_ic_update(ctx, ic, p, atom, FALSE);
+        if (!p1)
+            return NULL;
+    }
+    return &p1->prop[ic->prop_index];
+}
+
+/* same as js_ic_get_field() for a string property key. Not inlined so
+   that the accesses with an integer index are not slowed down. */
+static no_inline JSProperty *js_ic_get_array_el(JSContext *ctx,
+                                                JSFunctionBytecode *b,
+                                                const uint8_t *pc,
+                                                JSValueConst obj,
+                                                JSValueConst prop)
+{
+    JSInlineCache *ic;
+    JSObject *p, *p1;
+    JSString *str;
+    JSAtom atom;
+
+    if (JS_VALUE_GET_TAG(obj) != JS_TAG_OBJECT)
+        return NULL;
+    str = JS_VALUE_GET_STRING(prop);
+    if (str->atom_type != JS_ATOM_TYPE_STRING)
+        return NULL;
+    ic = js_ic_find(b, pc);
+    if (unlikely(!ic))
+        return NULL;
+    p = JS_VALUE_GET_OBJ(obj);
+    if (ic->key == JS_ATOM_NULL || ctx->rt->atom_array[ic->key] != str ||
+        !(p1 = js_ic_get_holder(ic, p))) {
+        atom = js_get_atom_index(ctx->rt, str);
+        p1 = js_ic_update(ctx, ic, p, atom, FALSE);
+        if (!p1)
+            return NULL;
+        ic->key = JS_DupAtom(ctx, atom);
+    }
+    return &p1->prop[ic->prop_index];
+}
+
+/* return the writable own data property found with the inline cache of
+   the instruction at 'pc', or NULL if the generic lookup must be used */
+static inline JSProperty *js_ic_put_field(JSContext *ctx, JSFunctionBytecode *b,
+                                          const uint8_t *pc, JSValueConst obj,
+                                          JSAtom atom)
+{
+    JSInlineCache *ic;
+    JSObject *p;
+
+    if (unlikely(JS_VALUE_GET_TAG(obj) != JS_TAG_OBJECT))
+        return NULL;
+    ic = js_ic_find(b, pc);
+    if (unlikely(!ic))
+        return NULL;
+    p = JS_VALUE_GET_OBJ(obj);
+    if (unlikely(p->shape != ic->shapes[0] || p->class_id != ic->class_id)) {
+        if (!js_ic_update(ctx, ic, p, atom, TRUE))
+            return NULL;
+    }
+    return &p->prop[ic->prop_index];
+}
+#endif /* CONFIG_INLINE_CACHE */
+
 /* argv[] is modified if (flags & JS_CALL_FLAG_COPY_ARGV) = 0. */
 static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
                                JSValueConst this_obj, JSValueConst new_target,
@@ -16208,9 +16976,17 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
     JSValue *local_buf, *stack_buf, *var_buf, *arg_buf, *sp, ret_val, *pval;
     JSVarRef **var_refs;
     size_t alloca_size;
+#ifdef CONFIG_PROFILE
+    JSProfileNode *prof_node;
+#endif
 
+#ifdef CONFIG_PROFILE
+#define FETCH_OPCODE(pc) js_profile_opcode(rt, *pc++)
+#else
+#define FETCH_OPCODE(pc) (*pc++)
+#endif
 #if !DIRECT_DISPATCH
-#define SWITCH(pc)      switch (opcode = *pc++)
+#define SWITCH(pc)      switch (opcode = FETCH_OPCODE(pc))
 #define CASE(op)        case op
 #define DEFAULT         default
 #define BREAK           break
@@ -16225,7 +17001,7 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
 #include "quickjs-opcode.h"
         [ OP_COUNT ... 255 ] = &&case_default
     };
-#define SWITCH(pc)      goto *dispatch_table[opcode = *pc++];
+#define SWITCH(pc)      goto *dispatch_table[opcode = FETCH_OPCODE(pc)];
 #define CASE(op)        case_ ## op
 #define DEFAULT         case_default
 #define BREAK           SWITCH(pc)
@@ -16249,8 +17025,15 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
             sp = sf->cur_sp;
             sf->cur_sp = NULL; /* cur_sp is NULL if the function is running */
             pc = sf->cur_pc;
+#ifdef CONFIG_INLINE_CACHE
+            if (unlikely(!b->ic_initialized))
+                js_ic_init(rt, b);
+#endif
             sf->prev_frame = rt->current_stack_frame;
             rt->current_stack_frame = sf;
+#ifdef CONFIG_PROFILE
+            prof_node = js_profile_enter(rt, b);
+#endif
             if (s->throw_flag)
                 goto exception;
             else
@@ -16271,6 +17054,10 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
                          (JSValueConst *)argv, flags);
     }
     b = p->u.func.function_bytecode;
+#ifdef CONFIG_INLINE_CACHE
+    if (unlikely(!b->ic_initialized))
+        js_ic_init(rt, b);
+#endif
 
     if (unlikely(argc < b->arg_count || (flags & JS_CALL_FLAG_COPY_ARGV))) {
         arg_allocated_size = b->arg_count;
@@ -16315,6 +17102,9 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
     sf->prev_frame = rt->current_stack_frame;
     rt->current_stack_frame = sf;
     ctx = b->realm; /* set the current realm */
+#ifdef CONFIG_PROFILE
+    prof_node = js_profile_enter(rt, b);
+#endif
     
  restart:
     for(;;) {
@@ -17534,10 +18324,76 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
         CASE(OP_get_field):
             {
                 JSValue val;
+#ifdef CONFIG_INLINE_CACHE
+                JSProperty *pr;
+#endif
+                JSAtom atom;
+                atom = get_u32(pc);
+                pc += 4;
+
+#ifdef CONFIG_INLINE_CACHE
+                pr = js_ic_get_field(ctx, b, pc - 4, sp[-1], atom);
+                if (pr) {
+                    val = JS_DupValue(ctx, pr->u.value);
+                } else
+#endif
+                {
+                    val = JS_GetProperty(ctx, sp[-1], atom);
+                    if (unlikely(JS_IsException(val)))
+                        goto exception;
+                }
+                JS_FreeValue(ctx, sp[-1]);
+                sp[-1] = val;
+            }
+            BREAK;
+
+        CASE(OP_get_field2):
+            {
+                JSValue val;
+#ifdef CONFIG_INLINE_CACHE
+                JSProperty *pr;
+#endif
                 JSAtom atom;
                 atom = get_u32(pc);
                 pc += 4;
 
+#ifdef CONFIG_INLINE_CACHE
+                pr = js_ic_get_field(ctx, b, pc - 4, sp[-1], atom);
+                if (pr) {
+                    *sp++ = JS_DupValue(ctx, pr->u.value);
+                    BREAK;
+                }
+#endif
+                val = JS_GetProperty(ctx, sp[-1], atom);
+                if (unlikely(JS_IsException(val)))
+                    goto exception;
+                *sp++ = val;
+            }
+            BREAK;
+
+#if SHORT_OPCODES
+        CASE(OP_get_loc_get_field):
+            {
+                JSValue val;
+#ifdef CONFIG_INLINE_CACHE
+                JSProperty *pr;
+#endif
+                JSAtom atom;
+                int idx;
+                atom = get_u32(pc);
+                idx = pc[4];
+                pc += 5;
+
+#ifdef CONFIG_INLINE_CACHE
+                pr = js_ic_get_field(ctx, b, pc - 5, var_buf[idx], atom);
+                if (pr) {
+                    *sp++ = JS_DupValue(ctx, pr->u.value);
+                    BREAK;
+                }
+#endif
+                /* the local is kept on the stack during the access
+                   because a getter may modify it */
+                *sp++ = JS_DupValue(ctx, var_buf[idx]);
                 val = JS_GetProperty(ctx, sp[-1], atom);
                 if (unlikely(JS_IsException(val)))
                     goto exception;
@@ -17546,27 +18402,53 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
             }
             BREAK;
 
-        CASE(OP_get_field2):
+        CASE(OP_get_loc_get_field2):
             {
                 JSValue val;
+#ifdef CONFIG_INLINE_CACHE
+                JSProperty *pr;
+#endif
                 JSAtom atom;
+                int idx;
                 atom = get_u32(pc);
-                pc += 4;
+                idx = pc[4];
+                pc += 5;
 
+                *sp++ = JS_DupValue(ctx, var_buf[idx]);
+#ifdef CONFIG_INLINE_CACHE
+                pr = js_ic_get_field(ctx, b, pc - 5, sp[-1], atom);
+                if (pr) {
+                    *sp++ = JS_DupValue(ctx, pr->u.value);
+                    BREAK;
+                }
+#endif
                 val = JS_GetProperty(ctx, sp[-1], atom);
                 if (unlikely(JS_IsException(val)))
                     goto exception;
                 *sp++ = val;
             }
             BREAK;
+#endif
 
         CASE(OP_put_field):
             {
                 int ret;
                 JSAtom atom;
+#ifdef CONFIG_INLINE_CACHE
+                JSProperty *pr;
+#endif
                 atom = get_u32(pc);
                 pc += 4;
 
+#ifdef CONFIG_INLINE_CACHE
+                pr = js_ic_put_field(ctx, b, pc - 4, sp[-2], atom);
+                if (pr) {
+                    set_value(ctx, &pr->u.value, sp[-1]);
+                    JS_FreeValue(ctx, sp[-2]);
+                    sp -= 2;
+                    BREAK;
+                }
+#endif
                 ret = JS_SetPropertyInternal(ctx, sp[-2], atom, sp[-1],
                                              JS_PROP_THROW_STRICT);
                 JS_FreeValue(ctx, sp[-2]);
@@ -17756,7 +18638,21 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
         CASE(OP_get_array_el):
             {
                 JSValue val;
+#ifdef CONFIG_INLINE_CACHE
+                JSProperty *pr;
+#endif
 
+#ifdef CONFIG_INLINE_CACHE
+                if (JS_VALUE_GET_TAG(sp[-1]) == JS_TAG_STRING &&
+                    (pr = js_ic_get_array_el(ctx, b, pc, sp[-2], sp[-1]))) {
+                    val = JS_DupValue(ctx, pr->u.value);
+                    JS_FreeValue(ctx, sp[-1]);
+                    JS_FreeValue(ctx, sp[-2]);
+                    sp[-2] = val;
+                    sp--;
+                    BREAK;
+                }
+#endif
                 val = JS_GetPropertyValue(ctx, sp[-2], sp[-1]);
                 JS_FreeValue(ctx, sp[-2]);
                 sp[-2] = val;
@@ -17769,7 +18665,18 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
         CASE(OP_get_array_el2):
             {
                 JSValue val;
+#ifdef CONFIG_INLINE_CACHE
+                JSProperty *pr;
+#endif
 
+#ifdef CONFIG_INLINE_CACHE
+                if (JS_VALUE_GET_TAG(sp[-1]) == JS_TAG_STRING &&
+                    (pr = js_ic_get_array_el(ctx, b, pc, sp[-2], sp[-1]))) {
+                    JS_FreeValue(ctx, sp[-1]);
+                    sp[-1] = JS_DupValue(ctx, pr->u.value);
+                    BREAK;
+                }
+#endif
                 val = JS_GetPropertyValue(ctx, sp[-2], sp[-1]);
                 sp[-1] = val;
                 if (unlikely(JS_IsException(val)))
@@ -17777,6 +18684,35 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
             }
             BREAK;
 
+#if SHORT_OPCODES
+        CASE(OP_get_loc_get_array_el):
+            {
+                JSValue val;
+#ifdef CONFIG_INLINE_CACHE
+                JSProperty *pr;
+#endif
+                int idx;
+                idx = *pc;
+                pc += 1;
+
+#ifdef CONFIG_INLINE_CACHE
+                if (JS_VALUE_GET_TAG(var_buf[idx]) == JS_TAG_STRING &&
+                    (pr = js_ic_get_array_el(ctx, b, pc - 1, sp[-1], var_buf[idx]))) {
+                    val = JS_DupValue(ctx, pr->u.value);
+                    JS_FreeValue(ctx, sp[-1]);
+                    sp[-1] = val;
+                    BREAK;
+                }
+#endif
+                val = JS_GetPropertyValue(ctx, sp[-1], JS_DupValue(ctx, var_buf[idx]));
+                JS_FreeValue(ctx, sp[-1]);
+                sp[-1] = val;
+                if (unlikely(JS_IsException(val)))
+                    goto exception;
+            }
+            BREAK;
+#endif
+
         CASE(OP_get_ref_value):
             {
                 JSValue val;
@@ -18198,6 +19134,32 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
                 }
             }
             BREAK;
+#if SHORT_OPCODES
+        CASE(OP_inc_loc_goto8):
+            {
+                JSValue op1;
+                int val;
+                int idx;
+                idx = pc[0];
+                pc += 2;
+
+                op1 = var_buf[idx];
+                if (JS_VALUE_GET_TAG(op1) == JS_TAG_INT &&
+                    likely(JS_VALUE_GET_INT(op1) != INT32_MAX)) {
+                    val = JS_VALUE_GET_INT(op1);
+                    var_buf[idx] = JS_NewInt32(ctx, val + 1);
+                } else {
+                    op1 = JS_DupValue(ctx, op1);
+                    if (js_unary_arith_slow(ctx, &op1 + 1, OP_inc))
+                        goto exception;
+                    set_value(ctx, &var_buf[idx], op1);
+                }
+                pc += (int8_t)pc[-1] - 1;
+                if (unlikely(js_poll_interrupts(ctx)))
+                    goto exception;
+            }
+            BREAK;
+#endif
         CASE(OP_dec_loc):
             {
                 JSValue op1;
@@ -18404,6 +19366,37 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
             OP_CMP(OP_strict_eq, ==, js_strict_eq_slow(ctx, sp, 0));
             OP_CMP(OP_strict_neq, !=, js_strict_eq_slow(ctx, sp, 1));
 
+#if SHORT_OPCODES
+#define OP_CMP_IF_FALSE8(opcode, binary_op)                             \
+            CASE(opcode):                                               \
+                {                                                       \
+                JSValue op1, op2;                                       \
+                int res;                                                \
+                op1 = sp[-2];                                           \
+                op2 = sp[-1];                                           \
+                pc += 1;                                                \
+                if (likely(JS_VALUE_IS_BOTH_INT(op1, op2))) {           \
+                    res = JS_VALUE_GET_INT(op1) binary_op JS_VALUE_GET_INT(op2); \
+                } else {                                                \
+                    if (js_relational_slow(ctx, sp, OP_lt + (opcode - OP_lt_if_false8))) \
+                        goto exception;                                 \
+                    res = JS_VALUE_GET_BOOL(sp[-2]);                    \
+                }                                                       \
+                sp -= 2;                                                \
+                if (!res) {                                             \
+                    pc += (int8_t)pc[-1] - 1;                           \
+                }                                                       \
+                if (unlikely(js_poll_interrupts(ctx)))                  \
+                    goto exception;                                     \
+                }                                                       \
+            BREAK
+
+            OP_CMP_IF_FALSE8(OP_lt_if_false8, <);
+            OP_CMP_IF_FALSE8(OP_lte_if_false8, <=);
+            OP_CMP_IF_FALSE8(OP_gt_if_false8, >);
+            OP_CMP_IF_FALSE8(OP_gte_if_false8, >=);
+#endif
+
 #ifdef CONFIG_BIGNUM
         CASE(OP_mul_pow10):
             if (rt->bigfloat_ops.mul_pow10(ctx, sp))
@@ -18706,6 +19699,9 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
             JS_FreeValue(ctx, *pval);
         }
     }
+#ifdef CONFIG_PROFILE
+    js_profile_leave(rt, prof_node);
+#endif
     rt->current_stack_frame = sf->prev_frame;
     return ret_val;
 }
@@ -20139,6 +21135,45 @@ static const JSOpCode opcode_info[OP_COUNT + (OP_TEMP_END - OP_TEMP_START)] = {
 #define short_opcode_info(op) opcode_info[op]
 #endif
 
+#ifdef CONFIG_INLINE_CACHE
+/* the caches are optional: nothing is cached if the allocation fails */
+static void js_ic_init(JSRuntime *rt, JSFunctionBytecode *b)
+{
+    JSInlineCache *tab;
+    int pos, op, count, bits;
+    uint32_t h, mask;
+
+    b->ic_initialized = TRUE;
+    count = 0;
+    for(pos = 0; pos < b->byte_code_len; pos += short_opcode_info(op).size) {
+        op = b->byte_code_buf[pos];
+        if (js_ic_is_cached_opcode(op))
+            count++;
+    }
+    if (count == 0)
+        return;
+    /* keep the load factor below 1/2 */
+    bits = 1;
+    while ((1 << bits) < 2 * count)
+        bits++;
+    tab = js_mallocz_rt(rt, sizeof(tab[0]) << bits);
+    if (!tab)
+        return;
+    mask = (1 << bits) - 1;
+    for(pos = 0; pos < b->byte_code_len; pos += short_opcode_info(op).size) {
+        op = b->byte_code_buf[pos];
+        if (js_ic_is_cached_opcode(op)) {
+            h = js_ic_hash(pos + 1, mask);
+            while (tab[h].pos != 0)
+                h = (h + 1) & mask;
+            tab[h].pos = pos + 1;
+        }
+    }
+    b->ic_tab = tab;
+    b->ic_bits = bits;
+}
+#endif
+
 static __exception int next_token(JSParseState *s);
 
 static void free_token(JSParseState *s, JSToken *token)
@@ -21633,11 +22668,40 @@ static int emit_goto(JSParseState *s, int opcode, int label)
     return -1;
 }
 
+/* primitive constants which can share a constant pool entry */
+static BOOL cpool_is_shareable(JSValueConst val)
+{
+    switch(JS_VALUE_GET_TAG(val)) {
+    case JS_TAG_FLOAT64:
+    case JS_TAG_STRING:
+    case JS_TAG_BIG_INT:
+#ifdef CONFIG_BIGNUM
+    case JS_TAG_BIG_FLOAT:
+    case JS_TAG_BIG_DECIMAL:
+#endif
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
 /* return the constant pool index. 'val' is not duplicated. */
 static int cpool_add(JSParseState *s, JSValue val)
 {
     JSFunctionDef *fd = s->cur_func;
-    
+    int i;
+
+    /* in strip mode, the size of the bytecode matters more than the
+       compilation time, so equal constants are stored once */
+    if ((fd->js_mode & JS_MODE_STRIP) && cpool_is_shareable(val)) {
+        for(i = 0; i < fd->cpool_count; i++) {
+            if (JS_VALUE_GET_TAG(fd->cpool[i]) == JS_VALUE_GET_TAG(val) &&
+                js_same_value(s->ctx, fd->cpool[i], val)) {
+                JS_FreeValue(s->ctx, val);
+                return i;
+            }
+        }
+    }
     if (js_resize_array(s->ctx, (void *)&fd->cpool, sizeof(fd->cpool[0]),
                         &fd->cpool_size, fd->cpool_count + 1))
         return -1;
@@ -28918,6 +29982,9 @@ static void dump_byte_code(JSContext *ctx, int pass,
         if (op < OP_COUNT) {
             switch (oi->fmt) {
 #if SHORT_OPCODES
+            case OP_FMT_loc8_label8:
+                pos++;
+                /* fall thru */
             case OP_FMT_label8:
                 pos++;
                 addr = (int8_t)tab[pos];
@@ -29116,6 +30183,17 @@ static void dump_byte_code(JSContext *ctx, int pass,
         case OP_FMT_none_loc:
             idx = (op - OP_get_loc0) % 4;
             goto has_loc;
+#if SHORT_OPCODES
+        case OP_FMT_loc8_label8:
+            idx = get_u8(tab + pos);
+            printf(" %d: ", idx);
+            if (idx < var_count) {
+                print_atom(ctx, vars[idx].var_name);
+            }
+            if (pass == 3)
+                printf(",%u", get_i8(tab + pos + 1) + pos + 1);
+            break;
+#endif
         case OP_FMT_loc8:
             idx = get_u8(tab + pos);
             goto has_loc;
@@ -31936,10 +33014,32 @@ static __exception int resolve_labels(JSContext *ctx, JSFunctionDef *s)
                 if (code_match(&cc, pos_next, M2(OP_post_dec, OP_post_inc), OP_put_loc, idx, OP_drop, -1) ||
                     code_match(&cc, pos_next, M2(OP_dec, OP_inc), OP_dup, OP_put_loc, idx, OP_drop, -1)) {
                     if (cc.line_num >= 0) line_num = cc.line_num;
+                    op1 = (cc.op == OP_inc || cc.op == OP_post_inc) ? OP_inc_loc : OP_dec_loc;
+                    pos_next = cc.pos;
+#if SHORT_OPCODES
+                    /* transformation: inc_loc(n) goto(l1) -> inc_loc_goto8(n, l1)
+                       for the backward jump at the end of a short loop */
+                    if (op1 == OP_inc_loc && code_match(&cc, pos_next, OP_goto, -1)) {
+                        ls = &label_slots[cc.label];
+                        val = ls->addr - (bc_out.size + 2);
+                        if (ls->addr != -1 && val == (int8_t)val) {
+                            add_pc2line_info(s, bc_out.size, line_num);
+                            jp = &s->jump_slots[s->jump_count++];
+                            jp->op = OP_inc_loc_goto8;
+                            jp->size = 1;
+                            jp->pos = bc_out.size + 2;
+                            jp->label = cc.label;
+                            dbuf_putc(&bc_out, OP_inc_loc_goto8);
+                            dbuf_putc(&bc_out, idx);
+                            dbuf_putc(&bc_out, val);
+                            pos_next = skip_dead_code(s, bc_buf, bc_len, cc.pos, &line_num);
+                            break;
+                        }
+                    }
+#endif
                     add_pc2line_info(s, bc_out.size, line_num);
-                    dbuf_putc(&bc_out, (cc.op == OP_inc || cc.op == OP_post_inc) ? OP_inc_loc : OP_dec_loc);
+                    dbuf_putc(&bc_out, op1);
                     dbuf_putc(&bc_out, idx);
-                    pos_next = cc.pos;
                     break;
                 }
                 /* transformation:
@@ -31989,6 +33089,32 @@ static __exception int resolve_labels(JSContext *ctx, JSFunctionDef *s)
                     pos_next = cc.pos;
                     break;
                 }
+#if SHORT_OPCODES
+                /* transformation:
+                   get_loc(n) get_field(x) -> get_loc_get_field(x, n)
+                   get_loc(n) get_field2(x) -> get_loc_get_field2(x, n)
+                   (get_loc(n) get_field(length) is left to get_length)
+                 */
+                if (code_match(&cc, pos_next, M2(OP_get_field, OP_get_field2), -1) &&
+                    !(cc.op == OP_get_field && cc.atom == JS_ATOM_length)) {
+                    if (cc.line_num >= 0) line_num = cc.line_num;
+                    add_pc2line_info(s, bc_out.size, line_num);
+                    dbuf_putc(&bc_out, OP_get_loc_get_field + (cc.op - OP_get_field));
+                    dbuf_put_u32(&bc_out, cc.atom);
+                    dbuf_putc(&bc_out, idx);
+                    pos_next = cc.pos;
+                    break;
+                }
+                /* transformation: get_loc(n) get_array_el -> get_loc_get_array_el(n) */
+                if (code_match(&cc, pos_next, OP_get_array_el, -1)) {
+                    if (cc.line_num >= 0) line_num = cc.line_num;
+                    add_pc2line_info(s, bc_out.size, line_num);
+                    dbuf_putc(&bc_out, OP_get_loc_get_array_el);
+                    dbuf_putc(&bc_out, idx);
+                    pos_next = cc.pos;
+                    break;
+                }
+#endif
                 add_pc2line_info(s, bc_out.size, line_num);
                 put_short_code(&bc_out, op, idx);
                 break;
@@ -32072,6 +33198,60 @@ static __exception int resolve_labels(JSContext *ctx, JSFunctionDef *s)
             goto no_change;
 
 #if SHORT_OPCODES
+        case OP_lt:
+        case OP_lte:
+        case OP_gt:
+        case OP_gte:
+            if (OPTIMIZE) {
+                /* transformation: lt if_false(l1) -> lt_if_false8(l1) if l1
+                   is close enough */
+                int label1, line1, pos1;
+                if (code_match(&cc, pos_next, OP_if_false, -1)) {
+                    label1 = cc.label;
+                    line1 = cc.line_num;
+                    pos1 = cc.pos;
+                    label = find_jump_target(s, label1, &op1, NULL);
+                    /* leave to OP_if_false the cases where it removes the
+                       jump or inverts the test */
+                    if (code_has_label(&cc, pos1, label) ||
+                        (code_match(&cc, pos1, OP_goto, -1) &&
+                         code_has_label(&cc, cc.pos, label)))
+                        goto cmp_no_fuse;
+                    ls = &label_slots[label];
+                    if (ls->addr == -1) {
+                        val = ls->pos2 - pos - 1;
+                        if (val >= 128)
+                            goto cmp_no_fuse;
+                    } else {
+                        val = ls->addr - bc_out.size - 1;
+                        if (val != (int8_t)val)
+                            goto cmp_no_fuse;
+                    }
+                    if (line1 >= 0) line_num = line1;
+                    add_pc2line_info(s, bc_out.size, line_num);
+                    jp = &s->jump_slots[s->jump_count++];
+                    jp->op = OP_lt_if_false8 + (op - OP_lt);
+                    jp->size = 1;
+                    jp->pos = bc_out.size + 1;
+                    jp->label = label;
+                    dbuf_putc(&bc_out, jp->op);
+                    if (ls->addr == -1) {
+                        dbuf_putc(&bc_out, 0);
+                        if (!add_reloc(ctx, ls, bc_out.size - 1, 1))
+                            goto fail;
+                    } else {
+                        dbuf_putc(&bc_out, val);
+                    }
+                    pos_next = pos1;
+                    break;
+                cmp_no_fuse:
+                    /* undo find_jump_target(): if_false is processed next */
+                    update_label(s, label, -1);
+                    update_label(s, label1, +1);
+                }
+            }
+            goto no_change;
+
         case OP_typeof:
             if (OPTIMIZE) {
                 /* simplify typeof tests */
@@ -32363,10 +33543,18 @@ static __exception int compute_stack_size(JSContext *ctx,
             break;
         case OP_if_true8:
         case OP_if_false8:
+        case OP_lt_if_false8:
+        case OP_lte_if_false8:
+        case OP_gt_if_false8:
+        case OP_gte_if_false8:
             diff = (int8_t)bc_buf[pos + 1];
             if (ss_check(ctx, s, pos + 1 + diff, op, stack_len))
                 goto fail;
             break;
+        case OP_inc_loc_goto8:
+            diff = (int8_t)bc_buf[pos + 2];
+            pos_next = pos + 2 + diff;
+            break;
 #endif
         case OP_if_true:
         case OP_if_false:
@@ -32691,6 +33879,13 @@ static void free_function_bytecode(JSRuntime *rt, JSFunctionBytecode *b)
     }
 #endif
     free_bytecode_atoms(rt, b->byte_code_buf, b->byte_code_len, TRUE);
+#ifdef CONFIG_INLINE_CACHE
+    if (b->ic_tab) {
+        for(i = 0; i < (1 << b->ic_bits); i++)
+            js_ic_clear(rt, &b->ic_tab[i]);
+        js_free_rt(rt, b->ic_tab);
+    }
+#endif
 
     if (b->vardefs) {
         for(i = 0; i < b->arg_count + b->var_count; i++) {
@@ -32710,7 +33905,8 @@ static void free_function_bytecode(JSRuntime *rt, JSFunctionBytecode *b)
     JS_FreeAtomRT(rt, b->func_name);
     if (b->has_debug) {
         JS_FreeAtomRT(rt, b->debug.filename);
-        js_free_rt(rt, b->debug.pc2line_buf);
+        if (!b->read_only_bytecode)
+            js_free_rt(rt, b->debug.pc2line_buf);
         js_free_rt(rt, b->debug.source);
     }
 
@@ -33747,6 +34943,137 @@ int JS_ResolveModule(JSContext *ctx, JSValueConst obj)
     return 0;
 }
 
+/* Module bundles */
+
+/* add 'm' and the JS modules it imports to 'tab' if they are not
+   already there. Return the new count or -1 if 'tab' is too small. */
+static int js_bundle_add_module(JSModuleDef *m, JSModuleDef **tab,
+                                int count, int size)
+{
+    int i;
+
+    if (m->init_func)
+        return count; /* C modules are defined by the host */
+    for(i = 0; i < count; i++) {
+        if (tab[i] == m)
+            return count;
+    }
+    if (count >= size)
+        return -1;
+    tab[count++] = m;
+    for(i = 0; i < m->req_module_entries_count; i++) {
+        count = js_bundle_add_module(m->req_module_entries[i].module,
+                                     tab, count, size);
+        if (count < 0)
+            return -1;
+    }
+    return count;
+}
+
+static BOOL js_function_has_dynamic_import(JSFunctionBytecode *b)
+{
+    int pos, op, i;
+
+    for(pos = 0; pos < b->byte_code_len; pos += short_opcode_info(op).size) {
+        op = b->byte_code_buf[pos];
+        if (op == OP_import)
+            return TRUE;
+    }
+    for(i = 0; i < b->cpool_count; i++) {
+        if (JS_VALUE_GET_TAG(b->cpool[i]) == JS_TAG_FUNCTION_BYTECODE &&
+            js_function_has_dynamic_import(JS_VALUE_GET_PTR(b->cpool[i])))
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/* return TRUE if a module of 'tab' may import 'name' from 'm'. Names
+   exported with 'export *' or imported as a namespace are all used. */
+static BOOL js_bundle_is_export_used(JSModuleDef **tab, int count,
+                                     JSModuleDef *m, JSAtom name)
+{
+    JSModuleDef *m1;
+    int i, j;
+
+    for(i = 0; i < count; i++) {
+        m1 = tab[i];
+        for(j = 0; j < m1->import_entries_count; j++) {
+            JSImportEntry *mi = &m1->import_entries[j];
+            if (m1->req_module_entries[mi->req_module_idx].module == m &&
+                (mi->import_name == name ||
+                 mi->import_name == JS_ATOM__star_))
+                return TRUE;
+        }
+        for(j = 0; j < m1->export_entries_count; j++) {
+            JSExportEntry *me = &m1->export_entries[j];
+            if (me->export_type == JS_EXPORT_TYPE_INDIRECT &&
+                m1->req_module_entries[me->u.req_module_idx].module == m &&
+                (me->local_name == name ||
+                 me->local_name == JS_ATOM__star_))
+                return TRUE;
+        }
+        for(j = 0; j < m1->star_export_entries_count; j++) {
+            JSStarExportEntry *se = &m1->star_export_entries[j];
+            if (m1->req_module_entries[se->req_module_idx].module == m)
+                return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/* Prepare the resolved module 'm' to be written with the modules it
+   imports as a single image. 'tab' receives the JS modules of the graph,
+   'm' last. In each module, the imported module names are replaced by
+   the names they resolve to, so that they are found among the loaded
+   modules without normalization. The exports that no module of the
+   graph imports are removed, except if a module uses import(). Return
+   the number of modules or -1 if 'size' is too small. */
+int JS_PrepareModuleBundle(JSContext *ctx, JSModuleDef *m,
+                           JSModuleDef **tab, int size)
+{
+    JSModuleDef *m1;
+    BOOL has_dynamic_import;
+    int count, i, j, k;
+
+    count = js_bundle_add_module(m, tab, 0, size);
+    if (count < 0)
+        return -1;
+    /* the main module comes last */
+    memmove(tab, tab + 1, (count - 1) * sizeof(tab[0]));
+    tab[count - 1] = m;
+
+    has_dynamic_import = FALSE;
+    for(i = 0; i < count; i++) {
+        m1 = tab[i];
+        for(j = 0; j < m1->req_module_entries_count; j++) {
+            JSReqModuleEntry *rme = &m1->req_module_entries[j];
+            JSAtom name = JS_DupAtom(ctx, rme->module->module_name);
+            JS_FreeAtom(ctx, rme->module_name);
+            rme->module_name = name;
+        }
+        if (js_function_has_dynamic_import(JS_VALUE_GET_PTR(m1->func_obj)))
+            has_dynamic_import = TRUE;
+    }
+    if (has_dynamic_import)
+        return count;
+
+    for(i = 0; i < count; i++) {
+        m1 = tab[i];
+        k = 0;
+        for(j = 0; j < m1->export_entries_count; j++) {
+            JSExportEntry *me = &m1->export_entries[j];
+            if (js_bundle_is_export_used(tab, count, m1, me->export_name)) {
+                m1->export_entries[k++] = *me;
+            } else {
+                JS_FreeAtom(ctx, me->local_name);
+                JS_FreeAtom(ctx, me->export_name);
+            }
+        }
+        m1->export_entries_count = k;
+    }
+    return count;
+}
+
 /*******************************************************************/
 /* object list */
 
@@ -34776,6 +36103,7 @@ typedef struct BCReaderState {
     BOOL allow_sab : 8;
     BOOL allow_bytecode : 8;
     BOOL is_rom_data : 8;
+    BOOL is_in_place : 8; /* rom data with the atoms relocated in 'buf' */
     BOOL allow_reference : 8;
     /* object references */
     JSObject **objects;
@@ -35031,7 +36359,7 @@ static int JS_ReadFunctionBytecode(BCReaderState *s, JSFunctionBytecode *b,
         case OP_FMT_atom_label_u8:
         case OP_FMT_atom_label_u16:
             idx = get_u32(bc_buf + pos + 1);
-            if (s->is_rom_data) {
+            if (s->is_rom_data && !s->is_in_place) {
                 /* just increment the reference count of the atom */
                 JS_DupAtom(s->ctx, (JSAtom)idx);
             } else {
@@ -35368,11 +36696,21 @@ static JSValue JS_ReadFunctionTag(BCReaderState *s)
         if (bc_get_leb128_int(s, &b->debug.pc2line_len))
             goto fail;
         if (b->debug.pc2line_len) {
-            b->debug.pc2line_buf = js_mallocz(ctx, b->debug.pc2line_len);
-            if (!b->debug.pc2line_buf)
-                goto fail;
-            if (bc_get_buf(s, b->debug.pc2line_buf, b->debug.pc2line_len))
-                goto fail;
+            if (b->read_only_bytecode) {
+                /* directly use the input buffer */
+                if (unlikely(s->buf_end - s->ptr < b->debug.pc2line_len)) {
+                    bc_read_error_end(s);
+                    goto fail;
+                }
+                b->debug.pc2line_buf = (uint8_t *)s->ptr;
+                s->ptr += b->debug.pc2line_len;
+            } else {
+                b->debug.pc2line_buf = js_mallocz(ctx, b->debug.pc2line_len);
+                if (!b->debug.pc2line_buf)
+                    goto fail;
+                if (bc_get_buf(s, b->debug.pc2line_buf, b->debug.pc2line_len))
+                    goto fail;
+            }
         }
 #ifdef DUMP_READ_OBJECT
         bc_read_trace(s, "filename: "); print_atom(s->ctx, b->debug.filename); printf("\n");
@@ -35876,7 +37214,8 @@ static int JS_ReadObjectAtoms(BCReaderState *s)
         if (atom == JS_ATOM_NULL)
             return s->error_state = -1;
         s->idx_to_atom[i] = atom;
-        if (s->is_rom_data && (atom != (i + s->first_atom)))
+        if (s->is_rom_data && !s->is_in_place &&
+            (atom != (i + s->first_atom)))
             s->is_rom_data = FALSE; /* atoms must be relocated */
     }
     bc_read_trace(s, "}\n");
@@ -35910,7 +37249,9 @@ JSValue JS_ReadObject(JSContext *ctx, const uint8_t *buf, size_t buf_len,
     s->buf_end = buf + buf_len;
     s->ptr = buf;
     s->allow_bytecode = ((flags & JS_READ_OBJ_BYTECODE) != 0);
-    s->is_rom_data = ((flags & JS_READ_OBJ_ROM_DATA) != 0);
+    s->is_rom_data = ((flags & (JS_READ_OBJ_ROM_DATA |
+                                 JS_READ_OBJ_IN_PLACE)) != 0);
+    s->is_in_place = ((flags & JS_READ_OBJ_IN_PLACE) != 0);
     s->allow_sab = ((flags & JS_READ_OBJ_SAB) != 0);
     s->allow_reference = ((flags & JS_READ_OBJ_REFERENCE) != 0);
     if (s->allow_bytecode)
@@ -36254,9 +37595,13 @@ static JSValue JS_ToObject(JSContext *ctx, JSValueConst val)
         obj = JS_NewObjectClass(ctx, JS_CLASS_BIG_INT);
         goto set_value;
     case JS_TAG_BIG_FLOAT:
+        if (js_init_lazy_intrinsics(ctx, JS_INTRINSIC_LAZY_BIGNUM))
+            return JS_EXCEPTION;
         obj = JS_NewObjectClass(ctx, JS_CLASS_BIG_FLOAT);
         goto set_value;
     case JS_TAG_BIG_DECIMAL:
+        if (js_init_lazy_intrinsics(ctx, JS_INTRINSIC_LAZY_BIGNUM))
+            return JS_EXCEPTION;
         obj = JS_NewObjectClass(ctx, JS_CLASS_BIG_DECIMAL);
         goto set_value;
 #endif
@@ -50324,11 +51669,8 @@ static const JSCFunctionListEntry js_float_env_proto_funcs[] = {
     JS_CFUNC_DEF("clearStatus", 0, js_float_env_clearStatus ),
 };
 
-void JS_AddIntrinsicBigFloat(JSContext *ctx)
+static void js_bigfloat_init_ops(JSRuntime *rt)
 {
-    JSRuntime *rt = ctx->rt;
-    JSValueConst obj1;
-    
     rt->bigfloat_ops.to_string = js_bigfloat_to_string;
     rt->bigfloat_ops.from_string = js_string_to_bigfloat;
     rt->bigfloat_ops.unary_arith = js_unary_arith_bigfloat;
@@ -50336,7 +51678,13 @@ void JS_AddIntrinsicBigFloat(JSContext *ctx)
     rt->bigfloat_ops.compare = js_compare_bigfloat;
     rt->bigfloat_ops.mul_pow10_to_float64 = js_mul_pow10_to_float64;
     rt->bigfloat_ops.mul_pow10 = js_mul_pow10;
-    
+}
+
+void JS_AddIntrinsicBigFloat(JSContext *ctx)
+{
+    JSValueConst obj1;
+
+    js_bigfloat_init_ops(ctx->rt);
     ctx->class_proto[JS_CLASS_BIG_FLOAT] = JS_NewObject(ctx);
     JS_SetPropertyFunctionList(ctx, ctx->class_proto[JS_CLASS_BIG_FLOAT],
                                js_bigfloat_proto_funcs,
@@ -50814,17 +52162,20 @@ static const JSCFunctionListEntry js_bigdecimal_funcs[] = {
     JS_CFUNC_MAGIC_DEF("sqrt", 1, js_bigdecimal_fop, MATH_OP_SQRT ),
 };
 
-void JS_AddIntrinsicBigDecimal(JSContext *ctx)
+static void js_bigdecimal_init_ops(JSRuntime *rt)
 {
-    JSRuntime *rt = ctx->rt;
-    JSValueConst obj1;
-
     rt->bigdecimal_ops.to_string = js_bigdecimal_to_string;
     rt->bigdecimal_ops.from_string = js_string_to_bigdecimal;
     rt->bigdecimal_ops.unary_arith = js_unary_arith_bigdecimal;
     rt->bigdecimal_ops.binary_arith = js_binary_arith_bigdecimal;
     rt->bigdecimal_ops.compare = js_compare_bigdecimal;
+}
+
+void JS_AddIntrinsicBigDecimal(JSContext *ctx)
+{
+    JSValueConst obj1;
 
+    js_bigdecimal_init_ops(ctx->rt);
     ctx->class_proto[JS_CLASS_BIG_DECIMAL] = JS_NewObject(ctx);
     JS_SetPropertyFunctionList(ctx, ctx->class_proto[JS_CLASS_BIG_DECIMAL],
                                js_bigdecimal_proto_funcs,
@@ -51102,6 +52453,166 @@ void JS_AddIntrinsicBaseObjects(JSContext *ctx)
                            JS_PROP_CONFIGURABLE | JS_PROP_WRITABLE);
 }
 
+/* Lazy intrinsics */
+
+#ifdef CONFIG_BIGNUM
+static void js_add_intrinsic_bignum_ext(JSContext *ctx)
+{
+    JS_AddIntrinsicBigFloat(ctx);
+    JS_AddIntrinsicBigDecimal(ctx);
+    /* must be called after all overloadable base types are initialized */
+    JS_AddIntrinsicOperators(ctx);
+}
+#endif
+
+/* indexed by the bit number of JS_INTRINSIC_LAZY_x */
+static void (* const js_lazy_intrinsic_init[])(JSContext *ctx) = {
+    JS_AddIntrinsicDate,
+    JS_AddIntrinsicProxy,
+    JS_AddIntrinsicMapSet,
+#ifdef CONFIG_BIGNUM
+    js_add_intrinsic_bignum_ext,
+#endif
+};
+
+typedef struct JSLazyIntrinsicProp {
+    uint16_t atom; /* name of the global property */
+    uint8_t mask; /* JS_INTRINSIC_LAZY_x */
+} JSLazyIntrinsicProp;
+
+static const JSLazyIntrinsicProp js_lazy_intrinsic_props[] = {
+    { JS_ATOM_Date, JS_INTRINSIC_LAZY_DATE },
+    { JS_ATOM_Proxy, JS_INTRINSIC_LAZY_PROXY },
+    { JS_ATOM_Map, JS_INTRINSIC_LAZY_MAP_SET },
+    { JS_ATOM_Set, JS_INTRINSIC_LAZY_MAP_SET },
+    { JS_ATOM_WeakMap, JS_INTRINSIC_LAZY_MAP_SET },
+    { JS_ATOM_WeakSet, JS_INTRINSIC_LAZY_MAP_SET },
+#ifdef CONFIG_BIGNUM
+    { JS_ATOM_BigFloat, JS_INTRINSIC_LAZY_BIGNUM },
+    { JS_ATOM_BigFloatEnv, JS_INTRINSIC_LAZY_BIGNUM },
+    { JS_ATOM_BigDecimal, JS_INTRINSIC_LAZY_BIGNUM },
+    { JS_ATOM_Operators, JS_INTRINSIC_LAZY_BIGNUM },
+#endif
+};
+
+/* create the pending intrinsics of 'mask'. Their global properties are
+   defined in ctx->lazy_global_obj from where the autoinit properties of
+   the global object take their value. */
+static int js_init_lazy_intrinsics(JSContext *ctx, int mask)
+{
+    JSValue global_obj;
+    int i;
+
+    mask &= ctx->lazy_intrinsics;
+    if (likely(!mask))
+        return 0;
+    if (JS_IsUndefined(ctx->lazy_global_obj)) {
+        ctx->lazy_global_obj = JS_NewObjectProto(ctx, JS_NULL);
+        if (JS_IsException(ctx->lazy_global_obj)) {
+            ctx->lazy_global_obj = JS_UNDEFINED;
+            return -1;
+        }
+    }
+    ctx->lazy_intrinsics &= ~mask;
+
+    /* the JS_AddIntrinsicX() functions define their properties in
+       ctx->global_obj: swap the objects so that both stay visible to
+       the GC */
+    global_obj = ctx->global_obj;
+    ctx->global_obj = ctx->lazy_global_obj;
+    ctx->lazy_global_obj = global_obj;
+    for(i = 0; i < countof(js_lazy_intrinsic_init); i++) {
+        if (mask & (1 << i)) {
+#ifdef DUMP_LAZY_INTRINSICS
+            JSMallocState ms = ctx->rt->malloc_state;
+#endif
+            js_lazy_intrinsic_init[i](ctx);
+#ifdef DUMP_LAZY_INTRINSICS
+            printf("lazy intrinsic 0x%x: %d allocations, %d bytes\n", 1 << i,
+                   (int)(ctx->rt->malloc_state.malloc_count - ms.malloc_count),
+                   (int)(ctx->rt->malloc_state.malloc_size - ms.malloc_size));
+#endif
+        }
+    }
+    ctx->lazy_global_obj = ctx->global_obj;
+    ctx->global_obj = global_obj;
+    return 0;
+}
+
+static JSValue js_lazy_intrinsic_get(JSContext *ctx, JSAtom atom)
+{
+    int i;
+
+    for(i = 0; i < countof(js_lazy_intrinsic_props); i++) {
+        if (js_lazy_intrinsic_props[i].atom == atom) {
+            if (js_init_lazy_intrinsics(ctx, js_lazy_intrinsic_props[i].mask))
+                return JS_EXCEPTION;
+            break;
+        }
+    }
+    return JS_GetProperty(ctx, ctx->lazy_global_obj, atom);
+}
+
+/* 'opaque' is the JSLazyPropertyFunc creating the value */
+static JSValue js_lazy_property_autoinit(JSContext *ctx, JSObject *p,
+                                         JSAtom atom, void *opaque)
+{
+    return ((JSLazyPropertyFunc *)opaque)(ctx, atom);
+}
+
+int JS_DefineLazyProperty(JSContext *ctx, JSValueConst this_obj,
+                          JSAtom prop, JSLazyPropertyFunc *func, int flags)
+{
+    if (JS_VALUE_GET_TAG(this_obj) != JS_TAG_OBJECT) {
+        JS_ThrowTypeErrorNotAnObject(ctx);
+        return -1;
+    }
+    return JS_DefineAutoInitProperty(ctx, this_obj, prop, JS_AUTOINIT_ID_LAZY,
+                                     (void *)func, flags);
+}
+
+int JS_DefineLazyPropertyStr(JSContext *ctx, JSValueConst this_obj,
+                             const char *prop, JSLazyPropertyFunc *func,
+                             int flags)
+{
+    JSAtom atom;
+    int ret;
+    atom = JS_NewAtom(ctx, prop);
+    if (atom == JS_ATOM_NULL)
+        return -1;
+    ret = JS_DefineLazyProperty(ctx, this_obj, atom, func, flags);
+    JS_FreeAtom(ctx, atom);
+    return ret;
+}
+
+void JS_AddIntrinsicLazy(JSContext *ctx, int mask)
+{
+    const JSLazyIntrinsicProp *e;
+    int i;
+
+#ifdef CONFIG_BIGNUM
+    if (mask & JS_INTRINSIC_LAZY_BIGNUM) {
+        /* BigFloat and BigDecimal values (e.g. literals) can be
+           used before their prototypes are created */
+        js_bigfloat_init_ops(ctx->rt);
+        js_bigdecimal_init_ops(ctx->rt);
+    }
+#else
+    mask &= ~JS_INTRINSIC_LAZY_BIGNUM;
+#endif
+    mask &= ~ctx->lazy_intrinsics;
+    ctx->lazy_intrinsics |= mask;
+    for(i = 0; i < countof(js_lazy_intrinsic_props); i++) {
+        e = &js_lazy_intrinsic_props[i];
+        if (mask & e->mask) {
+            JS_DefineAutoInitProperty(ctx, ctx->global_obj, e->atom,
+                                      JS_AUTOINIT_ID_LAZY,
+                                      (void *)js_lazy_intrinsic_get,
+                                      JS_PROP_WRITABLE | JS_PROP_CONFIGURABLE);
+        }
+    }
+}
+
 /* Typed Arrays */
 
 static uint8_t const typed_array_size_log2[JS_TYPED_ARRAY_COUNT] = {
@@ -51578,6 +53089,72 @@ JSValue JS_GetTypedArrayBuffer(JSContext *ctx, JSValueConst obj,
     return JS_DupValue(ctx, JS_MKPTR(JS_TAG_OBJECT, ta->buffer));
 }
                                
+/* Return the ArrayBuffer of an ArrayBuffer, a typed array or a DataView
+   with the offset and the length of the bytes seen by 'obj' */
+JSValue JS_GetArrayBufferViewBuffer(JSContext *ctx, JSValueConst obj,
+                                    size_t *pbyte_offset,
+                                    size_t *pbyte_length)
+{
+    JSObject *p;
+    JSTypedArray *ta;
+    JSArrayBuffer *abuf;
+
+    if (JS_VALUE_GET_TAG(obj) != JS_TAG_OBJECT)
+        goto fail;
+    p = JS_VALUE_GET_OBJ(obj);
+    if (p->class_id == JS_CLASS_ARRAY_BUFFER ||
+        p->class_id == JS_CLASS_SHARED_ARRAY_BUFFER) {
+        abuf = p->u.array_buffer;
+        if (abuf->detached)
+            return JS_ThrowTypeErrorDetachedArrayBuffer(ctx);
+        *pbyte_offset = 0;
+        *pbyte_length = abuf->byte_length;
+        return JS_DupValue(ctx, obj);
+    }
+    if (!((p->class_id >= JS_CLASS_UINT8C_ARRAY &&
+           p->class_id <= JS_CLASS_FLOAT64_ARRAY) ||
+          p->class_id == JS_CLASS_DATAVIEW)) {
+    fail:
+        return JS_ThrowTypeError(ctx, "not an ArrayBuffer, a TypedArray or a DataView");
+    }
+    ta = p->u.typed_array;
+    if (ta->buffer->u.array_buffer->detached)
+        return JS_ThrowTypeErrorDetachedArrayBuffer(ctx);
+    *pbyte_offset = ta->offset;
+    *pbyte_length = ta->length;
+    return JS_DupValue(ctx, JS_MKPTR(JS_TAG_OBJECT, ta->buffer));
+}
+
+/* Return the bytes seen by an ArrayBuffer, a typed array or a DataView */
+uint8_t *JS_GetArrayBufferView(JSContext *ctx, size_t *psize, JSValueConst obj)
+{
+    JSValue buffer;
+    JSArrayBuffer *abuf;
+    size_t offset;
+
+    buffer = JS_GetArrayBufferViewBuffer(ctx, obj, &offset, psize);
+    if (JS_IsException(buffer)) {
+        *psize = 0;
+        return NULL;
+    }
+    abuf = JS_VALUE_GET_OBJ(buffer)->u.array_buffer;
+    JS_FreeValue(ctx, buffer);
+    return abuf->data + offset;
+}
+
+/* Return a new Uint8Array seeing 'length' bytes of 'buffer' from 'offset' */
+JSValue JS_NewUint8Array(JSContext *ctx, JSValueConst buffer,
+                         size_t offset, size_t length)
+{
+    JSValueConst args[3];
+
+    args[0] = buffer;
+    args[1] = JS_NewInt64(ctx, offset);
+    args[2] = JS_NewInt64(ctx, length);
+    return js_typed_array_constructor(ctx, JS_UNDEFINED, 3, args,
+                                      JS_CLASS_UINT8_ARRAY);
+}
+
 static JSValue js_typed_array_get_toStringTag(JSContext *ctx,
                                               JSValueConst this_val)
 {
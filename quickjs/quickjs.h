@@ -66,10 +66,12 @@ typedef uint32_t JSAtom;
 #define JS_NAN_BOXING
 #endif
 
+/* bumped when the opcode set changes: 1 and 2 predate the
+   superinstructions */
 #ifdef CONFIG_BIGNUM
-#define BC_BASE_VERSION 2
+#define BC_BASE_VERSION 4
 #else
-#define BC_BASE_VERSION 1
+#define BC_BASE_VERSION 3
 #endif
 #define BC_BE_VERSION 0x40
 #ifdef WORDS_BIGENDIAN
@@ -347,6 +349,7 @@ JSRuntime *JS_NewRuntime(void);
 void JS_SetRuntimeInfo(JSRuntime *rt, const char *info);
 void JS_SetMemoryLimit(JSRuntime *rt, size_t limit);
 void JS_SetGCThreshold(JSRuntime *rt, size_t gc_threshold);
+size_t JS_GetGCThreshold(JSRuntime *rt);
 /* use 0 to disable maximum stack size check */
 void JS_SetMaxStackSize(JSRuntime *rt, size_t stack_size);
 /* should be called when changing thread to update the stack top value
@@ -359,6 +362,17 @@ void JS_SetRuntimeOpaque(JSRuntime *rt, void *opaque);
 typedef void JS_MarkFunc(JSRuntime *rt, JSGCObjectHeader *gp);
 void JS_MarkValue(JSRuntime *rt, JSValueConst val, JS_MarkFunc *mark_func);
 void JS_RunGC(JSRuntime *rt);
+/* statistics of the cycle collections run by JS_RunGC() */
+typedef struct JSGCStats {
+    int64_t count;
+    int64_t scanned; /* GC objects scanned */
+    int64_t freed; /* objects and functions freed because they were in cycles */
+    uint64_t time; /* measured with the clock of JS_SetGCClock(), 0 without it */
+} JSGCStats;
+/* 'clock' returns the current time (e.g. the cycles consumed by the VM) */
+typedef uint64_t JSGCClockFunc(void);
+void JS_SetGCClock(JSRuntime *rt, JSGCClockFunc *clock);
+void JS_GetGCStats(JSRuntime *rt, JSGCStats *s);
 JS_BOOL JS_IsLiveObject(JSRuntime *rt, JSValueConst obj);
 
 JSContext *JS_NewContext(JSRuntime *rt);
@@ -392,6 +406,26 @@ void JS_AddIntrinsicOperators(JSContext *ctx);
 /* enable "use math" */
 void JS_EnableBignumExt(JSContext *ctx, JS_BOOL enable);
 
+/* intrinsics which can be installed lazily: the global properties are
+   defined at once but the constructors and prototypes are only created
+   when one of them is first accessed */
+#define JS_INTRINSIC_LAZY_DATE    (1 << 0)
+#define JS_INTRINSIC_LAZY_PROXY   (1 << 1)
+#define JS_INTRINSIC_LAZY_MAP_SET (1 << 2) /* Map, Set, WeakMap, WeakSet */
+#define JS_INTRINSIC_LAZY_BIGNUM  (1 << 3) /* BigFloat, BigDecimal, Operators */
+#define JS_INTRINSIC_LAZY_ALL     0x0f
+/* replaces the corresponding JS_AddIntrinsicX() calls */
+void JS_AddIntrinsicLazy(JSContext *ctx, int mask);
+
+/* the value of a lazy property is returned by 'func' on the first access
+   of the property, then it is an ordinary data property */
+typedef JSValue JSLazyPropertyFunc(JSContext *ctx, JSAtom prop);
+int JS_DefineLazyProperty(JSContext *ctx, JSValueConst this_obj,
+                          JSAtom prop, JSLazyPropertyFunc *func, int flags);
+int JS_DefineLazyPropertyStr(JSContext *ctx, JSValueConst this_obj,
+                             const char *prop, JSLazyPropertyFunc *func,
+                             int flags);
+
 JSValue js_string_codePointRange(JSContext *ctx, JSValueConst this_val,
                                  int argc, JSValueConst *argv);
 
@@ -812,6 +846,7 @@ int JS_DefinePropertyGetSet(JSContext *ctx, JSValueConst this_obj,
                             JSAtom prop, JSValue getter, JSValue setter,
                             int flags);
 void JS_SetOpaque(JSValue obj, void *opaque);
+JSClassID JS_GetClassID(JSValueConst obj);
 void *JS_GetOpaque(JSValueConst obj, JSClassID class_id);
 void *JS_GetOpaque2(JSContext *ctx, JSValueConst obj, JSClassID class_id);
 
@@ -831,6 +866,12 @@ JSValue JS_NewArrayBuffer(JSContext *ctx, uint8_t *buf, size_t len,
 JSValue JS_NewArrayBufferCopy(JSContext *ctx, const uint8_t *buf, size_t len);
 void JS_DetachArrayBuffer(JSContext *ctx, JSValueConst obj);
 uint8_t *JS_GetArrayBuffer(JSContext *ctx, size_t *psize, JSValueConst obj);
+uint8_t *JS_GetArrayBufferView(JSContext *ctx, size_t *psize, JSValueConst obj);
+JSValue JS_GetArrayBufferViewBuffer(JSContext *ctx, JSValueConst obj,
+                                    size_t *pbyte_offset,
+                                    size_t *pbyte_length);
+JSValue JS_NewUint8Array(JSContext *ctx, JSValueConst buffer,
+                         size_t offset, size_t length);
 JSValue JS_GetTypedArrayBuffer(JSContext *ctx, JSValueConst obj,
                                size_t *pbyte_offset,
                                size_t *pbyte_length,
@@ -855,8 +896,20 @@ void JS_SetHostPromiseRejectionTracker(JSRuntime *rt, JSHostPromiseRejectionTrac
 /* return != 0 if the JS code needs to be interrupted */
 typedef int JSInterruptHandler(JSRuntime *rt, void *opaque);
 void JS_SetInterruptHandler(JSRuntime *rt, JSInterruptHandler *cb, void *opaque);
+/* the handler is called once every 'count' function calls and backward
+   jumps (default = 10000) */
+void JS_SetInterruptCounter(JSRuntime *rt, int count);
 /* if can_block is TRUE, Atomics.wait() can be used */
 void JS_SetCanBlock(JSRuntime *rt, JS_BOOL can_block);
+#ifdef CONFIG_PROFILE
+/* per function profile of the bytecode functions, 'clock' returns the
+   current time (e.g. the cycles consumed by the VM) */
+typedef uint64_t JSProfileClockFunc(void);
+typedef void JSProfileWriteFunc(void *opaque, const char *line);
+int JS_EnableProfile(JSRuntime *rt, JSProfileClockFunc *clock);
+/* write the report, 'write' is called once per line */
+void JS_DumpProfile(JSRuntime *rt, JSProfileWriteFunc *write, void *opaque);
+#endif
 /* set the [IsHTMLDDA] internal slot */
 void JS_SetIsHTMLDDA(JSContext *ctx, JSValueConst obj);
 
@@ -903,6 +956,10 @@ uint8_t *JS_WriteObject2(JSContext *ctx, size_t *psize, JSValueConst obj,
 #define JS_READ_OBJ_ROM_DATA  (1 << 1) /* avoid duplicating 'buf' data */
 #define JS_READ_OBJ_SAB       (1 << 2) /* allow SharedArrayBuffer */
 #define JS_READ_OBJ_REFERENCE (1 << 3) /* allow object references */
+/* like JS_READ_OBJ_ROM_DATA but the atoms are relocated inside 'buf':
+   'buf' must be writable, must outlive the runtime and can only be
+   read once */
+#define JS_READ_OBJ_IN_PLACE  (1 << 4)
 JSValue JS_ReadObject(JSContext *ctx, const uint8_t *buf, size_t buf_len,
                       int flags);
 /* instantiate and evaluate a bytecode function. Only used when
@@ -911,6 +968,11 @@ JSValue JS_EvalFunction(JSContext *ctx, JSValue fun_obj);
 /* load the dependencies of the module 'obj'. Useful when JS_ReadObject()
    returns a module. */
 int JS_ResolveModule(JSContext *ctx, JSValueConst obj);
+/* prepare the resolved module 'm' and the JS modules it imports to be
+   written as a single image. Return the number of modules stored in
+   'tab', 'm' last, or -1 if 'size' is too small. */
+int JS_PrepareModuleBundle(JSContext *ctx, JSModuleDef *m,
+                           JSModuleDef **tab, int size);
 
 /* only exported for os.Worker() */
 JSAtom JS_GetScriptOrModuleName(JSContext *ctx, int n_stack_levels);
@@ -11,21 +11,18 @@
 #include "ckb_syscall_apis.h"
 #include "my_string.h"
 #include "ckb_cell_fs.h"
+#include "molecule_module.h"
+#include "hash_module.h"
 
 /* console.log */
 static JSValue js_print(JSContext *ctx, JSValueConst this_val, int argc, JSValueConst *argv) {
     for (int i = 0; i < argc; i++) {
-        int tag = JS_VALUE_GET_TAG(argv[i]);
-        if (JS_TAG_IS_FLOAT64(tag)) {
-            double d = JS_VALUE_GET_FLOAT64(argv[i]);
-            printf("%f", d);
-        } else {
-            size_t len;
-            const char *str = JS_ToCStringLen(ctx, &len, argv[i]);
-            if (!str) return JS_EXCEPTION;
-            ckb_debug(str);
-            JS_FreeCString(ctx, str);
-        }
+        /* numbers are printed as in JS, with the shortest digits */
+        size_t len;
+        const char *str = JS_ToCStringLen(ctx, &len, argv[i]);
+        if (!str) return JS_EXCEPTION;
+        ckb_debug(str);
+        JS_FreeCString(ctx, str);
     }
     return JS_UNDEFINED;
 }
@@ -111,6 +108,66 @@ int js_module_set_import_meta(JSContext *ctx, JSValueConst func_val, JS_BOOL use
     return 0;
 }
 
+JS_BOOL js_is_bytecode(const uint8_t *buf, size_t buf_len) {
+    return buf_len > 0 && (buf[0] == (uint8_t)BC_VERSION || buf[0] == BC_READ_IN_PLACE);
+}
+
+// Bytecode is read in place: the functions keep pointing into 'buf' instead of copying their bytecode and line
+// number tables. This is safe because every bytecode buffer comes from the code cell or the file system loaded by
+// run_from_cell_data()/run_from_local_file(), whose stack frame outlives the script, and the runtime is never freed.
+// The atoms are relocated inside 'buf', so a buffer can't be read twice: the version byte is overwritten to report
+// a second load of the same file (e.g. "a.js" falling back to "a.bc" and "a.bc") instead of reading garbage.
+JSValue js_read_bytecode(JSContext *ctx, const uint8_t *buf, size_t buf_len) {
+    if (buf[0] == BC_READ_IN_PLACE) {
+        return JS_ThrowReferenceError(ctx, "bytecode already loaded under another name");
+    }
+    JSValue val = JS_ReadObject(ctx, buf, buf_len, JS_READ_OBJ_BYTECODE | JS_READ_OBJ_IN_PLACE);
+    ((uint8_t *)buf)[0] = BC_READ_IN_PLACE;
+    return val;
+}
+
+JS_BOOL js_is_bundle(const uint8_t *buf, size_t buf_len) { return buf_len > 0 && buf[0] == BC_BUNDLE; }
+
+// The modules are read in place like any bytecode. All of them are loaded before the main module is resolved, which
+// then finds its imports among the loaded modules: the module loader and the file system are not involved.
+JSValue js_read_bundle(JSContext *ctx, const uint8_t *buf, size_t buf_len) {
+    uint32_t count, len;
+    size_t pos = 5;
+    JSValue val;
+
+    if (buf_len < pos) goto invalid;
+    count = get_u32(buf + 1);
+    if (count == 0) goto invalid;
+    for (uint32_t i = 0; i < count; i++) {
+        if (buf_len - pos < 4) goto invalid;
+        len = get_u32(buf + pos);
+        pos += 4;
+        if (len == 0 || buf_len - pos < len) goto invalid;
+        val = js_read_bytecode(ctx, buf + pos, len);
+        if (JS_IsException(val)) return val;
+        if (JS_VALUE_GET_TAG(val) != JS_TAG_MODULE) {
+            JS_FreeValue(ctx, val);
+            goto invalid;
+        }
+        pos += len;
+        if (i == count - 1) return val;
+        js_module_set_import_meta(ctx, val, TRUE, FALSE);
+        // the module is referenced by the context
+        JS_FreeValue(ctx, val);
+    }
+invalid:
+    return JS_ThrowSyntaxError(ctx, "invalid bytecode bundle");
+}
+
+// Native modules, created when they are first imported
+static const struct {
+    const char *name;
+    JSModuleDef *(*new_module)(JSContext *ctx, const char *module_name);
+} js_native_modules[] = {
+    {"molecule", js_new_module_molecule},
+    {"hash", js_new_module_hash},
+};
+
 JSModuleDef *js_module_loader(JSContext *ctx, const char *module_name, void *opaque) {
     JSModuleDef *m;
 
@@ -118,6 +175,11 @@ JSModuleDef *js_module_loader(JSContext *ctx, const char *module_name, void *opa
     uint8_t *buf;
     JSValue func_val;
 
+    for (int i = 0; i < countof(js_native_modules); i++) {
+        if (strcmp(module_name, js_native_modules[i].name) == 0) {
+            return js_native_modules[i].new_module(ctx, module_name);
+        }
+    }
     buf = js_load_file(ctx, &buf_len, module_name);
     if (!buf) {
         if (strlen(module_name) <= 3) {
@@ -138,11 +200,13 @@ JSModuleDef *js_module_loader(JSContext *ctx, const char *module_name, void *opa
         }
     }
 
-    if (((const char *)buf)[0] == (char)BC_VERSION) {
-        func_val = JS_ReadObject(ctx, buf, buf_len, JS_READ_OBJ_BYTECODE);
+    if (js_is_bytecode(buf, buf_len)) {
+        func_val = js_read_bytecode(ctx, buf, buf_len);
     } else {
         /* compile the module */
-        func_val = JS_Eval(ctx, (char *)buf, buf_len, module_name, JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY);
+        int eval_flags = JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY;
+        if (opaque) eval_flags |= *(int *)opaque;
+        func_val = JS_Eval(ctx, (char *)buf, buf_len, module_name, eval_flags);
     }
 
     // js_free(ctx, buf);
@@ -8,8 +8,21 @@
 void js_std_add_helpers(JSContext *ctx, int argc, const char *argv[]);
 uint8_t *js_load_file(JSContext *ctx, size_t *pbuf_len, const char *filename);
 int js_module_set_import_meta(JSContext *ctx, JSValueConst func_val, JS_BOOL use_realpath, JS_BOOL is_main);
+// 'opaque' may point to an int of additional JS_EVAL_FLAG_* used to compile the modules.
 JSModuleDef *js_module_loader(JSContext *ctx, const char *module_name, void *opaque);
 
+// First byte of a bytecode buffer that has already been read by js_read_bytecode()
+#define BC_READ_IN_PLACE 0xff
+JS_BOOL js_is_bytecode(const uint8_t *buf, size_t buf_len);
+JSValue js_read_bytecode(JSContext *ctx, const uint8_t *buf, size_t buf_len);
+
+// First byte of a bundle, the bytecode of a whole module graph written by `-c -f`. It is followed by the number of
+// modules, then the length and the bytecode of each module, the main module last. Integers are 32-bit little-endian.
+#define BC_BUNDLE 0xfe
+JS_BOOL js_is_bundle(const uint8_t *buf, size_t buf_len);
+// Read all the modules of a bundle and return the main module.
+JSValue js_read_bundle(JSContext *ctx, const uint8_t *buf, size_t buf_len);
+
 static int js_module_dummy_init(JSContext *ctx, JSModuleDef *m);
 JSModuleDef *js_module_dummy_loader(JSContext *ctx, const char *module_name, void *opaque);
 
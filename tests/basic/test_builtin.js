@@ -336,6 +336,35 @@ function test_number()
     assert(Number.isNaN(Number("-")));
     assert(Number.isNaN(Number("\x00a")));
 
+    assert(String(0.1 + 0.2), "0.30000000000000004");
+    assert(String(1 / 3), "0.3333333333333333");
+    assert(String(-123.456), "-123.456");
+    assert(String(1e21), "1e+21");
+    assert(String(-1e100), "-1e+100");
+    assert(String(2 ** -20), "9.5367431640625e-7");
+    assert(String(0.000001), "0.000001");
+    assert(String(Number.MAX_VALUE), "1.7976931348623157e+308");
+    assert(String(Number.MIN_VALUE), "5e-324");
+    assert(String(2 ** 1000), "1.0715086071862673e+301");
+    assert((1.5).toExponential(), "1.5e+0");
+    assert((0).toExponential(), "0e+0");
+    assert(`${Math.PI}`, "3.141592653589793");
+    assert(JSON.stringify([0.5, 1e21, -0.1]), "[0.5,1e+21,-0.1]");
+
+    assert(0.1 + 0.2, 0.30000000000000004);
+    assert(String(2.5e-7), "2.5e-7");
+    assert(String(1e-7), "1e-7");
+    assert(String(parseFloat("123.456e-3")), "0.123456");
+    assert(Number("9007199254740993"), 9007199254740992);
+    assert(String(Number("123456789012345678901234567890")), "1.2345678901234568e+29");
+    assert(Number("0.1000000000000000055511151231257827021181583404541015625"), 0.1);
+    assert(String(Number("2.2250738585072011e-308")), "2.225073858507201e-308");
+    assert(Number("2.4703282292062328e-324"), Number.MIN_VALUE);
+    assert(Number("2.4703282292062327e-324"), 0);
+    assert(Number("1.7976931348623158e308"), Number.MAX_VALUE);
+    assert(Number("1.7976931348623159e308"), Infinity);
+    assert(String(JSON.parse("[1e-7, 6100000000.5]")), "1e-7,6100000000.5");
+
     // TODO:
     // assert((25).toExponential(0), "3e+1");
     // assert((-25).toExponential(0), "-3e+1");
@@ -0,0 +1,82 @@
+"use strict";
+
+/* ckb.gc, ckb.set_gc_threshold and ckb.gc_stats */
+
+function assert(actual, expected, message) {
+    if (arguments.length == 1)
+        expected = true;
+
+    if (actual === expected)
+        return;
+
+    throw Error("assertion failed: got |" + actual + "|" +
+                ", expected |" + expected + "|" +
+                (message ? " (" + message + ")" : ""));
+}
+
+function assert_throws(expected_error, func, message)
+{
+    var err = false;
+    try {
+        func();
+    } catch(e) {
+        err = true;
+        if (!(e instanceof expected_error))
+            throw Error("unexpected exception type: " + e + (message ? " (" + message + ")" : ""));
+    }
+    if (!err)
+        throw Error("expected exception" + (message ? " (" + message + ")" : ""));
+}
+
+/* objects only freed by the cycle collector */
+function make_cycles(n)
+{
+    for (var i = 0; i < n; i++) {
+        var a = { name: "a" + i };
+        var b = { other: a };
+        a.other = b;
+    }
+}
+
+function test_collect()
+{
+    ckb.gc();
+    var before = ckb.gc_stats();
+    make_cycles(100);
+    ckb.gc({ mode: "collect" });
+    var after = ckb.gc_stats();
+    assert(after.count, before.count + 1);
+    assert(after.freed - before.freed >= 200, true, "freed");
+    assert(after.scanned > before.scanned, true, "scanned");
+    assert(after.cycles > before.cycles, true, "cycles");
+}
+
+function test_never()
+{
+    ckb.gc({ mode: "never" });
+    assert(ckb.gc_stats().threshold, -1);
+    var before = ckb.gc_stats();
+    make_cycles(5000);
+    assert(ckb.gc_stats().count, before.count);
+
+    ckb.gc({ mode: "auto" });
+    assert(ckb.gc_stats().threshold, 256 * 1024);
+    make_cycles(5000);
+    assert(ckb.gc_stats().count > before.count, true, "auto");
+}
+
+function test_threshold()
+{
+    ckb.set_gc_threshold(1);
+    var before = ckb.gc_stats();
+    make_cycles(1);
+    assert(ckb.gc_stats().count > before.count, true, "threshold");
+    ckb.gc({ mode: "auto" });
+
+    assert_throws(RangeError, () => ckb.set_gc_threshold(-1));
+    assert_throws(RangeError, () => ckb.gc({ mode: "sometimes" }));
+}
+
+test_collect();
+test_never();
+test_threshold();
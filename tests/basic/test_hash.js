@@ -0,0 +1,122 @@
+"use strict";
+
+function assert(actual, expected, message) {
+    if (arguments.length == 1)
+        expected = true;
+
+    if (actual === expected)
+        return;
+
+    throw Error("assertion failed: got |" + actual + "|" +
+                ", expected |" + expected + "|" +
+                (message ? " (" + message + ")" : ""));
+}
+
+function assert_throws(expected_error, func, message)
+{
+    var err = false;
+    try {
+        func();
+    } catch(e) {
+        err = true;
+        if (!(e instanceof expected_error))
+            throw Error("unexpected exception type: " + e + (message ? " (" + message + ")" : ""));
+    }
+    if (!err)
+        throw Error("expected exception" + (message ? " (" + message + ")" : ""));
+}
+
+function hex(buf)
+{
+    var u8 = new Uint8Array(buf);
+    var s = "";
+    for(var i = 0; i < u8.length; i++)
+        s += (u8[i] < 16 ? "0" : "") + u8[i].toString(16);
+    return s;
+}
+
+/* 1000 bytes, longer than a block of every hash */
+function long_data()
+{
+    var u8 = new Uint8Array(1000);
+    for(var i = 0; i < u8.length; i++)
+        u8[i] = (i * 7) & 0xff;
+    return u8;
+}
+
+/* hash data in chunks of different sizes, from different kinds of views */
+function hash_chunks(hasher, u8)
+{
+    var sizes = [1, 63, 64, 65, 127, 128, 136, 3];
+    var pos = 0;
+    for(var i = 0; pos < u8.length; i++) {
+        var n = Math.min(sizes[i % sizes.length], u8.length - pos);
+        if (i % 3 == 0)
+            hasher.update(u8.subarray(pos, pos + n));
+        else if (i % 3 == 1)
+            hasher.update(new DataView(u8.buffer, pos, n));
+        else
+            hasher.update(u8.buffer.slice(pos, pos + n));
+        pos += n;
+    }
+    return hex(hasher.finalize());
+}
+
+var VECTORS = {
+    ckbhash: [
+        "44f4c69744d5f8c55d642062949dcae49bc4e7ef43d388c5a12f42b5633d163e",
+        "8cad3fe703916419f12f63279bef8ae75e00cb186d7fa6b556c79a245c6098d0",
+    ],
+    sha256: [
+        "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+        "89f4ff56a25dd1db06a4ce6033603775d705fb96f30f8693733fef602a1ca532",
+    ],
+    keccak256: [
+        "c5d2460186f7233c927e7db2dcc703c0e500b653ca82273b7bfad8045d85a470",
+        "82bc59cea7b5eac6d5e84cfabd1450ecba233bc6c0b375bda57dd7848a088ce6",
+    ],
+};
+
+function test_vectors()
+{
+    for (var name in VECTORS) {
+        assert(hex(hash[name]().finalize()), VECTORS[name][0], name);
+        assert(hex(hash[name]().update(long_data()).finalize()), VECTORS[name][1], name);
+        assert(hash_chunks(hash[name](), long_data()), VECTORS[name][1], name);
+    }
+    assert(hex(hash.sha256().update("abc").finalize()),
+           "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    assert(hex(hash.keccak256().update("abc").finalize()),
+           "4e03657aea45a94fc7d47ba826c8d667c0d1e6e33a64a036ec44f58fa12d6c45");
+}
+
+function test_blake2b()
+{
+    var h = hash.blake2b(64);
+    assert(h.digest_size, 64);
+    assert(hex(h.update("abc").finalize()),
+           "ba80a53f981c4d0d6a2797b69f12f6e94c212f14685ac4b74b12bb6fdbffa2d1" +
+           "7d87c5392aab792dc252d5de4533cc9518d38aa8dbf1925ab92386edd4009923");
+    /* ckbhash is blake2b-256 with the CKB personalization */
+    assert(hex(hash.blake2b(32, "ckb-default-hash").finalize()), VECTORS.ckbhash[0]);
+    var personal = new Uint8Array(16);
+    personal.set([0x63, 0x6b, 0x62, 0x2d, 0x64, 0x65, 0x66, 0x61, 0x75, 0x6c, 0x74, 0x2d, 0x68, 0x61, 0x73, 0x68]);
+    assert(hex(hash.blake2b(32, personal).finalize()), VECTORS.ckbhash[0]);
+    assert_throws(RangeError, () => hash.blake2b(65));
+    assert_throws(RangeError, () => hash.blake2b(0));
+    assert_throws(RangeError, () => hash.blake2b(32, "a personalization too long"));
+}
+
+function test_errors()
+{
+    var h = hash.ckbhash();
+    h.finalize();
+    assert_throws(TypeError, () => h.update(new Uint8Array(1)));
+    assert_throws(TypeError, () => h.finalize());
+    assert_throws(TypeError, () => hash.sha256().update(1));
+    assert_throws(TypeError, () => hash.sha256().update.call({}, "abc"));
+}
+
+test_vectors();
+test_blake2b();
+test_errors();
@@ -0,0 +1,153 @@
+"use strict";
+
+/* The property accesses below run many times from the same instruction,
+   so that they go through the inline caches, while the objects change. */
+
+function assert(actual, expected, message) {
+    if (arguments.length == 1)
+        expected = true;
+
+    if (actual === expected)
+        return;
+
+    throw Error("assertion failed: got |" + actual + "|" +
+                ", expected |" + expected + "|" +
+                (message ? " (" + message + ")" : ""));
+}
+
+function assert_throws(expected_error, func, message)
+{
+    var err = false;
+    try {
+        func();
+    } catch(e) {
+        err = true;
+        if (!(e instanceof expected_error))
+            throw Error("unexpected exception type: " + e + (message ? " (" + message + ")" : ""));
+    }
+    if (!err)
+        throw Error("expected exception" + (message ? " (" + message + ")" : ""));
+}
+
+function get_x(o) { return o.x; }
+function get_el(o, k) { return o[k]; }
+function put_x(o, v) { o.x = v; }
+
+function test_get_field()
+{
+    var o = { x: 1, y: 2 };
+    var i;
+    for(i = 0; i < 10; i++)
+        assert(get_x(o), 1);
+    o.x = 3;
+    assert(get_x(o), 3);
+    /* same shape, other object */
+    assert(get_x({ x: 4, y: 5 }), 4);
+    delete o.x;
+    assert(get_x(o), undefined);
+    Object.defineProperty(o, "x", { get: function() { return 6; }, configurable: true });
+    assert(get_x(o), 6);
+    /* arrays and primitive values */
+    assert(get_x([1, 2]), undefined);
+    assert(get_el([1, 2], "length"), 2);
+    assert(get_x(1), undefined);
+    assert_throws(TypeError, () => get_x(undefined));
+}
+
+function test_prototype()
+{
+    var proto = { x: 1 };
+    var o1 = Object.create(proto);
+    var o2 = Object.create(o1);
+    var i;
+    for(i = 0; i < 10; i++) {
+        assert(get_x(o1), 1);
+        assert(get_x(o2), 1);
+    }
+    proto.x = 2;
+    assert(get_x(o2), 2);
+    /* shadowing property in the object and in the middle of the chain */
+    o1.x = 3;
+    assert(get_x(o2), 3);
+    delete o1.x;
+    assert(get_x(o2), 2);
+    Object.setPrototypeOf(o1, { x: 4 });
+    assert(get_x(o2), 4);
+    assert(get_x(o1), 4);
+    /* getter in the prototype */
+    var p = { get x() { return this.y; } };
+    var o3 = Object.create(p);
+    o3.y = 5;
+    for(i = 0; i < 10; i++)
+        assert(get_x(o3), 5);
+}
+
+function test_put_field()
+{
+    var o = { x: 1 };
+    var i;
+    for(i = 0; i < 10; i++)
+        put_x(o, i);
+    assert(o.x, 9);
+    Object.defineProperty(o, "x", { writable: false });
+    assert_throws(TypeError, () => put_x(o, 10));
+    assert(o.x, 9);
+    var o2 = { x: 1 };
+    Object.freeze(o2);
+    assert_throws(TypeError, () => put_x(o2, 10));
+    /* setter in a prototype, then data property in the object */
+    var log = [];
+    var o3 = Object.create({ set x(v) { log.push(v); } });
+    put_x(o3, 1);
+    put_x(o3, 2);
+    assert(log.join(), "1,2");
+    assert(Object.getOwnPropertyNames(o3).length, 0);
+    Object.defineProperty(o3, "x", { value: 0, writable: true });
+    put_x(o3, 3);
+    assert(o3.x, 3);
+    assert(log.join(), "1,2");
+    /* array length is not a plain data property */
+    for(i = 0; i < 10; i++) {
+        var b = [1, 2, 3];
+        b.length = 1;
+        assert(b.length, 1);
+    }
+}
+
+function test_get_array_el()
+{
+    var o = { a: 1, b: 2 };
+    var keys = ["a", "b", "a", "b"];
+    var i;
+    for(i = 0; i < 10; i++)
+        assert(get_el(o, keys[i & 3]), (i & 1) + 1);
+    o.a = 3;
+    assert(get_el(o, "a"), 3);
+    /* typed arrays have exotic behaviors for the numeric strings */
+    var ta = new Uint8Array(4);
+    ta[1] = 7;
+    assert(get_el(ta, "1"), 7);
+    assert(get_el(ta, "1.5"), undefined);
+    assert(get_el([5, 6], "1"), 6);
+    assert(get_el({ "1.5": 8 }, "1.5"), 8);
+    /* string keys that are not atoms */
+    var k = "a" + String(i);
+    o[k] = 9;
+    assert(get_el(o, k), 9);
+    assert(get_el("abc", "length"), 3);
+}
+
+function test_polymorphic()
+{
+    var objs = [{ x: 1 }, { y: 2, x: 3 }, { z: 0, y: 2, x: 5 }, [], new Proxy({ x: 7 }, {})];
+    var i, s = 0;
+    for(i = 0; i < 200; i++)
+        s += get_x(objs[i % objs.length]) | 0;
+    assert(s, 40 * (1 + 3 + 5 + 7));
+}
+
+test_get_field();
+test_prototype();
+test_put_field();
+test_get_array_el();
+test_polymorphic();
@@ -0,0 +1,64 @@
+"use strict";
+
+function assert(actual, expected, message) {
+    if (arguments.length == 1)
+        expected = true;
+
+    if (actual === expected)
+        return;
+
+    throw Error("assertion failed: got |" + actual + "|" +
+                ", expected |" + expected + "|" +
+                (message ? " (" + message + ")" : ""));
+}
+
+/* cycles spent on the first access of a global, i.e. creating the
+   lazily installed intrinsic */
+function measure(name, f)
+{
+    var start = ckb.current_cycles();
+    f();
+    console.log(name + " " + (ckb.current_cycles() - start));
+}
+
+function test_primitive_first()
+{
+    /* BigFloat values work before the BigFloat global is touched */
+    var a = 1.5l;
+    assert((a + 1.5l).toString(), "3");
+    assert(typeof a, "bigfloat");
+    assert(Object(a) instanceof BigFloat);
+}
+
+function test_props()
+{
+    var names = [ "Date", "Proxy", "Map", "Set", "WeakMap", "WeakSet",
+                  "BigFloat", "BigFloatEnv", "BigDecimal", "Operators" ];
+    for(var i = 0; i < names.length; i++) {
+        var d = Object.getOwnPropertyDescriptor(globalThis, names[i]);
+        assert(typeof d.value, "function", names[i]);
+        assert(d.writable && d.configurable && !d.enumerable, true, names[i]);
+        assert(d.value.name, names[i]);
+    }
+}
+
+function test_usage()
+{
+    var m = new Map([[1, 2]]);
+    assert(m.get(1), 2);
+    assert(new Set([1, 1]).size, 1);
+    var p = new Proxy({}, { get: function() { return 3; } });
+    assert(p.x, 3);
+    assert(typeof Date.prototype, "object");
+    assert(BigDecimal("0.1") + BigDecimal("0.2") == BigDecimal("0.3"));
+}
+
+measure("eager global (Object):", function() { return Object; });
+measure("Date:", function() { return Date; });
+measure("Proxy:", function() { return Proxy; });
+measure("Map, Set, WeakMap, WeakSet:", function() { return Map; });
+measure("Set (already created):", function() { return Set; });
+test_primitive_first();
+measure("BigFloat, BigDecimal, Operators (already created):", function() { return BigFloat; });
+test_props();
+test_usage();
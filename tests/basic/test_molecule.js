@@ -0,0 +1,229 @@
+"use strict";
+
+function assert(actual, expected, message) {
+    if (arguments.length == 1)
+        expected = true;
+
+    if (actual === expected)
+        return;
+
+    throw Error("assertion failed: got |" + actual + "|" +
+                ", expected |" + expected + "|" +
+                (message ? " (" + message + ")" : ""));
+}
+
+function assert_throws(expected_error, func, message)
+{
+    var err = false;
+    try {
+        func();
+    } catch(e) {
+        err = true;
+        if (!(e instanceof expected_error))
+            throw Error("unexpected exception type: " + e + (message ? " (" + message + ")" : ""));
+    }
+    if (!err)
+        throw Error("expected exception" + (message ? " (" + message + ")" : ""));
+}
+
+/* molecule encoding helpers */
+
+function u32(n)
+{
+    return [n & 0xff, (n >>> 8) & 0xff, (n >>> 16) & 0xff, (n >>> 24) & 0xff];
+}
+
+function u64(n)
+{
+    return u32(n).concat([0, 0, 0, 0]);
+}
+
+function fill(n, v)
+{
+    var a = [];
+    for(var i = 0; i < n; i++)
+        a.push(v);
+    return a;
+}
+
+function bytes(a)
+{
+    return u32(a.length).concat(a);
+}
+
+function fixvec(items)
+{
+    return [].concat(u32(items.length), ...items);
+}
+
+function table(fields)
+{
+    var header_size = 4 * (fields.length + 1);
+    var offsets = [];
+    var total = header_size;
+    for(var i = 0; i < fields.length; i++) {
+        offsets = offsets.concat(u32(total));
+        total += fields[i].length;
+    }
+    return [].concat(u32(total), offsets, ...fields);
+}
+
+function buffer(a)
+{
+    return new Uint8Array(a).buffer;
+}
+
+function hex(u8)
+{
+    var s = "";
+    for(var i = 0; i < u8.length; i++)
+        s += (u8[i] < 16 ? "0" : "") + u8[i].toString(16);
+    return s;
+}
+
+function script(code_hash_byte, hash_type, args)
+{
+    return table([fill(32, code_hash_byte), [hash_type], bytes(args)]);
+}
+
+function test_script()
+{
+    var buf = buffer(script(0x11, 1, [1, 2, 3]));
+    var s = molecule.Script(buf);
+    assert(s instanceof molecule.Script);
+    assert(s.buffer, buf);
+    assert(s.byte_length, buf.byteLength);
+    assert(hex(s.code_hash.bytes()), hex(fill(32, 0x11)));
+    assert(s.hash_type, 1);
+    assert(hex(s.args.bytes()), "010203");
+    /* the args are not copied */
+    assert(s.args.buffer, buf);
+    assert(s.args.byte_offset, buf.byteLength - 3);
+    var view = s.args.bytes();
+    assert(view.buffer, buf);
+    view[0] = 9;
+    assert(s.args.u8(0), 9);
+
+    /* a script with an additional field is only accepted in compatible mode */
+    var extended = table([fill(32, 0), [0], bytes([]), [7]]);
+    assert_throws(TypeError, () => molecule.Script(buffer(extended)));
+    assert(molecule.Script(buffer(extended), true).args.byte_length, 0);
+
+    assert_throws(TypeError, () => molecule.Script(buffer([1, 2, 3])));
+    assert_throws(TypeError, () => molecule.Script(buffer(table([fill(31, 0), [0], bytes([])]))));
+    assert_throws(TypeError, () => molecule.Script("not a buffer"));
+    assert(molecule.Script.prototype.constructor, molecule.Script);
+    assert(Object.getPrototypeOf(molecule.Script.prototype), molecule.cursor.prototype);
+    assert_throws(TypeError, () => molecule.cursor.prototype.bytes.call({}));
+}
+
+function test_witness_args()
+{
+    var w = molecule.WitnessArgs(buffer(table([bytes(fill(65, 0xaa)), [], bytes([5])])));
+    assert(w.lock.byte_length, 65);
+    assert(w.lock.u8(64), 0xaa);
+    assert(w.input_type, undefined);
+    assert(hex(w.output_type.bytes()), "05");
+
+    /* a typed cursor can also be created from a TypedArray */
+    var u8 = new Uint8Array([0xff].concat(table([[], [], []])));
+    w = molecule.WitnessArgs(u8.subarray(1));
+    assert(w.byte_offset, 1);
+    assert(w.lock, undefined);
+}
+
+function test_cell_output()
+{
+    var lock = script(0x22, 0, [4]);
+    var type = script(0x33, 2, []);
+    var o = molecule.CellOutput(buffer(table([u64(1000), lock, type])));
+    assert(o.capacity, 1000n);
+    assert(o.lock instanceof molecule.Script);
+    assert(o.lock.code_hash.u8(31), 0x22);
+    assert(o.type.hash_type, 2);
+    o = molecule.CellOutput(buffer(table([u64(1), lock, []])));
+    assert(o.type, undefined);
+}
+
+function test_transaction()
+{
+    var out_point = fill(32, 0x44).concat(u32(3));
+    var cell_dep = out_point.concat([1]);
+    var input = u64(7).concat(out_point);
+    var output = table([u64(100), script(0x55, 1, []), []]);
+    var raw = table([u32(0), fixvec([cell_dep]), fixvec([fill(32, 0x66)]), fixvec([input, input]),
+                     table([output]), table([bytes([8, 9])])]);
+    var tx = molecule.Transaction(buffer(table([raw, table([bytes([1]), bytes([])])])));
+
+    assert(tx.raw.version, 0);
+    assert(tx.raw.cell_deps.length, 1);
+    var dep = tx.raw.cell_deps.get(0);
+    assert(dep.dep_type, 1);
+    assert(dep.out_point.index, 3);
+    assert(dep.out_point.tx_hash.u8(0), 0x44);
+    assert(tx.raw.header_deps.get(0).u8(31), 0x66);
+    assert(tx.raw.inputs.length, 2);
+    assert(tx.raw.inputs.get(1).since, 7n);
+    assert(tx.raw.inputs.get(1).previous_output.index, 3);
+    assert(tx.raw.outputs.get(0).capacity, 100n);
+    assert(tx.raw.outputs.get(0).lock.code_hash.u8(0), 0x55);
+    assert(hex(tx.raw.outputs_data.get(0).bytes()), "0809");
+    assert(tx.witnesses.length, 2);
+    assert(hex(tx.witnesses.get(0).bytes()), "01");
+    assert(tx.witnesses.get(1).byte_length, 0);
+    assert_throws(RangeError, () => tx.witnesses.get(2));
+
+    /* an invalid item deep in the transaction is rejected */
+    var bad = table([u32(0), fixvec([]), fixvec([]), fixvec([]), table([table([u64(1)])]), table([])]);
+    assert_throws(TypeError, () => molecule.Transaction(buffer(table([bad, table([])]))));
+}
+
+function test_cursor()
+{
+    var buf = buffer(table([u32(5), fixvec([[1, 2], [3, 4]]), table([bytes([6]), [7]])]));
+    var c = molecule.cursor(buf);
+    c.verify_table(3);
+    assert_throws(TypeError, () => c.verify_table(2));
+    c.verify_table(2, true);
+    assert(c.field_count(), 3);
+    assert(c.field(0).u32(0), 5);
+    var v = c.field(1);
+    v.verify_fixvec(2);
+    assert(v.fixvec_length(2), 2);
+    assert(hex(v.fixvec(1, 2).bytes()), "0304");
+    assert_throws(TypeError, () => v.verify_fixvec(3));
+    var d = c.field(2);
+    d.verify_dynvec();
+    assert(d.dynvec_length(), 2);
+    assert(hex(d.dynvec(0).raw().bytes()), "06");
+    assert(d.dynvec(1).u8(0), 7);
+    assert_throws(RangeError, () => d.dynvec(2));
+    assert_throws(RangeError, () => d.dynvec(1).u32(0));
+    assert(d.dynvec(1).slice(1).byte_length, 0);
+    d.dynvec(1).verify_size(1);
+
+    var s = molecule.cursor(c, 4, 8);
+    assert(s.byte_offset, 4);
+    assert(s.u32(4), 20);
+    assert_throws(RangeError, () => molecule.cursor(c, 4, c.byte_length));
+
+    var u = molecule.cursor(buffer(u32(1).concat([9])));
+    assert(u.union().id, 1);
+    assert(u.union().item.u8(0), 9);
+    assert(molecule.cursor(buffer([])).is_none(), true);
+
+    /* data changed after it has been verified is checked again when read */
+    var u8 = new Uint8Array(script(0, 0, [1]));
+    var sc = molecule.Script(u8);
+    u8[12] = 0xff;
+    assert_throws(TypeError, () => sc.args);
+
+    var getter = Object.getOwnPropertyDescriptor(molecule.Script.prototype, "args").get;
+    assert_throws(TypeError, () => getter.call(c));
+}
+
+test_script();
+test_witness_args();
+test_cell_output();
+test_transaction();
+test_cursor();
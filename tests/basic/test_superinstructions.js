@@ -0,0 +1,126 @@
+"use strict";
+
+/* The code below is written so that resolve_labels() fuses the opcode
+   pairs, the results must be the same as with the separate opcodes. */
+
+function assert(actual, expected, message) {
+    if (arguments.length == 1)
+        expected = true;
+
+    if (actual === expected)
+        return;
+
+    throw Error("assertion failed: got |" + actual + "|" +
+                ", expected |" + expected + "|" +
+                (message ? " (" + message + ")" : ""));
+}
+
+function assert_throws(expected_error, func, message)
+{
+    var err = false;
+    try {
+        func();
+    } catch(e) {
+        err = true;
+        if (!(e instanceof expected_error))
+            throw Error("unexpected exception type: " + e + (message ? " (" + message + ")" : ""));
+    }
+    if (!err)
+        throw Error("expected exception" + (message ? " (" + message + ")" : ""));
+}
+
+function count(a, b)
+{
+    var n = 0;
+    if (a < b) n |= 1;
+    if (a <= b) n |= 2;
+    if (a > b) n |= 4;
+    if (a >= b) n |= 8;
+    return n;
+}
+
+function test_compare()
+{
+    assert(count(1, 2), 3);
+    assert(count(2, 2), 10);
+    assert(count(3, 2), 12);
+    assert(count(1.5, 2), 3);
+    assert(count(2, 1.5), 12);
+    assert(count(NaN, 1), 0);
+    assert(count(1, NaN), 0);
+    assert(count("a", "b"), 3);
+    assert(count("10", "9"), 3);
+    assert(count("10", 9), 12);
+    assert(count(1n, 2), 3);
+    assert(count(undefined, 0), 0);
+    assert(count(null, 0), 10);
+    var log = [];
+    var a = { valueOf() { log.push("a"); return 1; } };
+    var b = { valueOf() { log.push("b"); return 2; } };
+    assert(count(a, b), 3);
+    assert(log.join(""), "abababab");
+    assert_throws(TypeError, () => count(Symbol(), 1));
+}
+
+function test_loops()
+{
+    var i, j, s;
+    s = 0;
+    for(i = 0; i < 10; i++)
+        s += i;
+    assert(s, 45);
+    s = 0;
+    for(i = 10; i > 0; i--)
+        s += i;
+    assert(s, 55);
+    /* a body too long for the 8 bit jumps */
+    s = 0;
+    for(i = 0; i < 10; i++) {
+        s += i * 2 + 1; s += i * 3 + 2; s += i * 4 + 3; s += i * 5 + 4;
+        s += i * 6 + 5; s += i * 7 + 6; s += i * 8 + 7; s += i * 9 + 8;
+        s += i * 10 + 9; s += i * 11 + 10; s += i * 12 + 11; s += i * 13 + 12;
+        s += i * 14 + 13; s += i * 15 + 14; s += i * 16 + 15; s += i * 17 + 16;
+    }
+    assert(s, 8200);
+    /* the loop variable leaves the int32 range or is not a number */
+    s = 0;
+    for(i = 0x7ffffffe; i < 0x80000001; i++)
+        s++;
+    assert(s, 3);
+    assert(i, 0x80000001);
+    s = "";
+    for(i = "1"; i < 4; i++)
+        s += i;
+    assert(s, "123");
+    s = 0;
+    for(i = 0; i < 3; i++)
+        for(j = 0; j <= i; j++)
+            s++;
+    assert(s, 6);
+}
+
+function test_get_loc()
+{
+    var o = { x: 1, f() { return this.x + 1; } };
+    var a = [1, 2, 3];
+    var k = "x";
+    var i, s = 0;
+    for(i = 0; i < a.length; i++)
+        s += a[i] + o.x + o.f() + o[k];
+    assert(s, 6 + 3 * 4);
+    /* the getter replaces the local which is being read */
+    var p = { get x() { p = null; return 2; } };
+    assert(p.x, 2);
+    assert(p, null);
+    var q = { get f() { q = null; return function() { return this; }; } };
+    var r = q;
+    assert(q.f(), r);
+    assert_throws(TypeError, () => { var u; return u.x; });
+    assert_throws(TypeError, () => { var u; return u.f(); });
+    var n = null;
+    assert_throws(TypeError, () => o[n.x]);
+}
+
+test_compare();
+test_loops();
+test_get_loc();
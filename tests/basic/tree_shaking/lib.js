@@ -0,0 +1,9 @@
+/* tree shaking: main.js only imports used_export, so the bundle has no entry for unused_export */
+export function used_export(n) {
+    return n * 2;
+}
+
+function helper(n) {
+    return n + 1;
+}
+export { helper as unused_export };
@@ -0,0 +1,4 @@
+import { used_export } from "./lib.js";
+
+if (used_export(21) !== 42) throw Error("used_export");
+console.log("tree shaking ok");
@@ -0,0 +1,278 @@
+"use strict";
+
+/*
+ * Cycle benchmarks
+ *
+ * Every case runs a fixed number of iterations and reports the cycles it
+ * spent, measured with ckb.current_cycles(), as a line
+ *     bench <name> <cycles>
+ * Cycles are deterministic, so results can be compared exactly between
+ * builds, see compare.awk. An optional script argument only runs the cases
+ * whose name contains it.
+ */
+
+var cases = [];
+
+function bench(name, n, f)
+{
+    cases.push({ name: name, n: n, f: f });
+}
+
+/* keep results alive so that the loops are not trivially dead */
+var sink;
+
+bench("empty_loop", 10000, function(n) {
+    for (var i = 0; i < n; i++) {
+    }
+});
+
+bench("prop_read", 10000, function(n) {
+    var o = { a: 1, b: 2, c: 3, d: 4 };
+    var s = 0;
+    for (var i = 0; i < n; i++)
+        s += o.a + o.b + o.c + o.d;
+    sink = s;
+});
+
+bench("prop_write", 10000, function(n) {
+    var o = { a: 1, b: 2, c: 3, d: 4 };
+    for (var i = 0; i < n; i++) {
+        o.a = i;
+        o.b = i;
+        o.c = i;
+        o.d = i;
+    }
+    sink = o;
+});
+
+bench("prop_polymorphic", 10000, function(n) {
+    var objs = [{ x: 1 }, { y: 2, x: 1 }, { z: 3, y: 2, x: 1 }, { w: 4, z: 3, y: 2, x: 1 }];
+    var s = 0;
+    for (var i = 0; i < n; i++)
+        s += objs[i & 3].x;
+    sink = s;
+});
+
+bench("array_read", 10000, function(n) {
+    var a = [1, 2, 3, 4, 5, 6, 7, 8];
+    var s = 0;
+    for (var i = 0; i < n; i++)
+        s += a[i & 7];
+    sink = s;
+});
+
+bench("array_push", 10000, function(n) {
+    var a = [];
+    for (var i = 0; i < n; i++)
+        a.push(i);
+    sink = a;
+});
+
+function add(a, b)
+{
+    return a + b;
+}
+
+bench("call", 10000, function(n) {
+    var s = 0;
+    for (var i = 0; i < n; i++)
+        s = add(s, i);
+    sink = s;
+});
+
+bench("method_call", 10000, function(n) {
+    class Counter {
+        constructor() { this.count = 0; }
+        inc(k) { this.count += k; }
+    }
+    var c = new Counter();
+    for (var i = 0; i < n; i++)
+        c.inc(i);
+    sink = c;
+});
+
+bench("closure", 10000, function(n) {
+    var fs = [];
+    for (var i = 0; i < n; i++) {
+        var k = i;
+        fs.push(function() { return k; });
+    }
+    var s = 0;
+    for (var i = 0; i < n; i++)
+        s += fs[i]();
+    sink = s;
+});
+
+bench("try_catch", 1000, function(n) {
+    var s = 0;
+    for (var i = 0; i < n; i++) {
+        try {
+            throw i;
+        } catch (e) {
+            s += e;
+        }
+    }
+    sink = s;
+});
+
+bench("typed_array", 10000, function(n) {
+    var a = new Uint8Array(256);
+    var s = 0;
+    for (var i = 0; i < n; i++)
+        a[i & 255] = i;
+    for (var i = 0; i < n; i++)
+        s += a[i & 255];
+    sink = s;
+});
+
+bench("data_view", 10000, function(n) {
+    var v = new DataView(new ArrayBuffer(64));
+    var s = 0;
+    for (var i = 0; i < n; i++) {
+        v.setUint32((i & 15) * 4, i, true);
+        s += v.getUint32((i & 15) * 4, true);
+    }
+    sink = s;
+});
+
+bench("bigint", 1000, function(n) {
+    var a = 0x123456789abcdefn;
+    var s = 0n;
+    for (var i = 0; i < n; i++)
+        s = (s + a * BigInt(i)) & 0xffffffffffffffffn;
+    sink = s;
+});
+
+bench("string_concat", 1000, function(n) {
+    var s = "";
+    for (var i = 0; i < n; i++)
+        s += "abc";
+    sink = s;
+});
+
+bench("string_ops", 1000, function(n) {
+    var str = "the quick brown fox jumps over the lazy dog";
+    var s = 0;
+    for (var i = 0; i < n; i++) {
+        s += str.indexOf("lazy") + str.charCodeAt(i % str.length);
+        s += str.slice(4, 9).length + str.split(" ").length;
+    }
+    sink = s;
+});
+
+bench("number_to_string", 1000, function(n) {
+    var s = 0;
+    for (var i = 0; i < n; i++)
+        s += String(i * 1.25).length + (i * 7).toString(16).length;
+    sink = s;
+});
+
+bench("float_to_string", 1000, function(n) {
+    /* not integers, so the shortest digits are searched */
+    var s = 0;
+    for (var i = 0; i < n; i++)
+        s += String(i / 7).length + JSON.stringify([i * 0.01, i * 1e-9, i * 1e300]).length;
+    sink = s;
+});
+
+bench("parse_float", 1000, function(n) {
+    var s = 0;
+    for (var i = 0; i < n; i++)
+        s += parseFloat("3.14159") + Number("12345.678");
+    sink = s;
+});
+
+bench("json_numbers", 100, function(n) {
+    var a = [];
+    for (var i = 0; i < 20; i++)
+        a.push(i * 1.1, i * 6100000000, i / 3);
+    var text = JSON.stringify(a);
+    for (var i = 0; i < n; i++)
+        sink = JSON.parse(text);
+});
+
+bench("sort", 10, function(n) {
+    for (var i = 0; i < n; i++) {
+        var a = [];
+        for (var j = 0; j < 1000; j++)
+            a.push((j * 7919) % 1009);
+        a.sort(function(x, y) { return x - y; });
+        sink = a;
+    }
+});
+
+bench("json", 100, function(n) {
+    var o = { name: "cell", capacity: 6100000000, data: [1, 2, 3, 4, 5, 6, 7, 8], lock: { args: "0x1234", hash_type: 1 } };
+    for (var i = 0; i < n; i++)
+        sink = JSON.parse(JSON.stringify(o));
+});
+
+bench("alloc_objects", 1000, function(n) {
+    /* short-lived objects, arrays and closures, freed by their reference count */
+    var s = 0;
+    for (var i = 0; i < n; i++) {
+        var o = { a: i, b: [i, i + 1], f: function() { return i; } };
+        s += o.b.length;
+    }
+    sink = s;
+});
+
+bench("alloc_tree", 10, function(n) {
+    /* objects that stay alive, of a few sizes */
+    function make(depth) {
+        if (depth == 0)
+            return { leaf: true };
+        return { left: make(depth - 1), right: make(depth - 1), name: "n" + depth };
+    }
+    for (var i = 0; i < n; i++)
+        sink = make(10);
+});
+
+bench("regexp", 1000, function(n) {
+    var re = /^0x([0-9a-f]{2})+$/i;
+    var s = 0;
+    for (var i = 0; i < n; i++)
+        s += re.test("0x" + (i * 0x10001).toString(16).padStart(8, "0")) ? 1 : 0;
+    sink = s;
+});
+
+bench("syscall_load_script", 100, function(n) {
+    for (var i = 0; i < n; i++)
+        sink = ckb.load_script();
+});
+
+bench("syscall_load_script_into", 100, function(n) {
+    var buf = new Uint8Array(1024);
+    for (var i = 0; i < n; i++)
+        sink = ckb.load_script_into(buf);
+});
+
+bench("molecule_script", 100, function(n) {
+    var data = ckb.load_script();
+    for (var i = 0; i < n; i++) {
+        var script = molecule.Script(data);
+        sink = script.args.byte_length + script.hash_type;
+    }
+});
+
+bench("ckbhash", 100, function(n) {
+    var data = new Uint8Array(1024);
+    for (var i = 0; i < n; i++)
+        sink = hash.ckbhash().update(data).finalize();
+});
+
+function main()
+{
+    var filter = typeof scriptArgs !== "undefined" && scriptArgs.length > 0 ? scriptArgs[0] : "";
+    for (var i = 0; i < cases.length; i++) {
+        var c = cases[i];
+        if (c.name.indexOf(filter) < 0)
+            continue;
+        var start = ckb.current_cycles();
+        c.f(c.n);
+        var cycles = ckb.current_cycles() - start;
+        console.log("bench " + c.name + " " + cycles);
+    }
+}
+
+main();
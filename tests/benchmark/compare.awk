@@ -0,0 +1,55 @@
+# Compare the output of bench.js with a baseline
+#
+# usage: awk -v threshold=<percent> -f compare.awk baseline.txt result.txt
+#
+# baseline.txt has a "<name> <cycles>" line per case, lines starting with '#'
+# are comments. result.txt is the output of bench.js, its "bench <name>
+# <cycles>" lines are compared with the baseline. Exits with 1 when a case
+# spends more than threshold percent cycles over its baseline, or has no
+# baseline, so that an empty or outdated baseline can't hide a regression.
+
+BEGIN {
+    if (threshold == "")
+        threshold = 2
+    printf "%-28s %14s %14s %9s\n", "case", "baseline", "cycles", "diff"
+}
+
+FNR == NR {
+    if ($0 !~ /^#/ && NF == 2)
+        baseline[$1] = $2
+    next
+}
+
+# the line may be preceded by other output of the script
+NF >= 3 && $(NF - 2) ~ /bench$/ {
+    name = $(NF - 1)
+    cycles = $NF
+    cases++
+    if (!(name in baseline) || baseline[name] == 0) {
+        printf "%-28s %14s %14.0f %9s\n", name, "-", cycles, "MISSING"
+        missing++
+        next
+    }
+    diff = (cycles - baseline[name]) * 100 / baseline[name]
+    status = ""
+    if (diff > threshold) {
+        status = "REGRESSION"
+        regressions++
+    } else if (diff < -threshold) {
+        status = "improved"
+    }
+    printf "%-28s %14.0f %14.0f %+8.2f%% %s\n", name, baseline[name], cycles, diff, status
+}
+
+END {
+    if (cases == 0) {
+        print "no case was run"
+        exit 1
+    }
+    if (missing > 0)
+        printf "%d case(s) have no baseline, record them with make bench-baseline\n", missing
+    if (regressions > 0)
+        printf "%d case(s) regressed by more than %s%%\n", regressions, threshold
+    if (missing > 0 || regressions > 0)
+        exit 1
+}
@@ -0,0 +1,23 @@
+#include <stddef.h>
+#include <stdint.h>
+
+// Adds up the bytes of every argument but the last one, and writes the sum to the last argument as a little endian
+// 64-bit integer. Returns the number of bytes added up, or -1 if the last argument has no room for the sum.
+__attribute__((visibility("default"))) int sum(size_t argc, uint8_t *argv[], size_t sizes[]) {
+    if (argc == 0 || sizes[argc - 1] < 8) {
+        return -1;
+    }
+    uint64_t total = 0;
+    int count = 0;
+    for (size_t i = 0; i + 1 < argc; i++) {
+        for (size_t j = 0; j < sizes[i]; j++) {
+            total += argv[i][j];
+        }
+        count += sizes[i];
+    }
+    uint8_t *out = argv[argc - 1];
+    for (int i = 0; i < 8; i++) {
+        out[i] = (uint8_t)(total >> (i * 8));
+    }
+    return count;
+}
@@ -89,12 +89,102 @@ function test_partial_loading_field_without_comparing(load_func, field) {
     console.log('test_partial_loading_field_without_comparing done');
 }
 
+function test_load_into(load_func) {
+    console.log('test_load_into ...');
+    let buf = new Uint8Array(12);
+    let length = load_func(buf, 2, 0, ckb.SOURCE_OUTPUT);
+    console.assert(length === 8, 'length != 8');
+    expect_array(buf.subarray(2, 10), ARRAY8);
+    // truncated to the space left in the buffer
+    length = load_func(buf.buffer, 8, 0, ckb.SOURCE_OUTPUT, 1);
+    console.assert(length === 7, 'length != 7');
+    expect_array(buf.subarray(8, 12), ARRAY8.slice(1, 5));
+    length = load_func(new DataView(buf.buffer, 0, 2), 0, 0, ckb.SOURCE_OUTPUT, 6);
+    console.assert(length === 2, 'length != 2');
+    expect_array(buf.subarray(0, 2), ARRAY8.slice(6, 8));
+
+    must_throw_exception(() => {
+        load_func(buf, 13, 0, ckb.SOURCE_OUTPUT);
+    });
+    must_throw_exception(() => {
+        load_func(1001n, 0, 0, ckb.SOURCE_OUTPUT);
+    });
+    must_throw_exception(() => {
+        load_func(buf, 0, 1001n, ckb.SOURCE_OUTPUT);
+    });
+    console.log('test_load_into done');
+}
+
+function test_load_all(load_func) {
+    console.log('test_load_all ...');
+    let ret = load_func(ckb.SOURCE_OUTPUT);
+    console.assert(ret.offsets.length === 2, 'offsets.length != 2');
+    console.assert(ret.offsets[0] === 0 && ret.offsets[1] === 8, 'offsets != [0, 8]');
+    expect_array(new Uint8Array(ret.data), ARRAY8);
+    ret = load_func(ckb.SOURCE_GROUP_OUTPUT);
+    console.assert(ret.offsets.length === 1, 'offsets.length != 1');
+    console.assert(ret.data.byteLength === 0, 'data.byteLength != 0');
+    console.log('test_load_all done');
+}
+
+function test_load_all_by_field() {
+    console.log('test_load_all_by_field ...');
+    let ret = ckb.load_all_cell_by_field(ckb.SOURCE_INPUT, ckb.CELL_FIELD_LOCK_HASH);
+    console.assert(ret.offsets.length === 2, 'offsets.length != 2');
+    console.assert(ret.data.byteLength === 32, 'data.byteLength != 32');
+    expect_array(new Uint8Array(ret.data), Array.from(new Uint8Array(ckb.load_script_hash())));
+    // the input has no type script
+    ret = ckb.load_all_cell_by_field(ckb.SOURCE_INPUT, ckb.CELL_FIELD_TYPE_HASH);
+    console.assert(ret.offsets.length === 2 && ret.offsets[1] === 0, 'type hash is not empty');
+    console.log('test_load_all_by_field done');
+}
+
+function test_hash_update_load() {
+    console.log('test_hash_update_load ...');
+    let hasher = hash.ckbhash();
+    let length = hasher.update_witness(0, ckb.SOURCE_INPUT);
+    let expected = ckb.load_witness(0, ckb.SOURCE_INPUT);
+    console.assert(length === expected.byteLength, 'length != witness length');
+    expect_array(new Uint8Array(hasher.finalize()), new Uint8Array(hash.ckbhash().update(expected).finalize()));
+    // the transaction hash is the ckbhash of the raw transaction
+    let tx = molecule.Transaction(ckb.load_transaction());
+    hasher = hash.ckbhash().update(tx.raw.bytes());
+    expect_array(new Uint8Array(hasher.finalize()), new Uint8Array(ckb.load_tx_hash()));
+    hasher = hash.sha256();
+    hasher.update_cell_data(0, ckb.SOURCE_OUTPUT, 2);
+    expect_array(new Uint8Array(hasher.finalize()),
+                 new Uint8Array(hash.sha256().update(ckb.load_cell_data(0, ckb.SOURCE_OUTPUT, 6, 2)).finalize()));
+    console.log('test_hash_update_load done');
+}
+
+// Compare the cycles spent by loading into a new ArrayBuffer and into a reused buffer
+function bench_load_into() {
+    const count = 1000;
+    let start = ckb.current_cycles();
+    for (let i = 0; i < count; i++) {
+        let data = new Uint8Array(ckb.load_cell_data(0, ckb.SOURCE_OUTPUT));
+    }
+    let cycles = ckb.current_cycles() - start;
+    console.log(`load_cell_data: ${Math.round(cycles / count)} cycles per call`);
+
+    let buf = new Uint8Array(64);
+    start = ckb.current_cycles();
+    for (let i = 0; i < count; i++) {
+        let length = ckb.load_cell_data_into(buf, 0, 0, ckb.SOURCE_OUTPUT);
+    }
+    cycles = ckb.current_cycles() - start;
+    console.log(`load_cell_data_into: ${Math.round(cycles / count)} cycles per call`);
+}
+
 function test_misc() {
     console.log('test_misc ....');
     let hash = ckb.load_tx_hash();
     console.assert(hash.byteLength == 32);
     hash = ckb.load_script_hash();
     console.assert(hash.byteLength == 32);
+    let hash2 = new Uint8Array(32);
+    console.assert(ckb.load_tx_hash_into(hash2) == 32);
+    expect_array(hash2, Array.from(new Uint8Array(ckb.load_tx_hash())));
     let version = ckb.vm_version();
     console.assert(version >= 0);
     let cycles = ckb.current_cycles();
@@ -104,6 +194,30 @@ function test_misc() {
     console.log('test_misc done');
 }
 
+function test_dlopen() {
+    console.log('test_dlopen ...');
+    // no cell dep with this code hash
+    must_throw_exception(() => ckb.dlopen(new Uint8Array(32), ckb.SCRIPT_HASH_TYPE_TYPE));
+    must_throw_exception(() => ckb.dlopen(new Uint8Array(31), ckb.SCRIPT_HASH_TYPE_TYPE));
+    must_throw_exception(() => ckb.dlsym({}, 'func'));
+
+    // test_data/dl_library.c, the 3rd cell dep in templates/syscall.json
+    let code_hash = new Uint8Array(ckb.load_cell_by_field(2, ckb.SOURCE_CELL_DEP, ckb.CELL_FIELD_TYPE_HASH));
+    let lib = ckb.dlopen(code_hash, ckb.SCRIPT_HASH_TYPE_TYPE);
+    // loaded only once
+    let lib2 = ckb.dlopen(code_hash, ckb.SCRIPT_HASH_TYPE_TYPE);
+    console.assert(ckb.dlsym(lib, 'no_such_function') === undefined);
+    let sum = ckb.dlsym(lib, 'sum');
+    console.assert(typeof sum === 'function');
+    let out = new Uint8Array(8);
+    console.assert(sum(new Uint8Array([1, 2, 3]), new Uint8Array([250, 250]).buffer, out) === 5);
+    // 1 + 2 + 3 + 250 + 250 = 0x1fa
+    expect_array(out, [0xfa, 0x01, 0, 0, 0, 0, 0, 0]);
+    console.assert(ckb.dlsym(lib2, 'sum')(new Uint8Array(4)) === -1);
+    must_throw_exception(() => sum(out, 1));
+    console.log('test_dlopen done');
+}
+
 function test_spawn() {
     console.log('test_spawn ...');
     const js_code = `
@@ -129,6 +243,12 @@ function test_spawn() {
 test_misc();
 test_partial_loading(ckb.load_witness);
 test_partial_loading(ckb.load_cell_data);
+test_load_into(ckb.load_witness_into);
+test_load_into(ckb.load_cell_data_into);
+test_load_all(ckb.load_all_witness);
+test_load_all(ckb.load_all_cell_data);
+test_load_all_by_field();
+test_hash_update_load();
 test_partial_loading_without_comparing(ckb.load_witness);
 test_partial_loading_without_comparing(ckb.load_cell_data);
 test_partial_loading_without_comparing(ckb.load_transaction);
@@ -136,6 +256,8 @@ test_partial_loading_without_comparing(ckb.load_script);
 test_partial_loading_without_comparing(ckb.load_cell);
 test_partial_loading_field_without_comparing(ckb.load_cell_by_field, ckb.CELL_FIELD_CAPACITY);
 test_partial_loading_field_without_comparing(ckb.load_input_by_field, ckb.INPUT_FIELD_OUT_POINT);
+test_dlopen();
 test_spawn();
+bench_load_into();
 
 ckb.exit(0);
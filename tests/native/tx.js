@@ -0,0 +1,140 @@
+"use strict";
+// Run by the native build with CKB_TX_FILE=tx.json, see docs/native.md. scriptArgs[0] is the script group being run:
+// "lock" for the lock script of input 0, "type" for the type script of input 1.
+
+function assert(actual, expected, message) {
+    if (arguments.length == 1)
+        expected = true;
+
+    if (actual === expected)
+        return;
+
+    throw Error("assertion failed: got |" + actual + "|" +
+                ", expected |" + expected + "|" +
+                (message ? " (" + message + ")" : ""));
+}
+
+function hex(buf)
+{
+    var u8 = new Uint8Array(buf);
+    var s = "";
+    for(var i = 0; i < u8.length; i++)
+        s += (u8[i] < 16 ? "0" : "") + u8[i].toString(16);
+    return s;
+}
+
+function u64(buf)
+{
+    return new DataView(buf).getBigUint64(0, true);
+}
+
+function ckbhash(buf)
+{
+    return hex(hash.ckbhash().update(buf).finalize());
+}
+
+function count(load, source)
+{
+    var n = 0;
+    for (;;) {
+        try {
+            load(n, source);
+        } catch (e) {
+            return n;
+        }
+        n++;
+    }
+}
+
+function fails(func)
+{
+    try {
+        func();
+    } catch (e) {
+        return true;
+    }
+    return false;
+}
+
+function test_cells()
+{
+    assert(count(ckb.load_cell, ckb.SOURCE_INPUT), 3);
+    assert(count(ckb.load_cell, ckb.SOURCE_OUTPUT), 2);
+    assert(count(ckb.load_cell, ckb.SOURCE_CELL_DEP), 1);
+    assert(count(ckb.load_witness, ckb.SOURCE_INPUT), 3);
+    assert(count(ckb.load_header, ckb.SOURCE_HEADER_DEP), 1);
+
+    assert(hex(ckb.load_cell_by_field(0, ckb.SOURCE_INPUT, ckb.CELL_FIELD_LOCK_HASH)),
+           "5b9f2352d9a497e8cd87fd0c98036a37926336b42a3c4379872c7025d282b129");
+    assert(hex(ckb.load_cell_by_field(1, ckb.SOURCE_INPUT, ckb.CELL_FIELD_DATA_HASH)),
+           "82f54af4148801b8e8848911bb6cb6bbf26f00ab26e7515cfaae2b30096e907e");
+    /* the data hash of an empty cell is zero */
+    assert(hex(ckb.load_cell_by_field(0, ckb.SOURCE_INPUT, ckb.CELL_FIELD_DATA_HASH)), "00".repeat(32));
+    assert(fails(() => ckb.load_cell_by_field(0, ckb.SOURCE_INPUT, ckb.CELL_FIELD_TYPE_HASH)));
+    assert(u64(ckb.load_cell_by_field(0, ckb.SOURCE_INPUT, ckb.CELL_FIELD_CAPACITY)), 100000000000n);
+    /* 8 bytes of capacity, 33 + 1 bytes of lock script */
+    assert(u64(ckb.load_cell_by_field(0, ckb.SOURCE_INPUT, ckb.CELL_FIELD_OCCUPIED_CAPACITY)), 4200000000n);
+    /* and 2 bytes of data, 33 bytes of type script */
+    assert(u64(ckb.load_cell_by_field(1, ckb.SOURCE_INPUT, ckb.CELL_FIELD_OCCUPIED_CAPACITY)), 7700000000n);
+
+    var output = molecule.CellOutput(ckb.load_cell(0, ckb.SOURCE_OUTPUT));
+    assert(output.capacity, 10000000000n);
+    assert(output.type.hash_type, 2);
+    assert(hex(ckb.load_cell_data(0, ckb.SOURCE_OUTPUT)), "5678");
+    assert(hex(ckb.load_cell_data(0, ckb.SOURCE_CELL_DEP)), "00010203");
+    /* partial loading */
+    assert(hex(ckb.load_cell_data(0, ckb.SOURCE_CELL_DEP, 2, 1)), "0102");
+}
+
+function test_header_and_input()
+{
+    assert(u64(ckb.load_header_by_field(0, ckb.SOURCE_HEADER_DEP, ckb.HEADER_FIELD_EPOCH_NUMBER)), 4367n);
+    assert(u64(ckb.load_header_by_field(0, ckb.SOURCE_INPUT, ckb.HEADER_FIELD_EPOCH_LENGTH)), 1800n);
+    assert(u64(ckb.load_header_by_field(0, ckb.SOURCE_INPUT, ckb.HEADER_FIELD_EPOCH_START_BLOCK_NUMBER)), 2308n);
+    assert(fails(() => ckb.load_header(1, ckb.SOURCE_INPUT)));
+    assert(fails(() => ckb.load_header(0, ckb.SOURCE_OUTPUT)));
+
+    assert(u64(ckb.load_input_by_field(1, ckb.SOURCE_INPUT, ckb.INPUT_FIELD_SINCE)), 0x2000000000000005n);
+    var out_point = new Uint8Array(ckb.load_input_by_field(2, ckb.SOURCE_INPUT, ckb.INPUT_FIELD_OUT_POINT));
+    assert(out_point.length, 36);
+    assert(out_point[0], 0x12);
+}
+
+function test_transaction()
+{
+    var buf = ckb.load_transaction();
+    var tx = molecule.Transaction(buf);
+    assert(tx.raw.inputs.length, 3);
+    assert(tx.raw.outputs.length, 2);
+    assert(tx.raw.header_deps.get(0).u8(0), 0xcc);
+    assert(tx.witnesses.length, 3);
+    /* the hash of the transaction is the one of its first field */
+    var view = new DataView(buf);
+    var raw = buf.slice(view.getUint32(4, true), view.getUint32(8, true));
+    assert(hex(ckb.load_tx_hash()), ckbhash(raw));
+}
+
+function test_script_group(group)
+{
+    assert(hex(ckb.load_script_hash()), ckbhash(ckb.load_script()));
+    var script = molecule.Script(ckb.load_script());
+    if (group == "lock") {
+        assert(script.code_hash.u8(0), 0xaa);
+        assert(count(ckb.load_cell, ckb.SOURCE_GROUP_INPUT), 2);
+        assert(count(ckb.load_cell, ckb.SOURCE_GROUP_OUTPUT), 0);
+        assert(count(ckb.load_witness, ckb.SOURCE_GROUP_INPUT), 2);
+        assert(hex(ckb.load_witness(1, ckb.SOURCE_GROUP_INPUT)), "");
+    } else {
+        assert(script.code_hash.u8(0), 0xbb);
+        assert(count(ckb.load_cell, ckb.SOURCE_GROUP_INPUT), 1);
+        assert(count(ckb.load_cell, ckb.SOURCE_GROUP_OUTPUT), 1);
+        assert(hex(ckb.load_cell_data(0, ckb.SOURCE_GROUP_INPUT)), "1234");
+        assert(hex(ckb.load_witness(0, ckb.SOURCE_GROUP_INPUT)), "");
+        assert(hex(ckb.load_witness(0, ckb.SOURCE_GROUP_OUTPUT)), "55000000");
+    }
+}
+
+test_cells();
+test_header_and_input();
+test_transaction();
+test_script_group(scriptArgs[0]);